@@ -177,6 +177,19 @@ ZMQ_EXPORT zmq_ctx_t zmq_init (int io_threads);
 ZMQ_EXPORT zmq_ctx_t zmq_init_thread_safe (int io_threads);
 ZMQ_EXPORT int zmq_term (zmq_ctx_t context);
 
+/*  Context options.                                                          */
+#define ZMQ_CTX_MEMORY_LIMIT 1
+#define ZMQ_CTX_MEMORY_USED 2
+#define ZMQ_CTX_CHUNK_CACHE 3
+#define ZMQ_CTX_CHUNK_CACHED 4
+#define ZMQ_CTX_COMMANDS_SAVED 5
+#define ZMQ_CTX_SIGNALS_SAVED 6
+
+ZMQ_EXPORT int zmq_ctx_set (zmq_ctx_t context, int option, const void *optval,
+    size_t optvallen);
+ZMQ_EXPORT int zmq_ctx_get (zmq_ctx_t context, int option, void *optval,
+    size_t *optvallen);
+
 /******************************************************************************/
 /*  0MQ socket definition.                                                    */
 /******************************************************************************/
@@ -199,6 +212,7 @@ ZMQ_EXPORT int zmq_term (zmq_ctx_t context);
 #define ZMQ_XREP ZMQ_ROUTER
 
 /*  Socket options.                                                           */
+#define ZMQ_SWAP 3
 #define ZMQ_AFFINITY 4
 #define ZMQ_IDENTITY 5
 #define ZMQ_SUBSCRIBE 6
@@ -223,6 +237,28 @@ ZMQ_EXPORT int zmq_term (zmq_ctx_t context);
 #define ZMQ_SNDTIMEO 28
 #define ZMQ_IPV4ONLY 31
 #define ZMQ_LAST_ENDPOINT 32
+#define ZMQ_CONFLATE 33
+#define ZMQ_LAST_VALUE_CACHE 34
+#define ZMQ_LB_STRATEGY 35
+#define ZMQ_FQ_WEIGHT 36
+#define ZMQ_LB_KEY_SIZE 37
+#define ZMQ_SNDHWM_BYTES 38
+#define ZMQ_RCVHWM_BYTES 39
+#define ZMQ_TTL 40
+#define ZMQ_EXPIRED 41
+#define ZMQ_COMPRESSION 42
+#define ZMQ_COMPRESSION_RAW_BYTES 43
+#define ZMQ_COMPRESSION_WIRE_BYTES 44
+#define ZMQ_SUBSCRIPTION_BATCH 45
+
+/*  Load-balancing strategies (ZMQ_LB_STRATEGY option values).                */
+#define ZMQ_LB_ROUND_ROBIN 0
+#define ZMQ_LB_LEAST_OUTSTANDING 1
+#define ZMQ_LB_KEY_HASH 2
+
+/*  Compression codecs (ZMQ_COMPRESSION option values).                       */
+#define ZMQ_COMPRESSION_NONE 0
+#define ZMQ_COMPRESSION_LZ 1
 
 /*  Message options                                                           */
 #define ZMQ_MORE 1
@@ -230,6 +266,7 @@ ZMQ_EXPORT int zmq_term (zmq_ctx_t context);
 /*  Send/recv options.                                                        */
 #define ZMQ_DONTWAIT 1
 #define ZMQ_SNDMORE 2
+#define ZMQ_URGENT 4
 
 ZMQ_EXPORT zmq_socket_t zmq_socket (zmq_ctx_t context, int type);
 ZMQ_EXPORT int zmq_close (zmq_socket_t s);
@@ -269,6 +306,22 @@ typedef struct
 
 ZMQ_EXPORT int zmq_poll (zmq_pollitem_t *items, int nitems, long timeout);
 
+/******************************************************************************/
+/*  Built-in proxy.                                                           */
+/******************************************************************************/
+
+/*  Proxy statistics.                                                         */
+#define ZMQ_PROXY_FRONTEND_MSGS 1
+#define ZMQ_PROXY_FRONTEND_BYTES 2
+#define ZMQ_PROXY_BACKEND_MSGS 3
+#define ZMQ_PROXY_BACKEND_BYTES 4
+
+ZMQ_EXPORT void *zmq_proxy_start (zmq_socket_t frontend, zmq_socket_t backend,
+    zmq_socket_t capture);
+ZMQ_EXPORT int zmq_proxy_getstat (void *proxy, int stat, void *value,
+    size_t *valuelen);
+ZMQ_EXPORT int zmq_proxy_stop (void *proxy);
+
 #undef ZMQ_EXPORT
 
 #ifdef __cplusplus
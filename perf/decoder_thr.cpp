@@ -0,0 +1,213 @@
+/*
+    Copyright (c) 2009-2011 250bpm s.r.o.
+    Copyright (c) 2007-2011 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+//  Measures the throughput of the decoder. The messages are passed over
+//  a TCP connection to a PULL socket from a plain socket writing frames
+//  encoded in advance, so that the I/O thread of the receiving side does
+//  little else than decoding the frames and passing the messages on.
+
+#include "../include/zmq.h"
+#include "../include/zmq_utils.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../src/platform.hpp"
+
+#if !defined ZMQ_HAVE_WINDOWS
+
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+static const int port = 5593;
+
+static int message_count;
+static size_t message_size;
+
+static void *writer (void *arg_)
+{
+    //  Encode as many frames as fit into 64kB, at least one.
+    size_t header_size = message_size + 1 < 255 ? 2 : 10;
+    size_t frame_size = header_size + message_size;
+    int frames = (int) (65536 / frame_size);
+    if (frames == 0)
+        frames = 1;
+    unsigned char *buf = (unsigned char*) malloc (frames * frame_size);
+    if (!buf) {
+        printf ("out of memory\n");
+        exit (1);
+    }
+    unsigned char *pos = buf;
+    for (int i = 0; i != frames; i++) {
+        if (header_size == 2)
+            *pos++ = (unsigned char) (message_size + 1);
+        else {
+            *pos++ = 0xff;
+            for (int j = 7; j >= 0; j--)
+                *pos++ = (unsigned char) ((message_size + 1) >> (j * 8));
+        }
+        *pos++ = 0;
+        memset (pos, 0, message_size);
+        pos += message_size;
+    }
+
+    int s = socket (AF_INET, SOCK_STREAM, 0);
+    if (s == -1) {
+        printf ("error in socket: %s\n", strerror (errno));
+        exit (1);
+    }
+    struct sockaddr_in addr;
+    memset (&addr, 0, sizeof (addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons (port);
+    addr.sin_addr.s_addr = htonl (INADDR_LOOPBACK);
+    int rc = connect (s, (struct sockaddr*) &addr, sizeof (addr));
+    if (rc != 0) {
+        printf ("error in connect: %s\n", strerror (errno));
+        exit (1);
+    }
+
+    for (int sent = 0; sent < message_count; sent += frames) {
+        size_t size = (message_count - sent < frames ?
+            message_count - sent : frames) * frame_size;
+        for (size_t written = 0; written < size;) {
+            ssize_t nbytes = send (s, buf + written, size - written, 0);
+            if (nbytes == -1) {
+                printf ("error in send: %s\n", strerror (errno));
+                exit (1);
+            }
+            written += nbytes;
+        }
+    }
+
+    //  Keep the connection open till the receiver is done.
+    char c;
+    recv (s, &c, 1, 0);
+    close (s);
+    free (buf);
+    return NULL;
+}
+
+int main (int argc, char *argv [])
+{
+    if (argc != 3) {
+        printf ("usage: decoder_thr <message-size> <message-count>\n");
+        return 1;
+    }
+    message_size = atoi (argv [1]);
+    message_count = atoi (argv [2]);
+    if (message_count <= 0) {
+        printf ("message count must be positive\n");
+        return 1;
+    }
+
+    void *ctx = zmq_init (1);
+    if (!ctx) {
+        printf ("error in zmq_init: %s\n", zmq_strerror (errno));
+        return 1;
+    }
+    void *s = zmq_socket (ctx, ZMQ_PULL);
+    if (!s) {
+        printf ("error in zmq_socket: %s\n", zmq_strerror (errno));
+        return 1;
+    }
+    char endpoint [64];
+    sprintf (endpoint, "tcp://127.0.0.1:%d", port);
+    int rc = zmq_bind (s, endpoint);
+    if (rc != 0) {
+        printf ("error in zmq_bind: %s\n", zmq_strerror (errno));
+        return 1;
+    }
+
+    pthread_t thread;
+    rc = pthread_create (&thread, NULL, writer, NULL);
+    if (rc != 0) {
+        printf ("error in pthread_create: %s\n", zmq_strerror (rc));
+        return 1;
+    }
+
+    zmq_msg_t msg;
+    rc = zmq_msg_init (&msg);
+    if (rc != 0) {
+        printf ("error in zmq_msg_init: %s\n", zmq_strerror (errno));
+        return 1;
+    }
+
+    //  The time is measured from the arrival of the first message.
+    void *watch = NULL;
+    for (int i = 0; i != message_count; i++) {
+        rc = zmq_recvmsg (s, &msg, 0);
+        if (rc < 0) {
+            printf ("error in zmq_recvmsg: %s\n", zmq_strerror (errno));
+            return 1;
+        }
+        if (zmq_msg_size (&msg) != message_size) {
+            printf ("message of incorrect size received\n");
+            return 1;
+        }
+        if (i == 0)
+            watch = zmq_stopwatch_start ();
+    }
+    unsigned long elapsed = zmq_stopwatch_stop (watch);
+    if (elapsed == 0)
+        elapsed = 1;
+
+    rc = zmq_msg_close (&msg);
+    if (rc != 0) {
+        printf ("error in zmq_msg_close: %s\n", zmq_strerror (errno));
+        return 1;
+    }
+    rc = zmq_close (s);
+    if (rc != 0) {
+        printf ("error in zmq_close: %s\n", zmq_strerror (errno));
+        return 1;
+    }
+    rc = zmq_term (ctx);
+    if (rc != 0) {
+        printf ("error in zmq_term: %s\n", zmq_strerror (errno));
+        return 1;
+    }
+    pthread_join (thread, NULL);
+
+    double throughput = (double) (message_count - 1) / elapsed * 1000000;
+    double megabits = throughput * message_size * 8 / 1000000;
+
+    printf ("message size: %d [B]\n", (int) message_size);
+    printf ("message count: %d\n", (int) message_count);
+    printf ("mean throughput: %d [msg/s]\n", (int) throughput);
+    printf ("mean throughput: %.3f [Mb/s]\n", megabits);
+
+    return 0;
+}
+
+#else
+
+int main (int argc, char *argv [])
+{
+    printf ("decoder_thr is not supported on this platform\n");
+    return 1;
+}
+
+#endif
@@ -0,0 +1,202 @@
+/*
+    Copyright (c) 2009-2011 250bpm s.r.o.
+    Copyright (c) 2007-2011 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+//  Measures the throughput of the encoder. The messages are passed from
+//  a PUSH socket over a TCP connection to a plain socket that only counts
+//  the received bytes, so that the sending side is limited by the encoding
+//  rather than by the peer's decoding.
+
+#include "../include/zmq.h"
+#include "../include/zmq_utils.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../src/platform.hpp"
+
+#if !defined ZMQ_HAVE_WINDOWS
+
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+static const int port = 5594;
+
+static int message_count;
+static size_t message_size;
+static unsigned long elapsed;
+
+static void *reader (void *arg_)
+{
+    int listener = *(int*) arg_;
+    int s = accept (listener, NULL, NULL);
+    if (s == -1) {
+        printf ("error in accept: %s\n", strerror (errno));
+        exit (1);
+    }
+
+    //  The time is measured from the arrival of the first data.
+    size_t header_size = message_size + 1 < 255 ? 2 : 10;
+    unsigned long long expected =
+        (unsigned long long) message_count * (header_size + message_size);
+    unsigned long long received = 0;
+    void *watch = NULL;
+    static char buf [65536];
+    while (received < expected) {
+        ssize_t nbytes = recv (s, buf, sizeof (buf), 0);
+        if (nbytes <= 0) {
+            printf ("error in recv: %s\n", strerror (errno));
+            exit (1);
+        }
+        if (!watch)
+            watch = zmq_stopwatch_start ();
+        received += nbytes;
+    }
+    elapsed = zmq_stopwatch_stop (watch);
+    if (elapsed == 0)
+        elapsed = 1;
+
+    close (s);
+    return NULL;
+}
+
+int main (int argc, char *argv [])
+{
+    if (argc != 3) {
+        printf ("usage: encoder_thr <message-size> <message-count>\n");
+        return 1;
+    }
+    message_size = atoi (argv [1]);
+    message_count = atoi (argv [2]);
+    if (message_count <= 0) {
+        printf ("message count must be positive\n");
+        return 1;
+    }
+
+    int listener = socket (AF_INET, SOCK_STREAM, 0);
+    if (listener == -1) {
+        printf ("error in socket: %s\n", strerror (errno));
+        return 1;
+    }
+    int flag = 1;
+    setsockopt (listener, SOL_SOCKET, SO_REUSEADDR, &flag, sizeof (flag));
+    struct sockaddr_in addr;
+    memset (&addr, 0, sizeof (addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons (port);
+    addr.sin_addr.s_addr = htonl (INADDR_LOOPBACK);
+    int rc = bind (listener, (struct sockaddr*) &addr, sizeof (addr));
+    if (rc == 0)
+        rc = listen (listener, 1);
+    if (rc != 0) {
+        printf ("error in bind: %s\n", strerror (errno));
+        return 1;
+    }
+
+    void *ctx = zmq_init (1);
+    if (!ctx) {
+        printf ("error in zmq_init: %s\n", zmq_strerror (errno));
+        return 1;
+    }
+    void *s = zmq_socket (ctx, ZMQ_PUSH);
+    if (!s) {
+        printf ("error in zmq_socket: %s\n", zmq_strerror (errno));
+        return 1;
+    }
+    int hwm = 0;
+    rc = zmq_setsockopt (s, ZMQ_SNDHWM, &hwm, sizeof (hwm));
+    if (rc != 0) {
+        printf ("error in zmq_setsockopt: %s\n", zmq_strerror (errno));
+        return 1;
+    }
+    char endpoint [64];
+    sprintf (endpoint, "tcp://127.0.0.1:%d", port);
+    rc = zmq_connect (s, endpoint);
+    if (rc != 0) {
+        printf ("error in zmq_connect: %s\n", zmq_strerror (errno));
+        return 1;
+    }
+
+    //  All the messages are queued in advance and the connection is
+    //  accepted only afterwards so that the encoder doesn't have to wait
+    //  for the application thread.
+    zmq_msg_t msg;
+    for (int i = 0; i != message_count; i++) {
+        rc = zmq_msg_init_size (&msg, message_size);
+        if (rc != 0) {
+            printf ("error in zmq_msg_init_size: %s\n", zmq_strerror (errno));
+            return 1;
+        }
+        memset (zmq_msg_data (&msg), 0, message_size);
+        rc = zmq_sendmsg (s, &msg, 0);
+        if (rc < 0) {
+            printf ("error in zmq_sendmsg: %s\n", zmq_strerror (errno));
+            return 1;
+        }
+        rc = zmq_msg_close (&msg);
+        if (rc != 0) {
+            printf ("error in zmq_msg_close: %s\n", zmq_strerror (errno));
+            return 1;
+        }
+    }
+
+    pthread_t thread;
+    rc = pthread_create (&thread, NULL, reader, &listener);
+    if (rc != 0) {
+        printf ("error in pthread_create: %s\n", zmq_strerror (rc));
+        return 1;
+    }
+    pthread_join (thread, NULL);
+
+    rc = zmq_close (s);
+    if (rc != 0) {
+        printf ("error in zmq_close: %s\n", zmq_strerror (errno));
+        return 1;
+    }
+    rc = zmq_term (ctx);
+    if (rc != 0) {
+        printf ("error in zmq_term: %s\n", zmq_strerror (errno));
+        return 1;
+    }
+    close (listener);
+
+    double throughput = (double) message_count / elapsed * 1000000;
+    double megabits = throughput * message_size * 8 / 1000000;
+
+    printf ("message size: %d [B]\n", (int) message_size);
+    printf ("message count: %d\n", (int) message_count);
+    printf ("mean throughput: %d [msg/s]\n", (int) throughput);
+    printf ("mean throughput: %.3f [Mb/s]\n", megabits);
+
+    return 0;
+}
+
+#else
+
+int main (int argc, char *argv [])
+{
+    printf ("encoder_thr is not supported on this platform\n");
+    return 1;
+}
+
+#endif
@@ -0,0 +1,291 @@
+/*
+    Copyright (c) 2009-2011 250bpm s.r.o.
+    Copyright (c) 2007-2011 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+//  Measures the latency of tasks distributed by a PUSH socket to a set of
+//  workers one of which is much slower than the others. The latency is
+//  measured from the moment the task is sent till the moment the worker
+//  finishes processing it. Both round-robin and least-outstanding
+//  load-balancing strategies are measured.
+
+#include "../include/zmq.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+
+#include "../src/platform.hpp"
+#include "../src/stdint.hpp"
+
+#if defined ZMQ_HAVE_WINDOWS
+#include <windows.h>
+#include <process.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/time.h>
+#endif
+
+//  Number of workers, the first of them is the slow one.
+static const int worker_count = 4;
+
+//  Time needed to process a task by a fast and the slow worker [us].
+static const int fast_service_time = 100;
+static const int slow_service_time = 2000;
+
+//  Interval between two subsequent tasks [us].
+static const int task_interval = 200;
+
+static int message_count;
+static uint64_t *latencies;
+
+struct worker_t
+{
+    void *ctx;
+    int service_time;
+};
+
+static uint64_t now_us ()
+{
+#if defined ZMQ_HAVE_WINDOWS
+    LARGE_INTEGER ticks_per_second;
+    QueryPerformanceFrequency (&ticks_per_second);
+    LARGE_INTEGER ticks;
+    QueryPerformanceCounter (&ticks);
+    return (uint64_t) (ticks.QuadPart * 1000000 / ticks_per_second.QuadPart);
+#else
+    struct timeval tv;
+    gettimeofday (&tv, NULL);
+    return (uint64_t) tv.tv_sec * 1000000 + tv.tv_usec;
+#endif
+}
+
+static void sleep_us (int us_)
+{
+#if defined ZMQ_HAVE_WINDOWS
+    Sleep (us_ / 1000);
+#else
+    usleep (us_);
+#endif
+}
+
+#if defined ZMQ_HAVE_WINDOWS
+static unsigned int __stdcall worker (void *arg_)
+#else
+static void *worker (void *arg_)
+#endif
+{
+    worker_t *w = (worker_t*) arg_;
+    struct {int seq; uint64_t sent;} task;
+
+    void *s = zmq_socket (w->ctx, ZMQ_PULL);
+    if (!s) {
+        printf ("error in zmq_socket: %s\n", zmq_strerror (errno));
+        exit (1);
+    }
+    int hwm = 10;
+    int rc = zmq_setsockopt (s, ZMQ_RCVHWM, &hwm, sizeof (hwm));
+    if (rc != 0) {
+        printf ("error in zmq_setsockopt: %s\n", zmq_strerror (errno));
+        exit (1);
+    }
+    rc = zmq_connect (s, "inproc://tasks");
+    if (rc != 0) {
+        printf ("error in zmq_connect: %s\n", zmq_strerror (errno));
+        exit (1);
+    }
+
+    void *done = zmq_socket (w->ctx, ZMQ_PUSH);
+    if (!done) {
+        printf ("error in zmq_socket: %s\n", zmq_strerror (errno));
+        exit (1);
+    }
+    rc = zmq_connect (done, "inproc://done");
+    if (rc != 0) {
+        printf ("error in zmq_connect: %s\n", zmq_strerror (errno));
+        exit (1);
+    }
+
+    while (true) {
+        rc = zmq_recv (s, &task, sizeof (task), 0);
+        if (rc < 0 && errno == ETERM)
+            break;
+        if (rc != sizeof (task)) {
+            printf ("error in zmq_recv: %s\n", zmq_strerror (errno));
+            exit (1);
+        }
+        sleep_us (w->service_time);
+        latencies [task.seq] = now_us () - task.sent;
+        rc = zmq_send (done, NULL, 0, 0);
+        if (rc < 0 && errno == ETERM)
+            break;
+    }
+
+    zmq_close (done);
+    zmq_close (s);
+
+#if defined ZMQ_HAVE_WINDOWS
+    return 0;
+#else
+    return NULL;
+#endif
+}
+
+static void run (int strategy_, const char *name_)
+{
+    void *ctx = zmq_init (1);
+    if (!ctx) {
+        printf ("error in zmq_init: %s\n", zmq_strerror (errno));
+        exit (1);
+    }
+
+    void *s = zmq_socket (ctx, ZMQ_PUSH);
+    void *done = zmq_socket (ctx, ZMQ_PULL);
+    if (!s || !done) {
+        printf ("error in zmq_socket: %s\n", zmq_strerror (errno));
+        exit (1);
+    }
+    int hwm = 10;
+    int rc = zmq_setsockopt (s, ZMQ_SNDHWM, &hwm, sizeof (hwm));
+    if (rc == 0)
+        rc = zmq_setsockopt (s, ZMQ_LB_STRATEGY, &strategy_,
+            sizeof (strategy_));
+    if (rc != 0) {
+        printf ("error in zmq_setsockopt: %s\n", zmq_strerror (errno));
+        exit (1);
+    }
+    rc = zmq_bind (s, "inproc://tasks");
+    if (rc == 0)
+        rc = zmq_bind (done, "inproc://done");
+    if (rc != 0) {
+        printf ("error in zmq_bind: %s\n", zmq_strerror (errno));
+        exit (1);
+    }
+
+    worker_t workers [worker_count];
+#if defined ZMQ_HAVE_WINDOWS
+    HANDLE threads [worker_count];
+#else
+    pthread_t threads [worker_count];
+#endif
+    for (int i = 0; i != worker_count; i++) {
+        workers [i].ctx = ctx;
+        workers [i].service_time = i == 0 ? slow_service_time :
+            fast_service_time;
+#if defined ZMQ_HAVE_WINDOWS
+        threads [i] = (HANDLE) _beginthreadex (NULL, 0, worker, &workers [i],
+            0 , NULL);
+        if (threads [i] == 0) {
+            printf ("error in _beginthreadex\n");
+            exit (1);
+        }
+#else
+        rc = pthread_create (&threads [i], NULL, worker, &workers [i]);
+        if (rc != 0) {
+            printf ("error in pthread_create: %s\n", zmq_strerror (rc));
+            exit (1);
+        }
+#endif
+    }
+
+    //  Give the workers time to connect.
+    sleep_us (100000);
+
+    struct {int seq; uint64_t sent;} task;
+    for (int i = 0; i != message_count; i++) {
+        task.seq = i;
+        task.sent = now_us ();
+        rc = zmq_send (s, &task, sizeof (task), 0);
+        if (rc != sizeof (task)) {
+            printf ("error in zmq_send: %s\n", zmq_strerror (errno));
+            exit (1);
+        }
+        sleep_us (task_interval);
+    }
+
+    for (int i = 0; i != message_count; i++) {
+        rc = zmq_recv (done, NULL, 0, 0);
+        if (rc != 0) {
+            printf ("error in zmq_recv: %s\n", zmq_strerror (errno));
+            exit (1);
+        }
+    }
+
+    rc = zmq_close (s);
+    if (rc == 0)
+        rc = zmq_close (done);
+    if (rc != 0) {
+        printf ("error in zmq_close: %s\n", zmq_strerror (errno));
+        exit (1);
+    }
+
+    //  Terminating the context makes the workers exit.
+    rc = zmq_term (ctx);
+    if (rc != 0) {
+        printf ("error in zmq_term: %s\n", zmq_strerror (errno));
+        exit (1);
+    }
+
+    for (int i = 0; i != worker_count; i++) {
+#if defined ZMQ_HAVE_WINDOWS
+        WaitForSingleObject (threads [i], INFINITE);
+        CloseHandle (threads [i]);
+#else
+        pthread_join (threads [i], NULL);
+#endif
+    }
+
+    std::sort (latencies, latencies + message_count);
+    printf ("%s:\n", name_);
+    printf ("  p50 latency: %d [us]\n",
+        (int) latencies [message_count / 2]);
+    printf ("  p99 latency: %d [us]\n",
+        (int) latencies [message_count * 99 / 100]);
+    printf ("  max latency: %d [us]\n",
+        (int) latencies [message_count - 1]);
+}
+
+int main (int argc, char *argv [])
+{
+    if (argc != 2) {
+        printf ("usage: lb_latency <message-count>\n");
+        return 1;
+    }
+
+    message_count = atoi (argv [1]);
+    if (message_count <= 0) {
+        printf ("message count must be positive\n");
+        return 1;
+    }
+    latencies = (uint64_t*) malloc (message_count * sizeof (uint64_t));
+    if (!latencies) {
+        printf ("out of memory\n");
+        return 1;
+    }
+
+    printf ("workers: %d (1 slow)\n", worker_count);
+    printf ("message count: %d\n", message_count);
+
+    run (ZMQ_LB_ROUND_ROBIN, "round-robin");
+    run (ZMQ_LB_LEAST_OUTSTANDING, "least-outstanding");
+
+    free (latencies);
+    return 0;
+}
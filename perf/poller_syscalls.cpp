@@ -0,0 +1,227 @@
+/*
+    Copyright (c) 2009-2011 250bpm s.r.o.
+    Copyright (c) 2007-2011 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+//  Counts the system calls the I/O thread issues to pass messages over
+//  a set of TCP connections in lock-step: a message is sent over each of
+//  the connections and all of them are received before the next round.
+//  Thus the engines run out of data to send and get activated again every
+//  round. The calls are counted by interposing the libc functions, which
+//  works on Linux only.
+
+#include "../include/zmq.h"
+#include "../include/zmq_utils.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../src/platform.hpp"
+
+#if defined ZMQ_HAVE_LINUX
+
+#include <signal.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+
+#include "../src/atomic_counter.hpp"
+
+static zmq::atomic_counter_t epoll_ctl_calls;
+static zmq::atomic_counter_t epoll_wait_calls;
+static zmq::atomic_counter_t send_calls;
+static zmq::atomic_counter_t recv_calls;
+
+//  The definitions below take precedence over the ones in libc. Each one
+//  counts the call and issues the system call directly.
+
+extern "C" int epoll_ctl (int epfd_, int op_, int fd_, struct epoll_event *ev_)
+{
+    epoll_ctl_calls.add (1);
+    return syscall (SYS_epoll_ctl, epfd_, op_, fd_, ev_);
+}
+
+extern "C" int epoll_wait (int epfd_, struct epoll_event *events_,
+    int maxevents_, int timeout_)
+{
+    epoll_wait_calls.add (1);
+    return syscall (SYS_epoll_pwait, epfd_, events_, maxevents_, timeout_,
+        NULL, _NSIG / 8);
+}
+
+extern "C" ssize_t send (int fd_, const void *buf_, size_t len_, int flags_)
+{
+    send_calls.add (1);
+    return syscall (SYS_sendto, fd_, buf_, len_, flags_, NULL, 0);
+}
+
+extern "C" ssize_t recv (int fd_, void *buf_, size_t len_, int flags_)
+{
+    recv_calls.add (1);
+    return syscall (SYS_recvfrom, fd_, buf_, len_, flags_, NULL, NULL);
+}
+
+int main (int argc, char *argv [])
+{
+    const char *bind_to;
+    int connection_count;
+    size_t message_size;
+    int round_count;
+    void *ctx;
+    void *s;
+    void **clients;
+    int rc;
+    int i;
+    int j;
+    char *buf;
+    void *watch = NULL;
+    unsigned long elapsed;
+
+    if (argc != 5) {
+        printf ("usage: poller_syscalls <bind-to> <connection-count> "
+            "<message-size> <round-count>\n");
+        return 1;
+    }
+    bind_to = argv [1];
+    connection_count = atoi (argv [2]);
+    message_size = atoi (argv [3]);
+    round_count = atoi (argv [4]);
+    if (connection_count <= 0 || round_count <= 0) {
+        printf ("connection count and round count must be positive\n");
+        return 1;
+    }
+
+    buf = (char*) malloc (message_size + 1);
+    clients = (void**) malloc (connection_count * sizeof (void*));
+    if (!buf || !clients) {
+        printf ("out of memory\n");
+        return 1;
+    }
+    memset (buf, 0, message_size + 1);
+
+    ctx = zmq_init (1);
+    if (!ctx) {
+        printf ("error in zmq_init: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
+    s = zmq_socket (ctx, ZMQ_PULL);
+    if (!s) {
+        printf ("error in zmq_socket: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+    rc = zmq_bind (s, bind_to);
+    if (rc != 0) {
+        printf ("error in zmq_bind: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
+    for (i = 0; i != connection_count; i++) {
+        clients [i] = zmq_socket (ctx, ZMQ_PUSH);
+        if (!clients [i]) {
+            printf ("error in zmq_socket: %s\n", zmq_strerror (errno));
+            return -1;
+        }
+        rc = zmq_connect (clients [i], bind_to);
+        if (rc != 0) {
+            printf ("error in zmq_connect: %s\n", zmq_strerror (errno));
+            return -1;
+        }
+    }
+
+    //  The rounds are counted from the moment all the connections are
+    //  established, i.e. from the moment the first round is received.
+    for (j = 0; j != round_count + 1; j++) {
+        if (j == 1) {
+            epoll_ctl_calls.set (0);
+            epoll_wait_calls.set (0);
+            send_calls.set (0);
+            recv_calls.set (0);
+            watch = zmq_stopwatch_start ();
+        }
+        for (i = 0; i != connection_count; i++) {
+            rc = zmq_send (clients [i], buf, message_size, 0);
+            if (rc < 0) {
+                printf ("error in zmq_send: %s\n", zmq_strerror (errno));
+                return -1;
+            }
+        }
+        for (i = 0; i != connection_count; i++) {
+            rc = zmq_recv (s, buf, message_size + 1, 0);
+            if (rc < 0) {
+                printf ("error in zmq_recv: %s\n", zmq_strerror (errno));
+                return -1;
+            }
+            if ((size_t) rc != message_size) {
+                printf ("message of incorrect size received\n");
+                return -1;
+            }
+        }
+    }
+
+    elapsed = zmq_stopwatch_stop (watch);
+    if (elapsed == 0)
+        elapsed = 1;
+
+    double messages = (double) connection_count * round_count;
+    printf ("connection count: %d\n", connection_count);
+    printf ("message size: %d [B]\n", (int) message_size);
+    printf ("round count: %d\n", round_count);
+    printf ("throughput: %d [msg/s]\n",
+        (int) (messages / elapsed * 1000000));
+    printf ("epoll_ctl: %.3f [calls/msg]\n", epoll_ctl_calls.get () / messages);
+    printf ("epoll_wait: %.3f [calls/msg]\n",
+        epoll_wait_calls.get () / messages);
+    printf ("send: %.3f [calls/msg]\n", send_calls.get () / messages);
+    printf ("recv: %.3f [calls/msg]\n", recv_calls.get () / messages);
+
+    for (i = 0; i != connection_count; i++) {
+        rc = zmq_close (clients [i]);
+        if (rc != 0) {
+            printf ("error in zmq_close: %s\n", zmq_strerror (errno));
+            return -1;
+        }
+    }
+    rc = zmq_close (s);
+    if (rc != 0) {
+        printf ("error in zmq_close: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
+    rc = zmq_term (ctx);
+    if (rc != 0) {
+        printf ("error in zmq_term: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
+    free (clients);
+    free (buf);
+    return 0;
+}
+
+#else
+
+int main (int argc, char *argv [])
+{
+    printf ("poller_syscalls is supported on Linux only\n");
+    return 1;
+}
+
+#endif
@@ -0,0 +1,338 @@
+/*
+    Copyright (c) 2009-2011 250bpm s.r.o.
+    Copyright (c) 2007-2011 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+//  Measures the throughput of messages passed PUSH -> PULL/PUSH -> PULL
+//  with the device in the middle implemented as an application thread
+//  looping over zmq_recvmsg/zmq_sendmsg and as the built-in proxy.
+
+#include "../include/zmq.h"
+#include "../include/zmq_utils.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../src/platform.hpp"
+
+#if defined ZMQ_HAVE_WINDOWS
+#include <windows.h>
+#include <process.h>
+#else
+#include <pthread.h>
+#endif
+
+static int message_count;
+static size_t message_size;
+
+struct device_t
+{
+    void *frontend;
+    void *backend;
+};
+
+#if defined ZMQ_HAVE_WINDOWS
+static unsigned int __stdcall sender (void *ctx_)
+#else
+static void *sender (void *ctx_)
+#endif
+{
+    void *s;
+    int rc;
+    int i;
+    zmq_msg_t msg;
+
+    s = zmq_socket (ctx_, ZMQ_PUSH);
+    if (!s) {
+        printf ("error in zmq_socket: %s\n", zmq_strerror (errno));
+        exit (1);
+    }
+
+    rc = zmq_connect (s, "inproc://frontend");
+    if (rc != 0) {
+        printf ("error in zmq_connect: %s\n", zmq_strerror (errno));
+        exit (1);
+    }
+
+    for (i = 0; i != message_count; i++) {
+        rc = zmq_msg_init_size (&msg, message_size);
+        if (rc != 0) {
+            printf ("error in zmq_msg_init_size: %s\n", zmq_strerror (errno));
+            exit (1);
+        }
+#if defined ZMQ_MAKE_VALGRIND_HAPPY
+        memset (zmq_msg_data (&msg), 0, message_size);
+#endif
+        rc = zmq_sendmsg (s, &msg, 0);
+        if (rc < 0) {
+            printf ("error in zmq_sendmsg: %s\n", zmq_strerror (errno));
+            exit (1);
+        }
+        rc = zmq_msg_close (&msg);
+        if (rc != 0) {
+            printf ("error in zmq_msg_close: %s\n", zmq_strerror (errno));
+            exit (1);
+        }
+    }
+
+    rc = zmq_close (s);
+    if (rc != 0) {
+        printf ("error in zmq_close: %s\n", zmq_strerror (errno));
+        exit (1);
+    }
+
+#if defined ZMQ_HAVE_WINDOWS
+    return 0;
+#else
+    return NULL;
+#endif
+}
+
+#if defined ZMQ_HAVE_WINDOWS
+static unsigned int __stdcall loop (void *device_)
+#else
+static void *loop (void *device_)
+#endif
+{
+    device_t *device = (device_t*) device_;
+    int rc;
+    int i;
+    zmq_msg_t msg;
+
+    rc = zmq_msg_init (&msg);
+    if (rc != 0) {
+        printf ("error in zmq_msg_init: %s\n", zmq_strerror (errno));
+        exit (1);
+    }
+
+    for (i = 0; i != message_count; i++) {
+        rc = zmq_recvmsg (device->frontend, &msg, 0);
+        if (rc < 0) {
+            printf ("error in zmq_recvmsg: %s\n", zmq_strerror (errno));
+            exit (1);
+        }
+        rc = zmq_sendmsg (device->backend, &msg, 0);
+        if (rc < 0) {
+            printf ("error in zmq_sendmsg: %s\n", zmq_strerror (errno));
+            exit (1);
+        }
+    }
+
+    rc = zmq_msg_close (&msg);
+    if (rc != 0) {
+        printf ("error in zmq_msg_close: %s\n", zmq_strerror (errno));
+        exit (1);
+    }
+
+#if defined ZMQ_HAVE_WINDOWS
+    return 0;
+#else
+    return NULL;
+#endif
+}
+
+#if defined ZMQ_HAVE_WINDOWS
+static HANDLE start_thread (unsigned int (__stdcall *fn_) (void*), void *arg_)
+{
+    HANDLE thread = (HANDLE) _beginthreadex (NULL, 0, fn_, arg_, 0 , NULL);
+    if (thread == 0) {
+        printf ("error in _beginthreadex\n");
+        exit (1);
+    }
+    return thread;
+}
+
+static void join_thread (HANDLE thread_)
+{
+    DWORD rc = WaitForSingleObject (thread_, INFINITE);
+    if (rc == WAIT_FAILED) {
+        printf ("error in WaitForSingleObject\n");
+        exit (1);
+    }
+    BOOL rc2 = CloseHandle (thread_);
+    if (rc2 == 0) {
+        printf ("error in CloseHandle\n");
+        exit (1);
+    }
+}
+#else
+static pthread_t start_thread (void *(*fn_) (void*), void *arg_)
+{
+    pthread_t thread;
+    int rc = pthread_create (&thread, NULL, fn_, arg_);
+    if (rc != 0) {
+        printf ("error in pthread_create: %s\n", zmq_strerror (rc));
+        exit (1);
+    }
+    return thread;
+}
+
+static void join_thread (pthread_t thread_)
+{
+    int rc = pthread_join (thread_, NULL);
+    if (rc != 0) {
+        printf ("error in pthread_join: %s\n", zmq_strerror (rc));
+        exit (1);
+    }
+}
+#endif
+
+static unsigned long run (bool builtin_)
+{
+    void *ctx;
+    void *s;
+    int rc;
+    int i;
+    zmq_msg_t msg;
+    device_t device;
+    void *proxy = NULL;
+    void *watch;
+    unsigned long elapsed;
+
+    ctx = zmq_init (1);
+    if (!ctx) {
+        printf ("error in zmq_init: %s\n", zmq_strerror (errno));
+        exit (1);
+    }
+
+    device.frontend = zmq_socket (ctx, ZMQ_PULL);
+    device.backend = zmq_socket (ctx, ZMQ_PUSH);
+    s = zmq_socket (ctx, ZMQ_PULL);
+    if (!device.frontend || !device.backend || !s) {
+        printf ("error in zmq_socket: %s\n", zmq_strerror (errno));
+        exit (1);
+    }
+
+    rc = zmq_bind (device.frontend, "inproc://frontend");
+    if (rc == 0)
+        rc = zmq_bind (device.backend, "inproc://backend");
+    if (rc == 0)
+        rc = zmq_connect (s, "inproc://backend");
+    if (rc != 0) {
+        printf ("error in zmq_bind: %s\n", zmq_strerror (errno));
+        exit (1);
+    }
+
+#if defined ZMQ_HAVE_WINDOWS
+    HANDLE loop_thread = 0;
+    HANDLE sender_thread;
+#else
+    pthread_t loop_thread = 0;
+    pthread_t sender_thread;
+#endif
+    if (builtin_) {
+        proxy = zmq_proxy_start (device.frontend, device.backend, NULL);
+        if (!proxy) {
+            printf ("error in zmq_proxy_start: %s\n", zmq_strerror (errno));
+            exit (1);
+        }
+    }
+    else
+        loop_thread = start_thread (loop, &device);
+
+    rc = zmq_msg_init (&msg);
+    if (rc != 0) {
+        printf ("error in zmq_msg_init: %s\n", zmq_strerror (errno));
+        exit (1);
+    }
+
+    watch = zmq_stopwatch_start ();
+
+    sender_thread = start_thread (sender, ctx);
+    for (i = 0; i != message_count; i++) {
+        rc = zmq_recvmsg (s, &msg, 0);
+        if (rc < 0) {
+            printf ("error in zmq_recvmsg: %s\n", zmq_strerror (errno));
+            exit (1);
+        }
+        if (zmq_msg_size (&msg) != message_size) {
+            printf ("message of incorrect size received\n");
+            exit (1);
+        }
+    }
+
+    elapsed = zmq_stopwatch_stop (watch);
+    if (elapsed == 0)
+        elapsed = 1;
+
+    join_thread (sender_thread);
+
+    rc = zmq_msg_close (&msg);
+    if (rc != 0) {
+        printf ("error in zmq_msg_close: %s\n", zmq_strerror (errno));
+        exit (1);
+    }
+
+    if (builtin_) {
+        rc = zmq_proxy_stop (proxy);
+        if (rc != 0) {
+            printf ("error in zmq_proxy_stop: %s\n", zmq_strerror (errno));
+            exit (1);
+        }
+    }
+    else {
+        join_thread (loop_thread);
+        rc = zmq_close (device.frontend);
+        if (rc == 0)
+            rc = zmq_close (device.backend);
+        if (rc != 0) {
+            printf ("error in zmq_close: %s\n", zmq_strerror (errno));
+            exit (1);
+        }
+    }
+
+    rc = zmq_close (s);
+    if (rc != 0) {
+        printf ("error in zmq_close: %s\n", zmq_strerror (errno));
+        exit (1);
+    }
+
+    rc = zmq_term (ctx);
+    if (rc != 0) {
+        printf ("error in zmq_term: %s\n", zmq_strerror (errno));
+        exit (1);
+    }
+
+    return (unsigned long)
+        ((double) message_count / (double) elapsed * 1000000);
+}
+
+int main (int argc, char *argv [])
+{
+    unsigned long throughput;
+
+    if (argc != 3) {
+        printf ("usage: proxy_thr <message-size> <message-count>\n");
+        return 1;
+    }
+
+    message_size = atoi (argv [1]);
+    message_count = atoi (argv [2]);
+
+    printf ("message size: %d [B]\n", (int) message_size);
+    printf ("message count: %d\n", (int) message_count);
+
+    throughput = run (false);
+    printf ("application loop: %d [msg/s]\n", (int) throughput);
+
+    throughput = run (true);
+    printf ("built-in proxy: %d [msg/s]\n", (int) throughput);
+
+    return 0;
+}
@@ -0,0 +1,131 @@
+/*
+    Copyright (c) 2009-2011 250bpm s.r.o.
+    Copyright (c) 2007-2011 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+//  Measures the cost of routing lookups done by ROUTER socket with large
+//  numbers of peers. The number of peers that can be attached to a single
+//  socket is limited by the number of sockets and file descriptors, so the
+//  identity table is exercised directly and compared to the ordered map
+//  used before.
+
+#include "../include/zmq.h"
+#include "../include/zmq_utils.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <map>
+#include <vector>
+
+#include "../src/idmap.hpp"
+#include "../src/blob.hpp"
+
+//  The identity table asserts using the library-internal abort function
+//  which is not exported from the library.
+void zmq::zmq_abort (const char *errmsg_)
+{
+    fprintf (stderr, "%s\n", errmsg_);
+    abort ();
+}
+
+struct outpipe_t
+{
+    void *pipe;
+    bool active;
+};
+
+static void make_identity (unsigned char *buf_, uint32_t id_)
+{
+    buf_ [0] = 0;
+    buf_ [1] = (unsigned char) (id_ >> 24);
+    buf_ [2] = (unsigned char) (id_ >> 16);
+    buf_ [3] = (unsigned char) (id_ >> 8);
+    buf_ [4] = (unsigned char) id_;
+}
+
+static void run (int peer_count_, int lookup_count_)
+{
+    //  Identities are generated the same way ROUTER socket does it.
+    std::vector <unsigned char> ids (peer_count_ * 5);
+    uint32_t seed = (uint32_t) rand ();
+    for (int i = 0; i != peer_count_; i++)
+        make_identity (&ids [i * 5], seed + i);
+
+    std::vector <int> order (lookup_count_);
+    for (int i = 0; i != lookup_count_; i++)
+        order [i] = rand () % peer_count_;
+
+    zmq::idmap_t <outpipe_t> idmap;
+    std::map <zmq::blob_t, outpipe_t> map;
+    for (int i = 0; i != peer_count_; i++) {
+        outpipe_t outpipe = {&ids [i * 5], true};
+        idmap.insert (&ids [i * 5], 5, outpipe);
+        map.insert (std::make_pair (zmq::blob_t (&ids [i * 5], 5), outpipe));
+    }
+
+    int found = 0;
+    void *watch = zmq_stopwatch_start ();
+    for (int i = 0; i != lookup_count_; i++)
+        if (idmap.find (&ids [order [i] * 5], 5))
+            found++;
+    unsigned long idmap_elapsed = zmq_stopwatch_stop (watch);
+
+    //  The old lookup had to construct the key from the message data.
+    watch = zmq_stopwatch_start ();
+    for (int i = 0; i != lookup_count_; i++)
+        if (map.find (zmq::blob_t (&ids [order [i] * 5], 5)) != map.end ())
+            found++;
+    unsigned long map_elapsed = zmq_stopwatch_stop (watch);
+
+    if (found != lookup_count_ * 2) {
+        printf ("lookup failed\n");
+        exit (1);
+    }
+
+    if (idmap_elapsed == 0)
+        idmap_elapsed = 1;
+    if (map_elapsed == 0)
+        map_elapsed = 1;
+
+    printf ("peers: %d\n", peer_count_);
+    printf ("  hashed table: %.3f [ns/lookup] %d [lookups/s]\n",
+        (double) idmap_elapsed * 1000 / lookup_count_,
+        (int) ((double) lookup_count_ * 1000000 / idmap_elapsed));
+    printf ("  ordered map:  %.3f [ns/lookup] %d [lookups/s]\n",
+        (double) map_elapsed * 1000 / lookup_count_,
+        (int) ((double) lookup_count_ * 1000000 / map_elapsed));
+}
+
+int main (int argc, char *argv [])
+{
+    int lookup_count;
+
+    if (argc != 2) {
+        printf ("usage: router_lookup <lookup-count>\n");
+        return 1;
+    }
+
+    lookup_count = atoi (argv [1]);
+
+    run (1000, lookup_count);
+    run (10000, lookup_count);
+    run (100000, lookup_count);
+
+    return 0;
+}
@@ -0,0 +1,182 @@
+/*
+    Copyright (c) 2009-2011 250bpm s.r.o.
+    Copyright (c) 2007-2011 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+//  Measures the throughput of the bare lock-free pipes under bursty load.
+//  The writer thread pushes a burst of items to each of a set of pipes in
+//  turn, while the reader thread drains the pipes in the same order. Every
+//  burst grows the queue by several chunks which are released again once
+//  the reader catches up. The test is run with the chunks allocated
+//  directly and with the chunks borrowed from a shared cache.
+//
+//  With a single pipe and burst size of 1, every item is flushed on its own
+//  and the test measures the cost of passing the items between the writer
+//  and the reader thread. Any layout change meant to reduce false sharing
+//  between the two threads has to be measured this way, along with
+//  inproc_thr, on a multi-core machine. On a single core there are no cache
+//  line transfers and the numbers say nothing about it.
+
+#include "../include/zmq.h"
+#include "../include/zmq_utils.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../src/platform.hpp"
+#include "../src/ypipe.hpp"
+#include "../src/chunk_pool.hpp"
+#include "../src/config.hpp"
+
+#if defined ZMQ_HAVE_WINDOWS
+#include <windows.h>
+#include <process.h>
+#else
+#include <pthread.h>
+#endif
+
+//  Items have the same size as zmq_msg_t so that the chunks have the same
+//  size as in the real message pipes.
+struct item_t
+{
+    int seq;
+    unsigned char unused [sizeof (zmq_msg_t) - sizeof (int)];
+};
+
+typedef zmq::ypipe_t <item_t, zmq::message_pipe_granularity> pipe_t;
+
+static int pipe_count;
+static int burst_size;
+static int round_count;
+static pipe_t **pipes;
+
+#if defined ZMQ_HAVE_WINDOWS
+static unsigned int __stdcall reader (void *arg_)
+#else
+static void *reader (void *arg_)
+#endif
+{
+    item_t item;
+    for (int round = 0; round != round_count; round++) {
+        for (int i = 0; i != pipe_count; i++) {
+            for (int j = 0; j != burst_size; j++) {
+                while (!pipes [i]->read (&item))
+                    ;
+                if (item.seq != j) {
+                    printf ("item out of order\n");
+                    exit (1);
+                }
+            }
+        }
+    }
+
+#if defined ZMQ_HAVE_WINDOWS
+    return 0;
+#else
+    return NULL;
+#endif
+}
+
+static unsigned long run (zmq::chunk_pool_t *pool_)
+{
+    pipes = (pipe_t**) malloc (pipe_count * sizeof (pipe_t*));
+    if (!pipes) {
+        printf ("out of memory\n");
+        exit (1);
+    }
+    for (int i = 0; i != pipe_count; i++)
+        pipes [i] = new pipe_t (pool_);
+
+    void *watch = zmq_stopwatch_start ();
+
+#if defined ZMQ_HAVE_WINDOWS
+    HANDLE thread = (HANDLE) _beginthreadex (NULL, 0, reader, NULL, 0 , NULL);
+    if (thread == 0) {
+        printf ("error in _beginthreadex\n");
+        exit (1);
+    }
+#else
+    pthread_t thread;
+    int rc = pthread_create (&thread, NULL, reader, NULL);
+    if (rc != 0) {
+        printf ("error in pthread_create: %s\n", zmq_strerror (rc));
+        exit (1);
+    }
+#endif
+
+    item_t item;
+    memset (&item, 0, sizeof (item));
+    for (int round = 0; round != round_count; round++) {
+        for (int i = 0; i != pipe_count; i++) {
+            for (int j = 0; j != burst_size; j++) {
+                item.seq = j;
+                pipes [i]->write (item, false);
+            }
+            pipes [i]->flush ();
+        }
+    }
+
+#if defined ZMQ_HAVE_WINDOWS
+    WaitForSingleObject (thread, INFINITE);
+    CloseHandle (thread);
+#else
+    pthread_join (thread, NULL);
+#endif
+
+    unsigned long elapsed = zmq_stopwatch_stop (watch);
+    if (elapsed == 0)
+        elapsed = 1;
+
+    for (int i = 0; i != pipe_count; i++)
+        delete pipes [i];
+    free (pipes);
+
+    return (unsigned long) ((double) pipe_count * burst_size * round_count /
+        (double) elapsed * 1000000);
+}
+
+int main (int argc, char *argv [])
+{
+    if (argc != 4) {
+        printf ("usage: ypipe_thr <pipe-count> <burst-size> <round-count>\n");
+        return 1;
+    }
+
+    pipe_count = atoi (argv [1]);
+    burst_size = atoi (argv [2]);
+    round_count = atoi (argv [3]);
+    if (pipe_count <= 0 || burst_size <= 0 || round_count <= 0) {
+        printf ("arguments must be positive\n");
+        return 1;
+    }
+
+    printf ("pipe count: %d\n", pipe_count);
+    printf ("burst size: %d\n", burst_size);
+    printf ("round count: %d\n", round_count);
+
+    unsigned long throughput = run (NULL);
+    printf ("malloc: %d [items/s]\n", (int) throughput);
+
+    zmq::chunk_pool_t pool;
+    pool.set_limit (4 * 1024 * 1024);
+    throughput = run (&pool);
+    printf ("chunk cache: %d [items/s]\n", (int) throughput);
+
+    return 0;
+}
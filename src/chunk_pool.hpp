@@ -0,0 +1,164 @@
+/*
+    Copyright (c) 2009-2011 250bpm s.r.o.
+    Copyright (c) 2007-2011 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __ZMQ_CHUNK_POOL_HPP_INCLUDED__
+#define __ZMQ_CHUNK_POOL_HPP_INCLUDED__
+
+#include <stdlib.h>
+#include <stddef.h>
+
+#include "mutex.hpp"
+#include "stdint.hpp"
+#include "config.hpp"
+#include "err.hpp"
+
+namespace zmq
+{
+
+    //  Cache of the memory chunks used by the message queues. It is shared
+    //  by all the pipes within a context: when a queue grows it borrows
+    //  a chunk from the cache, when it shrinks it returns the chunk back.
+    //  Thus bursts of messages in different pipes reuse the same memory
+    //  rather than going to the allocator each time. The amount of memory
+    //  held by the cache is capped; chunks above the limit are freed.
+    //  All the chunks must be of the same size.
+
+    class chunk_pool_t
+    {
+    public:
+
+        inline chunk_pool_t () :
+            head (NULL),
+            chunk_size (0),
+            cached (0),
+            limit (chunk_cache_size)
+        {
+        }
+
+        inline ~chunk_pool_t ()
+        {
+            while (head) {
+                item_t *item = head;
+                head = head->next;
+                free (item);
+            }
+        }
+
+        //  Sets the maximal amount of memory to cache, in bytes.
+        inline void set_limit (uint64_t limit_)
+        {
+            sync.lock ();
+            limit = limit_;
+            while (head && cached * chunk_size > limit) {
+                item_t *item = head;
+                head = head->next;
+                free (item);
+                cached--;
+            }
+            sync.unlock ();
+        }
+
+        inline uint64_t get_limit ()
+        {
+            sync.lock ();
+            uint64_t result = limit;
+            sync.unlock ();
+            return result;
+        }
+
+        //  Returns the amount of memory currently cached, in bytes.
+        inline uint64_t get_cached ()
+        {
+            sync.lock ();
+            uint64_t result = cached * chunk_size;
+            sync.unlock ();
+            return result;
+        }
+
+        //  Returns a chunk of the specified size.
+        inline void *alloc (size_t size_)
+        {
+            sync.lock ();
+            item_t *item = head;
+            if (item) {
+                zmq_assert (size_ == chunk_size);
+                head = item->next;
+                cached--;
+            }
+            sync.unlock ();
+
+            if (!item) {
+                item = (item_t*) malloc (size_);
+                alloc_assert (item);
+            }
+            return item;
+        }
+
+        //  Returns the chunk to the cache or frees it if the cache is full.
+        inline void release (void *chunk_, size_t size_)
+        {
+            item_t *item = (item_t*) chunk_;
+            sync.lock ();
+            if (!chunk_size)
+                chunk_size = size_;
+            zmq_assert (size_ == chunk_size);
+            if ((cached + 1) * chunk_size <= limit) {
+                item->next = head;
+                head = item;
+                cached++;
+                item = NULL;
+            }
+            sync.unlock ();
+
+            if (item)
+                free (item);
+        }
+
+    private:
+
+        //  Cached chunk is used to link the list of cached chunks.
+        struct item_t
+        {
+            item_t *next;
+        };
+
+        //  List of cached chunks.
+        item_t *head;
+
+        //  Size of the chunks, set when the first chunk is returned.
+        size_t chunk_size;
+
+        //  Number of cached chunks.
+        uint64_t cached;
+
+        //  Maximal size of the cache in bytes.
+        uint64_t limit;
+
+        //  The cache is accessed from both the writer and the reader thread
+        //  of each pipe.
+        mutex_t sync;
+
+        chunk_pool_t (const chunk_pool_t&);
+        const chunk_pool_t &operator = (const chunk_pool_t&);
+    };
+
+}
+
+#endif
@@ -50,6 +50,7 @@ namespace zmq
             activate_read,
             activate_write,
             hiccup,
+            urgent_lane,
             pipe_term,
             pipe_term_ack,
             term_req,
@@ -94,9 +95,12 @@ namespace zmq
             } activate_read;
 
             //  Sent by pipe reader to inform pipe writer about how many
-            //  messages it has read so far.
+            //  messages and bytes it has read so far. Urgent messages are
+            //  also counted separately.
             struct {
                 uint64_t msgs_read;
+                uint64_t bytes_read;
+                uint64_t urgent_msgs_read;
             } activate_write;
 
             //  Sent by pipe reader to writer after creating a new inpipe.
@@ -106,6 +110,12 @@ namespace zmq
                 void *pipe;
             } hiccup;
 
+            //  Sent by pipe writer to reader after creating the lane for
+            //  urgent messages. The parameter is of type pipe_t::upipe_t.
+            struct {
+                void *pipe;
+            } urgent_lane;
+
             //  Sent by pipe reader to pipe writer to ask it to terminate
             //  its end of the pipe.
             struct {
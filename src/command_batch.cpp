@@ -0,0 +1,168 @@
+/*
+    Copyright (c) 2009-2011 250bpm s.r.o.
+    Copyright (c) 2007-2011 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "command_batch.hpp"
+#include "object.hpp"
+#include "ctx.hpp"
+#include "err.hpp"
+
+zmq::command_batch_t::command_batch_t (ctx_t *ctx_) :
+    ctx (ctx_),
+    generation (1),
+    coalesced (0),
+    commands_saved (0),
+    signals_saved (0)
+{
+    position_t empty = {NULL, 0, 0, 0};
+    positions.resize (64, empty);
+    commands.reserve (positions.size () / 2);
+    sorted.reserve (positions.size () / 2);
+}
+
+zmq::command_batch_t::~command_batch_t ()
+{
+    zmq_assert (commands.empty ());
+}
+
+void zmq::command_batch_t::post (const command_t &cmd_)
+{
+    zmq_assert (cmd_.type == command_t::activate_read ||
+        cmd_.type == command_t::activate_write);
+
+    //  Activation carries the reader's absolute position in the pipe, so
+    //  the latest one supersedes any pending one.
+    position_t *position = &find (cmd_);
+    if (position->generation == generation) {
+        commands [position->pos] = cmd_;
+        coalesced++;
+        return;
+    }
+
+    if ((commands.size () + 1) * 2 > positions.size ()) {
+        grow ();
+        position = &find (cmd_);
+    }
+    position->destination = cmd_.destination;
+    position->type = cmd_.type;
+    position->generation = generation;
+    position->pos = commands.size ();
+    commands.push_back (cmd_);
+}
+
+void zmq::command_batch_t::flush ()
+{
+    if (commands.empty ())
+        return;
+
+    //  Group the commands by destination thread, keeping the order of
+    //  the commands to each thread. First, count the commands per thread.
+    for (commands_t::size_type i = 0; i != commands.size (); i++) {
+        uint32_t tid = commands [i].destination->get_tid ();
+        if (tid >= counts.size ())
+            counts.resize (tid + 1, 0);
+        if (!counts [tid]++)
+            tids.push_back (tid);
+    }
+
+    //  Turn the counts into the positions of the groups.
+    uint32_t pos = 0;
+    for (std::vector <uint32_t>::size_type i = 0; i != tids.size (); i++) {
+        uint32_t count = counts [tids [i]];
+        counts [tids [i]] = pos;
+        pos += count;
+    }
+
+    //  Copy the commands to their groups. Afterwards, each position points
+    //  to the end of its group.
+    sorted.resize (commands.size ());
+    for (commands_t::size_type i = 0; i != commands.size (); i++)
+        sorted [counts [commands [i].destination->get_tid ()]++] =
+            commands [i];
+
+    uint64_t merged = 0;
+    uint32_t begin = 0;
+    for (std::vector <uint32_t>::size_type i = 0; i != tids.size (); i++) {
+        uint32_t end = counts [tids [i]];
+        ctx->send_commands (tids [i], &sorted [begin], end - begin);
+        merged += end - begin - 1;
+        counts [tids [i]] = 0;
+        begin = end;
+    }
+    tids.clear ();
+
+    sync.lock ();
+    commands_saved += coalesced;
+    signals_saved += merged;
+    sync.unlock ();
+    coalesced = 0;
+
+    commands.clear ();
+
+    //  Forget the positions of the delivered commands. Once the generation
+    //  number wraps around, the stale entries have to be cleared for real.
+    if (!++generation) {
+        for (positions_t::size_type i = 0; i != positions.size (); i++)
+            positions [i].generation = 0;
+        generation = 1;
+    }
+}
+
+zmq::command_batch_t::position_t &zmq::command_batch_t::find (
+    const command_t &cmd_)
+{
+    //  The pointers are aligned, so the low bits carry no information.
+    size_t hash = ((size_t) cmd_.destination >> 4) * 2 + cmd_.type;
+    size_t mask = positions.size () - 1;
+    size_t i = (hash * 2654435761u) & mask;
+    while (positions [i].generation == generation &&
+          (positions [i].destination != cmd_.destination ||
+          positions [i].type != cmd_.type))
+        i = (i + 1) & mask;
+    return positions [i];
+}
+
+void zmq::command_batch_t::grow ()
+{
+    position_t empty = {NULL, 0, 0, 0};
+    positions.assign (positions.size () * 2, empty);
+    for (commands_t::size_type i = 0; i != commands.size (); i++) {
+        position_t &position = find (commands [i]);
+        position.destination = commands [i].destination;
+        position.type = commands [i].type;
+        position.generation = generation;
+        position.pos = i;
+    }
+}
+
+uint64_t zmq::command_batch_t::get_commands_saved ()
+{
+    sync.lock ();
+    uint64_t result = commands_saved;
+    sync.unlock ();
+    return result;
+}
+
+uint64_t zmq::command_batch_t::get_signals_saved ()
+{
+    sync.lock ();
+    uint64_t result = signals_saved;
+    sync.unlock ();
+    return result;
+}
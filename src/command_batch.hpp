@@ -0,0 +1,119 @@
+/*
+    Copyright (c) 2009-2011 250bpm s.r.o.
+    Copyright (c) 2007-2011 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __ZMQ_COMMAND_BATCH_HPP_INCLUDED__
+#define __ZMQ_COMMAND_BATCH_HPP_INCLUDED__
+
+#include <vector>
+
+#include "command.hpp"
+#include "mutex.hpp"
+#include "stdint.hpp"
+
+namespace zmq
+{
+
+    class ctx_t;
+    class object_t;
+
+    //  Collects the pipe activation commands sent from an I/O thread during
+    //  single iteration of its event loop. Activations of the same type
+    //  sent to the same pipe are coalesced into one, the rest is delivered
+    //  to each destination mailbox in one go when the batch is flushed.
+    //  The batch is accessed exclusively from its I/O thread, except for
+    //  the statistics. All the containers keep their capacity between
+    //  flushes, so once they've grown to the usual batch size, neither
+    //  posting nor flushing allocates memory.
+
+    class command_batch_t
+    {
+    public:
+
+        command_batch_t (zmq::ctx_t *ctx_);
+        ~command_batch_t ();
+
+        //  Adds a command to the batch.
+        void post (const command_t &cmd_);
+
+        //  Delivers all the commands in the batch.
+        void flush ();
+
+        //  Number of commands made redundant by later commands of the same
+        //  type to the same destination.
+        uint64_t get_commands_saved ();
+
+        //  Number of mailbox writes, each of which may have caused a signal
+        //  to the destination thread, avoided by delivering several commands
+        //  to the same mailbox at once.
+        uint64_t get_signals_saved ();
+
+    private:
+
+        zmq::ctx_t *ctx;
+
+        //  Commands in the order they were posted.
+        typedef std::vector <command_t> commands_t;
+        commands_t commands;
+
+        //  Position of the pending command of particular type to particular
+        //  destination. Open-addressed hash table with linear probing, kept
+        //  at most half full. Entries from before the last flush are told
+        //  apart by the generation number rather than being cleared.
+        struct position_t
+        {
+            object_t *destination;
+            int type;
+            uint32_t generation;
+            commands_t::size_type pos;
+        };
+        typedef std::vector <position_t> positions_t;
+        positions_t positions;
+        uint32_t generation;
+
+        //  Returns the entry for the command's type and destination, either
+        //  the one in use or the empty one to use.
+        position_t &find (const command_t &cmd_);
+
+        //  Doubles the size of the hash table.
+        void grow ();
+
+        //  Commands grouped by destination thread when flushing.
+        commands_t sorted;
+
+        //  Number of commands to each thread, indexed by the thread ID, and
+        //  the IDs of the threads with any commands in the batch.
+        std::vector <uint32_t> counts;
+        std::vector <uint32_t> tids;
+
+        //  Number of commands coalesced since the last flush.
+        uint64_t coalesced;
+
+        //  Statistics, synchronised as they are read by other threads.
+        uint64_t commands_saved;
+        uint64_t signals_saved;
+        mutex_t sync;
+
+        command_batch_t (const command_batch_t&);
+        const command_batch_t &operator = (const command_batch_t&);
+    };
+
+}
+
+#endif
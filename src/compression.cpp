@@ -0,0 +1,197 @@
+/*
+    Copyright (c) 2009-2011 250bpm s.r.o.
+    Copyright (c) 2007-2011 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <new>
+
+#include "compression.hpp"
+#include "lz_codec.hpp"
+#include "config.hpp"
+#include "wire.hpp"
+#include "err.hpp"
+#include "../include/zmq.h"
+
+//  Creates the codec with the specified ID. Returns NULL if the ID
+//  is unknown.
+static zmq::i_codec *create_codec (int id_)
+{
+    zmq::i_codec *codec = NULL;
+    switch (id_) {
+    case ZMQ_COMPRESSION_LZ:
+        codec = new (std::nothrow) zmq::lz_codec_t;
+        alloc_assert (codec);
+        break;
+    }
+    return codec;
+}
+
+zmq::compressor_t::compressor_t (int codec_) :
+    codec_id (codec_),
+    greeting_sent (false)
+{
+    codec = create_codec (codec_id);
+    zmq_assert (codec);
+
+    raw = (unsigned char*) malloc (out_batch_size);
+    alloc_assert (raw);
+    block_capacity = compression_greeting_size + compression_header_size +
+        codec->bound (out_batch_size);
+    block = (unsigned char*) malloc (block_capacity);
+    alloc_assert (block);
+}
+
+zmq::compressor_t::~compressor_t ()
+{
+    free (block);
+    free (raw);
+    delete codec;
+}
+
+void zmq::compressor_t::get_buffer (unsigned char **data_, size_t *size_)
+{
+    *data_ = raw;
+    *size_ = out_batch_size;
+}
+
+void zmq::compressor_t::compress (size_t raw_size_, unsigned char **data_,
+    size_t *size_)
+{
+    zmq_assert (raw_size_ > 0 && raw_size_ <= out_batch_size);
+
+    unsigned char *pos = block;
+    if (!greeting_sent) {
+        put_uint8 (pos, 0);
+        put_uint8 (pos + 1, (uint8_t) codec_id);
+        pos += compression_greeting_size;
+        greeting_sent = true;
+    }
+
+    //  If the data don't compress, they are sent as they are.
+    unsigned char *payload = pos + compression_header_size;
+    size_t payload_size = codec->compress (raw, raw_size_, payload);
+    if (payload_size >= raw_size_) {
+        memcpy (payload, raw, raw_size_);
+        payload_size = raw_size_;
+    }
+    put_uint32 (pos, (uint32_t) raw_size_);
+    put_uint32 (pos + 4, (uint32_t) payload_size);
+
+    *data_ = block;
+    *size_ = payload + payload_size - block;
+}
+
+size_t zmq::compressor_t::buffer_size ()
+{
+    return out_batch_size + block_capacity;
+}
+
+zmq::decompressor_t::decompressor_t () :
+    codec (NULL),
+    in_begin (0),
+    in_end (0)
+{
+    //  Compressed payload is always smaller than the uncompressed data.
+    in_capacity = compression_greeting_size + compression_header_size +
+        max_compressed_block;
+    in = (unsigned char*) malloc (in_capacity);
+    alloc_assert (in);
+    out = (unsigned char*) malloc (max_compressed_block);
+    alloc_assert (out);
+}
+
+zmq::decompressor_t::~decompressor_t ()
+{
+    free (out);
+    free (in);
+    delete codec;
+}
+
+void zmq::decompressor_t::get_buffer (unsigned char **data_, size_t *size_)
+{
+    //  Move the incomplete block to the beginning of the buffer.
+    if (in_begin) {
+        memmove (in, in + in_begin, in_end - in_begin);
+        in_end -= in_begin;
+        in_begin = 0;
+    }
+    *data_ = in + in_end;
+    *size_ = in_capacity - in_end;
+}
+
+void zmq::decompressor_t::filled (size_t size_)
+{
+    zmq_assert (in_end + size_ <= in_capacity);
+    in_end += size_;
+}
+
+int zmq::decompressor_t::decompress (unsigned char **data_, size_t *size_)
+{
+    if (unlikely (!codec)) {
+        if (in_end - in_begin < compression_greeting_size) {
+            errno = EAGAIN;
+            return -1;
+        }
+        if (get_uint8 (in + in_begin) != 0) {
+            errno = ENOCOMPATPROTO;
+            return -1;
+        }
+        codec = create_codec (get_uint8 (in + in_begin + 1));
+        if (!codec) {
+            errno = ENOCOMPATPROTO;
+            return -1;
+        }
+        in_begin += compression_greeting_size;
+    }
+
+    if (in_end - in_begin < compression_header_size) {
+        errno = EAGAIN;
+        return -1;
+    }
+    size_t raw_size = get_uint32 (in + in_begin);
+    size_t payload_size = get_uint32 (in + in_begin + 4);
+    if (raw_size == 0 || raw_size > max_compressed_block ||
+          payload_size > raw_size) {
+        errno = ENOCOMPATPROTO;
+        return -1;
+    }
+    if (in_end - in_begin < compression_header_size + payload_size) {
+        errno = EAGAIN;
+        return -1;
+    }
+
+    unsigned char *payload = in + in_begin + compression_header_size;
+    if (payload_size == raw_size)
+        memcpy (out, payload, raw_size);
+    else if (codec->decompress (payload, payload_size, out, raw_size) != 0) {
+        errno = ENOCOMPATPROTO;
+        return -1;
+    }
+    in_begin += compression_header_size + payload_size;
+
+    *data_ = out;
+    *size_ = raw_size;
+    return 0;
+}
+
+size_t zmq::decompressor_t::buffer_size ()
+{
+    return in_capacity + max_compressed_block;
+}
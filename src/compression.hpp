@@ -0,0 +1,125 @@
+/*
+    Copyright (c) 2009-2011 250bpm s.r.o.
+    Copyright (c) 2007-2011 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __ZMQ_COMPRESSION_HPP_INCLUDED__
+#define __ZMQ_COMPRESSION_HPP_INCLUDED__
+
+#include <stddef.h>
+
+#include "i_codec.hpp"
+
+namespace zmq
+{
+
+    //  Compressed stream starts with a greeting consisting of a zero byte,
+    //  which is never the first byte of an uncompressed stream, and the ID
+    //  of the codec. It is followed by blocks, each of them preceded by
+    //  4-byte size of the uncompressed data and 4-byte size of the payload.
+    //  If the two are equal, the payload is not compressed.
+
+    enum {
+        compression_greeting_size = 2,
+        compression_header_size = 8
+    };
+
+    //  Compresses batches of encoded data into blocks.
+
+    class compressor_t
+    {
+    public:
+
+        //  Codec is one of ZMQ_COMPRESSION_* values other than none.
+        compressor_t (int codec_);
+        ~compressor_t ();
+
+        //  Returns the buffer the data to compress are to be encoded to.
+        void get_buffer (unsigned char **data_, size_t *size_);
+
+        //  Compresses raw_size_ bytes placed to the buffer returned by
+        //  get_buffer. Returns the block to send in data_ and size_.
+        void compress (size_t raw_size_, unsigned char **data_,
+            size_t *size_);
+
+        //  Returns the memory held by the buffers.
+        size_t buffer_size ();
+
+    private:
+
+        int codec_id;
+        i_codec *codec;
+
+        //  Data to compress.
+        unsigned char *raw;
+
+        //  The compressed block, preceded by the greeting till it is sent.
+        unsigned char *block;
+        size_t block_capacity;
+        bool greeting_sent;
+
+        compressor_t (const compressor_t&);
+        const compressor_t &operator = (const compressor_t&);
+    };
+
+    //  Reassembles the blocks of a compressed stream and decompresses them.
+
+    class decompressor_t
+    {
+    public:
+
+        decompressor_t ();
+        ~decompressor_t ();
+
+        //  Returns the free space the data read from the network are
+        //  to be placed to.
+        void get_buffer (unsigned char **data_, size_t *size_);
+
+        //  Accounts size_ bytes placed to the buffer.
+        void filled (size_t size_);
+
+        //  Decompresses the next block. Returns the uncompressed data valid
+        //  till the next call. If there's no complete block, -1 is returned
+        //  and errno is set to EAGAIN. If the stream is malformed or uses
+        //  an unknown codec, errno is set to ENOCOMPATPROTO.
+        int decompress (unsigned char **data_, size_t *size_);
+
+        //  Returns the memory held by the buffers.
+        size_t buffer_size ();
+
+    private:
+
+        //  Codec announced by the greeting, NULL if it wasn't read yet.
+        i_codec *codec;
+
+        //  Data read from the network.
+        unsigned char *in;
+        size_t in_capacity;
+        size_t in_begin;
+        size_t in_end;
+
+        //  Decompressed data.
+        unsigned char *out;
+
+        decompressor_t (const decompressor_t&);
+        const decompressor_t &operator = (const decompressor_t&);
+    };
+
+}
+
+#endif
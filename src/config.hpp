@@ -60,6 +60,56 @@ namespace zmq
         //  unnecessary network stack traversals.
         out_batch_size = 8192,
 
+        //  Maximal size of a single message carrying a batch of subscriptions.
+        //  Subscriptions are sent in batches when the connection to the
+        //  publisher is (re)established.
+        subscription_batch_size = 8192,
+
+        //  Maximal number of messages passed between the session and
+        //  the engine in one go.
+        msg_batch_size = 32,
+
+        //  Maximal number of urgent messages written to the pipe and not yet
+        //  read by the peer. Urgent messages are admitted within this
+        //  allowance even if the pipe is full of other messages.
+        urgent_hwm = 16,
+
+        //  Size of the part of the spool file mapped into memory at once.
+        //  Must be a multiple of the page size.
+        spool_chunk_size = 1024 * 1024,
+
+        //  Number of spool chunks written between two syncs of the file.
+        spool_sync_chunks = 16,
+
+        //  Default maximal amount of memory in bytes held by the context-wide
+        //  cache of message queue chunks. The cache is off by default as
+        //  every borrowed and returned chunk takes the cache's lock.
+        chunk_cache_size = 0,
+
+        //  Size of the data area of each of the two ring buffers shared by
+        //  the peers of a shm:// connection. Must be a power of 2.
+        shm_ring_size = 512 * 1024,
+
+        //  Size of the datagrams the messages sent over udp:// are packed
+        //  into. It is chosen to fit into a single Ethernet frame. Messages
+        //  larger than that are sent in datagrams of their own.
+        udp_datagram_size = 1472,
+
+        //  Maximal number of datagrams passed to the kernel by a single
+        //  sendmmsg or recvmmsg call.
+        udp_batch_size = 16,
+
+        //  Maximal amount of uncompressed data in a single block sent over
+        //  a compressed connection. The blocks are never larger than
+        //  out_batch_size, the limit bounds the blocks accepted from peers.
+        //  Must not exceed 64kB.
+        max_compressed_block = 65536,
+
+        //  Size of CPU cache line. Data accessed by different threads are
+        //  kept this far apart so that the threads don't invalidate each
+        //  other's caches. It is safe to overestimate the value.
+        cache_line_size = 64,
+
         //  Maximal delta between high and low watermark.
         max_wm_delta = 1024,
 
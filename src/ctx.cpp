@@ -91,6 +91,107 @@ bool zmq::ctx_t::get_thread_safe() const
   return thread_safe_flag;
 }
 
+int zmq::ctx_t::set (int option_, const void *optval_, size_t optvallen_)
+{
+    switch (option_) {
+
+    case ZMQ_CTX_MEMORY_LIMIT:
+
+        //  The limit is accounted in 64-byte blocks by a 32-bit counter.
+        if (optvallen_ != sizeof (int64_t) || *((int64_t*) optval_) < 0 ||
+              *((int64_t*) optval_) > ((int64_t) 1 << 37)) {
+            errno = EINVAL;
+            return -1;
+        }
+        memory_budget.set_limit (*((int64_t*) optval_));
+        return 0;
+
+    case ZMQ_CTX_CHUNK_CACHE:
+        if (optvallen_ != sizeof (int64_t) || *((int64_t*) optval_) < 0) {
+            errno = EINVAL;
+            return -1;
+        }
+        chunk_pool.set_limit (*((int64_t*) optval_));
+        return 0;
+    }
+
+    errno = EINVAL;
+    return -1;
+}
+
+int zmq::ctx_t::get (int option_, void *optval_, size_t *optvallen_)
+{
+    switch (option_) {
+
+    case ZMQ_CTX_MEMORY_LIMIT:
+        if (*optvallen_ < sizeof (int64_t)) {
+            errno = EINVAL;
+            return -1;
+        }
+        *((int64_t*) optval_) = memory_budget.get_limit ();
+        *optvallen_ = sizeof (int64_t);
+        return 0;
+
+    case ZMQ_CTX_MEMORY_USED:
+        if (*optvallen_ < sizeof (int64_t)) {
+            errno = EINVAL;
+            return -1;
+        }
+        *((int64_t*) optval_) = memory_budget.get_used ();
+        *optvallen_ = sizeof (int64_t);
+        return 0;
+
+    case ZMQ_CTX_CHUNK_CACHE:
+        if (*optvallen_ < sizeof (int64_t)) {
+            errno = EINVAL;
+            return -1;
+        }
+        *((int64_t*) optval_) = chunk_pool.get_limit ();
+        *optvallen_ = sizeof (int64_t);
+        return 0;
+
+    case ZMQ_CTX_CHUNK_CACHED:
+        if (*optvallen_ < sizeof (int64_t)) {
+            errno = EINVAL;
+            return -1;
+        }
+        *((int64_t*) optval_) = chunk_pool.get_cached ();
+        *optvallen_ = sizeof (int64_t);
+        return 0;
+
+    case ZMQ_CTX_COMMANDS_SAVED:
+    case ZMQ_CTX_SIGNALS_SAVED:
+        {
+            if (*optvallen_ < sizeof (int64_t)) {
+                errno = EINVAL;
+                return -1;
+            }
+            int64_t saved = 0;
+            for (io_threads_t::size_type i = 0; i != io_threads.size (); i++) {
+                command_batch_t *batch = io_threads [i]->get_command_batch ();
+                saved += option_ == ZMQ_CTX_COMMANDS_SAVED ?
+                    batch->get_commands_saved () : batch->get_signals_saved ();
+            }
+            *((int64_t*) optval_) = saved;
+            *optvallen_ = sizeof (int64_t);
+            return 0;
+        }
+    }
+
+    errno = EINVAL;
+    return -1;
+}
+
+zmq::memory_budget_t *zmq::ctx_t::get_memory_budget ()
+{
+    return memory_budget.get_limit () ? &memory_budget : NULL;
+}
+
+zmq::chunk_pool_t *zmq::ctx_t::get_chunk_pool ()
+{
+    return chunk_pool.get_limit () ? &chunk_pool : NULL;
+}
+
 bool zmq::ctx_t::check_tag ()
 {
     return tag == 0xbadcafe0;
@@ -235,6 +336,21 @@ void zmq::ctx_t::send_command (uint32_t tid_, const command_t &command_)
     slots [tid_]->send (command_);
 }
 
+void zmq::ctx_t::send_commands (uint32_t tid_, const command_t *commands_,
+    size_t count_)
+{
+    slots [tid_]->send (commands_, count_);
+}
+
+zmq::command_batch_t *zmq::ctx_t::get_command_batch (uint32_t tid_)
+{
+    //  Only I/O threads batch the commands. The list of I/O threads doesn't
+    //  change after the context is created, so no locking is needed.
+    if (tid_ < 2 || tid_ >= io_threads.size () + 2)
+        return NULL;
+    return io_threads [tid_ - 2]->get_command_batch ();
+}
+
 zmq::io_thread_t *zmq::ctx_t::choose_io_thread (uint64_t affinity_)
 {
     if (io_threads.empty ())
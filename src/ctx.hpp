@@ -33,6 +33,8 @@
 #include "mutex.hpp"
 #include "stdint.hpp"
 #include "options.hpp"
+#include "memory_budget.hpp"
+#include "chunk_pool.hpp"
 
 namespace zmq
 {
@@ -41,6 +43,7 @@ namespace zmq
     class io_thread_t;
     class socket_base_t;
     class reaper_t;
+    class command_batch_t;
 
     //  Information associated with inproc endpoint. Note that endpoint options
     //  are registered as well so that the peer can access them without a need
@@ -78,6 +81,15 @@ namespace zmq
         //  Send command to the destination thread.
         void send_command (uint32_t tid_, const command_t &command_);
 
+        //  Send several commands to the destination thread at once.
+        void send_commands (uint32_t tid_, const command_t *commands_,
+            size_t count_);
+
+        //  Returns the batch to collect the pipe activations sent from
+        //  the specified thread in, or NULL if the thread doesn't batch
+        //  commands.
+        zmq::command_batch_t *get_command_batch (uint32_t tid_);
+
         //  Returns the I/O thread that is the least busy at the moment.
         //  Affinity specifies which I/O threads are eligible (0 = all).
         //  Returns NULL is no I/O thread is available.
@@ -103,6 +115,21 @@ namespace zmq
         void set_thread_safe();
         bool get_thread_safe() const;
 
+        //  Set and get context options.
+        int set (int option_, const void *optval_, size_t optvallen_);
+        int get (int option_, void *optval_, size_t *optvallen_);
+
+        //  Returns the memory budget to account the messages to, or NULL
+        //  if there's no memory limit. The result is fixed at the time
+        //  the pipe or engine is created.
+        zmq::memory_budget_t *get_memory_budget ();
+
+        //  Returns the cache of message queue chunks shared by all the pipes,
+        //  or NULL if the cache is switched off, in which case the pipe
+        //  allocates the chunks directly. The result is fixed at the time
+        //  the pipe is created.
+        zmq::chunk_pool_t *get_chunk_pool ();
+
         ~ctx_t ();
     private:
 
@@ -157,6 +184,12 @@ namespace zmq
 
         bool thread_safe_flag;
 
+        //  Memory used by all the messages in flight within the context.
+        memory_budget_t memory_budget;
+
+        //  Memory chunks released by the message pipes, ready for reuse.
+        chunk_pool_t chunk_pool;
+
         ctx_t (const ctx_t&);
         const ctx_t &operator = (const ctx_t&);
     };
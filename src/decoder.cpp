@@ -31,10 +31,14 @@
 zmq::decoder_t::decoder_t (size_t bufsize_, int64_t maxmsgsize_) :
     decoder_base_t <decoder_t> (bufsize_),
     session (NULL),
+    first (0),
+    batched (0),
     maxmsgsize (maxmsgsize_)
 {
-    int rc = in_progress.init ();
-    errno_assert (rc == 0);
+    for (int i = 0; i != msg_batch_size; i++) {
+        int rc = batch [i].init ();
+        errno_assert (rc == 0);
+    }
 
     //  At the beginning, read one byte and go to one_byte_size_ready state.
     next_step (tmpbuf, 1, &decoder_t::one_byte_size_ready);
@@ -42,8 +46,10 @@ zmq::decoder_t::decoder_t (size_t bufsize_, int64_t maxmsgsize_) :
 
 zmq::decoder_t::~decoder_t ()
 {
-    int rc = in_progress.close ();
-    errno_assert (rc == 0);
+    for (int i = 0; i != msg_batch_size; i++) {
+        int rc = batch [i].close ();
+        errno_assert (rc == 0);
+    }
 }
 
 void zmq::decoder_t::set_session (session_base_t *session_)
@@ -51,8 +57,129 @@ void zmq::decoder_t::set_session (session_base_t *session_)
     session = session_;
 }
 
+size_t zmq::decoder_t::process_buffer (unsigned char *data_, size_t size_)
+{
+    //  Messages left over from the last time go first. If the session still
+    //  doesn't accept them, no more data can be processed.
+    if (unlikely (first != batched) && push () != 0 && errno == EAGAIN)
+        return 0;
+
+    //  Small frames are decoded by the fast scan. The state machine is
+    //  used only for the frames the scan can't handle, typically those
+    //  crossing the buffer boundary, taking one action at a time so that
+    //  the scan resumes as soon as the next frame boundary is reached.
+    size_t processed = 0;
+    while (true) {
+        if (pending_step () == &decoder_t::one_byte_size_ready &&
+              pending_size () == 1)
+            processed += scan (data_ + processed, size_ - processed);
+
+        //  Even with no data left, the action that couldn't be taken
+        //  the last time is retried.
+        if (processed == size_ && pending_size ())
+            break;
+
+        size_t chunk = std::min (size_ - processed, pending_size ());
+        size_t rc = decoder_base_t <decoder_t>::process_buffer (
+            data_ + processed, chunk);
+        if (unlikely (rc == (size_t) -1)) {
+            processed = rc;
+            break;
+        }
+        processed += rc;
+
+        //  The action couldn't be taken, the session doesn't accept
+        //  more messages.
+        if (!pending_size ())
+            break;
+    }
+
+    //  Pass on the messages decoded so far, even if the rest of the data
+    //  is malformed.
+    if (first != batched && push () != 0 && errno != EAGAIN)
+        return (size_t) -1;
+
+    return processed;
+}
+
+size_t zmq::decoder_t::scan (unsigned char *data_, size_t size_)
+{
+    if (unlikely (!session))
+        return 0;
+
+    unsigned char *pos = data_;
+    unsigned char *end = data_ + size_;
+    while (end - pos >= 2) {
+
+        //  The frame has to be complete. Frames with 8-byte size and
+        //  malformed frames are left to the state machine.
+        size_t size = *pos;
+        if (unlikely (size == 0 || size == 0xff ||
+              size >= (size_t) (end - pos)))
+            break;
+        if (maxmsgsize >= 0 && (int64_t) (size - 1) > maxmsgsize)
+            break;
+
+        //  Same as in one_byte_size_ready.
+        if (unlikely (batched == msg_batch_size) && first != batched &&
+              push () != 0)
+            break;
+        if (first == batched)
+            first = batched = 0;
+
+        msg_t &msg = batch [batched];
+        int rc = msg.init_size (size - 1);
+        if (unlikely (rc != 0)) {
+            errno_assert (errno == ENOMEM);
+            rc = msg.init ();
+            errno_assert (rc == 0);
+            break;
+        }
+        msg.set_flags (pos [1] & ~(msg_t::stamp | msg_t::urgent));
+        copy_body ((unsigned char*) msg.data (), pos + 2, size - 1);
+        batched++;
+        pos += size + 1;
+    }
+    return pos - data_;
+}
+
+bool zmq::decoder_t::stuck ()
+{
+    return first != batched;
+}
+
+int zmq::decoder_t::push ()
+{
+    if (unlikely (!session)) {
+        errno = EAGAIN;
+        return -1;
+    }
+
+    //  The messages that were not accepted stay in place for the next
+    //  attempt. They can't be moved as the message being decoded follows
+    //  them and its buffer may be in use by the engine.
+    first += session->write_batch (batch + first, batched - first);
+    if (likely (first == batched))
+        return 0;
+
+    int err = errno;
+    if (err != EAGAIN)
+        decoding_error ();
+    errno = err;
+    return -1;
+}
+
 bool zmq::decoder_t::one_byte_size_ready ()
 {
+    //  New message is about to be decoded. If the batch is full, wait till
+    //  the session accepts the messages in it. Once all the messages were
+    //  passed on, start filling the batch from the beginning again.
+    if (unlikely (batched == msg_batch_size) && first != batched &&
+          push () != 0)
+        return false;
+    if (first == batched)
+        first = batched = 0;
+
     //  First byte of size is read. If it is 0xff read 8-byte size.
     //  Otherwise allocate the buffer for message data and read the
     //  message data into it.
@@ -66,18 +193,18 @@ bool zmq::decoder_t::one_byte_size_ready ()
             return false;
         }
 
-        //  in_progress is initialised at this point so in theory we should
-        //  close it before calling zmq_msg_init_size, however, it's a 0-byte
-        //  message and thus we can treat it as uninitialised...
+        //  The batch slot is initialised at this point so in theory we
+        //  should close it before calling zmq_msg_init_size, however, it's
+        //  a 0-byte message and thus we can treat it as uninitialised...
         int rc;
         if (maxmsgsize >= 0 && (int64_t) (*tmpbuf - 1) > maxmsgsize) {
             rc = -1;
             errno = ENOMEM;
         }
         else
-            rc = in_progress.init_size (*tmpbuf - 1);
+            rc = batch [batched].init_size (*tmpbuf - 1);
         if (rc != 0 && errno == ENOMEM) {
-            rc = in_progress.init ();
+            rc = batch [batched].init ();
             errno_assert (rc == 0);
             decoding_error ();
             return false;
@@ -101,7 +228,7 @@ bool zmq::decoder_t::eight_byte_size_ready ()
         return false;
     }
 
-    //  in_progress is initialised at this point so in theory we should
+    //  The batch slot is initialised at this point so in theory we should
     //  close it before calling zmq_msg_init_size, however, it's a 0-byte
     //  message and thus we can treat it as uninitialised...
     int rc;
@@ -110,9 +237,9 @@ bool zmq::decoder_t::eight_byte_size_ready ()
         errno = ENOMEM;
     }
     else
-        rc = in_progress.init_size (size - 1);
+        rc = batch [batched].init_size (size - 1);
     if (rc != 0 && errno == ENOMEM) {
-        rc = in_progress.init ();
+        rc = batch [batched].init ();
         errno_assert (rc == 0);
         decoding_error ();
         return false;
@@ -125,10 +252,12 @@ bool zmq::decoder_t::eight_byte_size_ready ()
 
 bool zmq::decoder_t::flags_ready ()
 {
-    //  Store the flags from the wire into the message structure.
-    in_progress.set_flags (tmpbuf [0]);
+    //  Store the flags from the wire into the message structure. Deadline
+    //  stamps and urgency are local to the pipes and can't be passed from
+    //  the peer.
+    batch [batched].set_flags (tmpbuf [0] & ~(msg_t::stamp | msg_t::urgent));
 
-    next_step (in_progress.data (), in_progress.size (),
+    next_step (batch [batched].data (), batch [batched].size (),
         &decoder_t::message_ready);
     
     return true;
@@ -136,16 +265,11 @@ bool zmq::decoder_t::flags_ready ()
 
 bool zmq::decoder_t::message_ready ()
 {
-    //  Message is completely read. Push it further and start reading
-    //  new message. (in_progress is a 0-byte message after this point.)
+    //  Message is completely read. Leave it in the batch and start reading
+    //  new message.
     if (unlikely (!session))
         return false;
-    int rc = session->write (&in_progress);
-    if (unlikely (rc != 0)) {
-        if (errno != EAGAIN)
-            decoding_error ();
-        return false;
-    }
+    batched++;
 
     next_step (tmpbuf, 1, &decoder_t::one_byte_size_ready);
     return true;
@@ -30,6 +30,7 @@
 #include "err.hpp"
 #include "msg.hpp"
 #include "stdint.hpp"
+#include "config.hpp"
 
 namespace zmq
 {
@@ -165,6 +166,20 @@ namespace zmq
             next = NULL;
         }
 
+        //  Returns the action to be taken once the data being read are
+        //  complete.
+        inline step_t pending_step ()
+        {
+            return next;
+        }
+
+        //  Returns the amount of data still to be read before taking
+        //  the next action.
+        inline size_t pending_size ()
+        {
+            return to_read;
+        }
+
     private:
 
         //  Where to store the read data.
@@ -197,8 +212,28 @@ namespace zmq
 
         void set_session (zmq::session_base_t *session_);
 
+        //  Decodes the data same as decoder_base_t::process_buffer does,
+        //  but the messages are passed to the session in batches. Messages
+        //  that the session doesn't accept are held till the next call
+        //  which returns zero processed bytes until they are passed on.
+        size_t process_buffer (unsigned char *data_, size_t size_);
+
+        //  Returns true if there are decoded messages that the session
+        //  didn't accept yet.
+        bool stuck ();
+
     private:
 
+        //  Passes the decoded messages to the session. Returns -1 and sets
+        //  errno if some of them were not accepted.
+        int push ();
+
+        //  Decodes the complete frames with 1-byte size at the beginning of
+        //  the buffer directly into the batch, bypassing the state machine.
+        //  Has to be called at the frame boundary. Returns the number of
+        //  bytes decoded. The frame it stops at is left to the state machine.
+        size_t scan (unsigned char *data_, size_t size_);
+
         bool one_byte_size_ready ();
         bool eight_byte_size_ready ();
         bool flags_ready ();
@@ -206,7 +241,13 @@ namespace zmq
 
         zmq::session_base_t *session;
         unsigned char tmpbuf [8];
-        msg_t in_progress;
+
+        //  Messages are decoded in place into the batch. Messages between
+        //  'first' and 'batched' are complete but not yet passed to the
+        //  session; the message being decoded is 'batch [batched]'.
+        msg_t batch [msg_batch_size];
+        size_t first;
+        size_t batched;
 
         int64_t maxmsgsize;
 
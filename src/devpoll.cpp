@@ -125,6 +125,12 @@ void zmq::devpoll_t::reset_pollout (handle_t handle_)
     devpoll_ctl (handle_, fd_table [handle_].events);
 }
 
+bool zmq::devpoll_t::set_edge_triggered (handle_t handle_)
+{
+    //  Edge-triggered polling is not supported.
+    return false;
+}
+
 void zmq::devpoll_t::start ()
 {
     worker.start (worker_routine, this);
@@ -149,6 +155,9 @@ void zmq::devpoll_t::loop ()
         //  Execute any due timers.
         int timeout = (int) execute_timers ();
 
+        //  Deliver the commands batched by the event and timer handlers.
+        flush_commands ();
+
         //  Wait for events.
         //  On Solaris, we can retrieve no more then (OPEN_MAX - 1) events.
         poll_req.dp_fds = &ev_buf [0];
@@ -180,6 +189,8 @@ void zmq::devpoll_t::loop ()
                 fd_ptr->reactor->in_event ();
         }
     }
+
+    flush_commands ();
 }
 
 void zmq::devpoll_t::worker_routine (void *arg_)
@@ -27,10 +27,16 @@
 
 zmq::encoder_t::encoder_t (size_t bufsize_) :
     encoder_base_t <encoder_t> (bufsize_),
-    session (NULL)
+    session (NULL),
+    in_progress (&batch [0]),
+    batch_pos (0),
+    batch_size (0),
+    drained (false)
 {
-    int rc = in_progress.init ();
-    errno_assert (rc == 0);
+    for (int i = 0; i != msg_batch_size; i++) {
+        int rc = batch [i].init ();
+        errno_assert (rc == 0);
+    }
 
     //  Write 0 bytes to the batch and go to message_ready state.
     next_step (NULL, 0, &encoder_t::message_ready, true);
@@ -38,8 +44,10 @@ zmq::encoder_t::encoder_t (size_t bufsize_) :
 
 zmq::encoder_t::~encoder_t ()
 {
-    int rc = in_progress.close ();
-    errno_assert (rc == 0);
+    for (int i = 0; i != msg_batch_size; i++) {
+        int rc = batch [i].close ();
+        errno_assert (rc == 0);
+    }
 }
 
 void zmq::encoder_t::set_session (session_base_t *session_)
@@ -47,39 +55,109 @@ void zmq::encoder_t::set_session (session_base_t *session_)
     session = session_;
 }
 
+size_t zmq::encoder_t::pack (unsigned char *data_, size_t size_, int *first_)
+{
+    drained = false;
+    if (unlikely (!session) || pending_step () != &encoder_t::message_ready)
+        return 0;
+
+    //  Destroy content of the old message. The messages encoded here are
+    //  destroyed straight away.
+    if (in_progress) {
+        int rc = in_progress->close ();
+        errno_assert (rc == 0);
+        rc = in_progress->init ();
+        errno_assert (rc == 0);
+        in_progress = NULL;
+    }
+
+    unsigned char *pos = data_;
+    unsigned char *end = data_ + size_;
+    while (true) {
+
+        //  Same as in message_ready.
+        if (batch_pos == batch_size) {
+            batch_pos = 0;
+            batch_size = session->read_batch (batch, msg_batch_size);
+            if (!batch_size) {
+                errno_assert (errno == EAGAIN);
+                drained = true;
+                break;
+            }
+        }
+
+        //  Messages with 8-byte size and those that don't fit into
+        //  the buffer are left to the state machine.
+        msg_t &msg = batch [batch_pos];
+        size_t size = msg.size ();
+        if (size + 1 >= 255 || size + 2 > (size_t) (end - pos))
+            break;
+
+        //  The header is always two bytes long here: 1-byte size
+        //  followed by the flags.
+        unsigned char flags = msg.flags ();
+        pos [0] = (unsigned char) (size + 1);
+        pos [1] = flags & ~(msg_t::shared | msg_t::urgent);
+        copy_body (pos + 2, (unsigned char*) msg.data (), size);
+        if (*first_ == -1 && !(flags & msg_t::more))
+            *first_ = (int) (pos - data_);
+        pos += size + 2;
+
+        int rc = msg.close ();
+        errno_assert (rc == 0);
+        rc = msg.init ();
+        errno_assert (rc == 0);
+        batch_pos++;
+    }
+    return pos - data_;
+}
+
 bool zmq::encoder_t::size_ready ()
 {
     //  Write message body into the buffer.
-    next_step (in_progress.data (), in_progress.size (),
+    next_step (in_progress->data (), in_progress->size (),
         &encoder_t::message_ready, false);
     return true;
 }
 
 bool zmq::encoder_t::message_ready ()
 {
-    //  Destroy content of the old message.
-    int rc = in_progress.close ();
-    errno_assert (rc == 0);
-
-    //  Read new message. If there is none, return false.
-    //  Note that new state is set only if write is successful. That way
-    //  unsuccessful write will cause retry on the next state machine
-    //  invocation.
-    if (unlikely (!session)) {
-        rc = in_progress.init ();
+    //  Destroy content of the old message, unless pack has done so.
+    if (in_progress) {
+        int rc = in_progress->close ();
         errno_assert (rc == 0);
-        return false;
-    }
-    rc = session->read (&in_progress);
-    if (unlikely (rc != 0)) {
-        errno_assert (errno == EAGAIN);
-        rc = in_progress.init ();
+        rc = in_progress->init ();
         errno_assert (rc == 0);
-        return false;
     }
 
+    //  Read new batch of messages if the current one is used up. If there
+    //  are no messages, return false. Note that new state is set only if
+    //  read is successful. That way unsuccessful read will cause retry on
+    //  the next state machine invocation.
+    if (batch_pos == batch_size) {
+        batch_pos = 0;
+        batch_size = 0;
+        if (unlikely (!session))
+            return false;
+
+        //  Don't ask the session again if pack has just found out there
+        //  are no messages available.
+        if (drained) {
+            drained = false;
+            return false;
+        }
+        batch_size = session->read_batch (batch, msg_batch_size);
+        if (!batch_size) {
+            errno_assert (errno == EAGAIN);
+            return false;
+        }
+    }
+
+    //  The messages are encoded in place.
+    in_progress = &batch [batch_pos++];
+
     //  Get the message size.
-    size_t size = in_progress.size ();
+    size_t size = in_progress->size ();
 
     //  Account for the 'flags' byte.
     size++;
@@ -89,16 +167,18 @@ bool zmq::encoder_t::message_ready ()
     //  message size. In both cases 'flags' field follows.
     if (size < 255) {
         tmpbuf [0] = (unsigned char) size;
-        tmpbuf [1] = (in_progress.flags () & ~msg_t::shared);
+        tmpbuf [1] = (in_progress->flags () &
+            ~(msg_t::shared | msg_t::urgent));
         next_step (tmpbuf, 2, &encoder_t::size_ready,
-            !(in_progress.flags () & msg_t::more));
+            !(in_progress->flags () & msg_t::more));
     }
     else {
         tmpbuf [0] = 0xff;
         put_uint64 (tmpbuf + 1, size);
-        tmpbuf [9] = (in_progress.flags () & ~msg_t::shared);
+        tmpbuf [9] = (in_progress->flags () &
+            ~(msg_t::shared | msg_t::urgent));
         next_step (tmpbuf, 10, &encoder_t::size_ready,
-            !(in_progress.flags () & msg_t::more));
+            !(in_progress->flags () & msg_t::more));
     }
     return true;
 }
@@ -29,6 +29,7 @@
 
 #include "err.hpp"
 #include "msg.hpp"
+#include "config.hpp"
 
 namespace zmq
 {
@@ -37,7 +38,8 @@ namespace zmq
 
     //  Helper base class for encoders. It implements the state machine that
     //  fills the outgoing buffer. Derived classes should implement individual
-    //  state machine actions.
+    //  state machine actions and the pack function (see below) that may
+    //  encode several messages in a single go.
 
     template <typename T> class encoder_base_t
     {
@@ -75,6 +77,24 @@ namespace zmq
 
             while (true) {
 
+                //  If there are no more data to return, let the derived
+                //  class encode whatever it can directly into the buffer.
+                //  It reports the offset of the first message beginning it
+                //  has written, if any.
+                if (!to_write) {
+                    int first = -1;
+                    size_t packed = static_cast <T*> (this)->pack (
+                        buffer + pos, buffersize - pos, &first);
+                    if (offset_ && *offset_ == -1 && first != -1)
+                        *offset_ = (int) (pos + first);
+                    pos += packed;
+                    if (pos == buffersize) {
+                        *data_ = buffer;
+                        *size_ = pos;
+                        return;
+                    }
+                }
+
                 //  If there are no more data to return, run the state machine.
                 //  If there are still no data, return what we already have
                 //  in the buffer.
@@ -143,6 +163,13 @@ namespace zmq
             beginning = beginning_;
         }
 
+        //  Returns the action to be taken once the data being written
+        //  are exhausted.
+        inline step_t pending_step ()
+        {
+            return next;
+        }
+
     private:
 
         //  Where to get the data to write from.
@@ -177,15 +204,31 @@ namespace zmq
 
         void set_session (zmq::session_base_t *session_);
 
+        //  Encodes the messages that fit into the buffer as a whole and
+        //  have 1-byte size, writing the frames in a single pass without
+        //  going through the state machine. Does nothing unless at
+        //  the message boundary. Returns the number of bytes written.
+        size_t pack (unsigned char *data_, size_t size_, int *first_);
+
     private:
 
         bool size_ready ();
         bool message_ready ();
 
         zmq::session_base_t *session;
-        msg_t in_progress;
         unsigned char tmpbuf [10];
 
+        //  Messages fetched from the session. The one being encoded is
+        //  pointed to by in_progress, the ones after it are yet to be encoded.
+        //  in_progress is NULL if there's no message to be destroyed.
+        msg_t batch [msg_batch_size];
+        msg_t *in_progress;
+        size_t batch_pos;
+        size_t batch_size;
+
+        //  True if the last attempt to read a batch in pack failed.
+        bool drained;
+
         encoder_t (const encoder_t&);
         const encoder_t &operator = (const encoder_t&);
     };
@@ -64,6 +64,8 @@ zmq::epoll_t::handle_t zmq::epoll_t::add_fd (fd_t fd_, i_poll_events *events_)
     pe->ev.events = 0;
     pe->ev.data.ptr = pe;
     pe->events = events_;
+    pe->requested = 0;
+    pe->update_scheduled = false;
 
     int rc = epoll_ctl (epoll_fd, EPOLL_CTL_ADD, fd_, &pe->ev);
     errno_assert (rc != -1);
@@ -77,6 +79,8 @@ zmq::epoll_t::handle_t zmq::epoll_t::add_fd (fd_t fd_, i_poll_events *events_)
 void zmq::epoll_t::rm_fd (handle_t handle_)
 {
     poll_entry_t *pe = (poll_entry_t*) handle_;
+    if (pe->update_scheduled)
+        cancel_update (pe);
     int rc = epoll_ctl (epoll_fd, EPOLL_CTL_DEL, pe->fd, &pe->ev);
     errno_assert (rc != -1);
     pe->fd = retired_fd;
@@ -89,31 +93,59 @@ void zmq::epoll_t::rm_fd (handle_t handle_)
 void zmq::epoll_t::set_pollin (handle_t handle_)
 {
     poll_entry_t *pe = (poll_entry_t*) handle_;
-    pe->ev.events |= EPOLLIN;
-    int rc = epoll_ctl (epoll_fd, EPOLL_CTL_MOD, pe->fd, &pe->ev);
-    errno_assert (rc != -1);
+    pe->requested |= EPOLLIN;
+    update (pe);
 }
 
 void zmq::epoll_t::reset_pollin (handle_t handle_)
 {
     poll_entry_t *pe = (poll_entry_t*) handle_;
-    pe->ev.events &= ~((short) EPOLLIN);
-    int rc = epoll_ctl (epoll_fd, EPOLL_CTL_MOD, pe->fd, &pe->ev);
-    errno_assert (rc != -1);
+    pe->requested &= ~((short) EPOLLIN);
+    update (pe);
 }
 
 void zmq::epoll_t::set_pollout (handle_t handle_)
 {
     poll_entry_t *pe = (poll_entry_t*) handle_;
-    pe->ev.events |= EPOLLOUT;
-    int rc = epoll_ctl (epoll_fd, EPOLL_CTL_MOD, pe->fd, &pe->ev);
-    errno_assert (rc != -1);
+    pe->requested |= EPOLLOUT;
+    update (pe);
 }
 
 void zmq::epoll_t::reset_pollout (handle_t handle_)
 {
     poll_entry_t *pe = (poll_entry_t*) handle_;
-    pe->ev.events &= ~((short) EPOLLOUT);
+    pe->requested &= ~((short) EPOLLOUT);
+    update (pe);
+}
+
+bool zmq::epoll_t::set_edge_triggered (handle_t handle_)
+{
+    //  The fd is polled for both input and output for good. Events are
+    //  reported only when the state of the fd changes, it's up to the owner
+    //  to keep track of whether the fd is readable and writable.
+    poll_entry_t *pe = (poll_entry_t*) handle_;
+    pe->requested = EPOLLIN | EPOLLOUT | EPOLLET;
+    update (pe);
+    return true;
+}
+
+void zmq::epoll_t::update (poll_entry_t *pe_)
+{
+    if (!pe_->update_scheduled) {
+        pe_->update_scheduled = true;
+        schedule_update (pe_);
+    }
+}
+
+void zmq::epoll_t::apply_update (void *entry_)
+{
+    //  If the changes made since the last update cancelled each other
+    //  there's nothing to do.
+    poll_entry_t *pe = (poll_entry_t*) entry_;
+    pe->update_scheduled = false;
+    if (pe->ev.events == pe->requested)
+        return;
+    pe->ev.events = pe->requested;
     int rc = epoll_ctl (epoll_fd, EPOLL_CTL_MOD, pe->fd, &pe->ev);
     errno_assert (rc != -1);
 }
@@ -137,6 +169,12 @@ void zmq::epoll_t::loop ()
         //  Execute any due timers.
         int timeout = (int) execute_timers ();
 
+        //  Deliver the commands batched by the event and timer handlers.
+        flush_commands ();
+
+        //  Update the pollset as requested by the handlers.
+        apply_updates ();
+
         //  Wait for events.
         int n = epoll_wait (epoll_fd, &ev_buf [0], max_io_events,
             timeout ? timeout : -1);
@@ -167,6 +205,8 @@ void zmq::epoll_t::loop ()
             delete *it;
         retired.clear ();
     }
+
+    flush_commands ();
 }
 
 void zmq::epoll_t::worker_routine (void *arg_)
@@ -57,6 +57,7 @@ namespace zmq
         void reset_pollin (handle_t handle_);
         void set_pollout (handle_t handle_);
         void reset_pollout (handle_t handle_);
+        bool set_edge_triggered (handle_t handle_);
         void start ();
         void stop ();
 
@@ -68,6 +69,9 @@ namespace zmq
         //  Main event loop.
         void loop ();
 
+        //  Updates the pollset once the events to poll for have changed.
+        void apply_update (void *entry_);
+
         //  Main epoll file descriptor
         fd_t epoll_fd;
 
@@ -76,8 +80,16 @@ namespace zmq
             fd_t fd;
             epoll_event ev;
             zmq::i_poll_events *events;
+
+            //  Events to poll for as requested by the owner. They are
+            //  copied to ev when the scheduled update is applied.
+            uint32_t requested;
+            bool update_scheduled;
         };
 
+        //  Schedules update of the pollset, unless already scheduled.
+        void update (poll_entry_t *pe_);
+
         //  List of retired event sources.
         typedef std::vector <poll_entry_t*> retired_t;
         retired_t retired;
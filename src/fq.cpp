@@ -28,6 +28,7 @@
 zmq::fq_t::fq_t () :
     active (0),
     current (0),
+    served (0),
     more (false)
 {
 }
@@ -54,6 +55,7 @@ void zmq::fq_t::terminated (pipe_t *pipe_)
             current = 0;
     }
     pipes.erase (pipe_);
+    served = 0;
 }
 
 void zmq::fq_t::activated (pipe_t *pipe_)
@@ -94,10 +96,11 @@ int zmq::fq_t::recvpipe (msg_t *msg_, int flags_, pipe_t **pipe_)
                 *pipe_ = pipes [current];
             more =
                 msg_->flags () & msg_t::more ? true : false;
-            if (!more) {
+            if (!more && ++served >= pipes [current]->get_weight ()) {
                 current++;
                 if (current >= active)
                     current = 0;
+                served = 0;
             }
             return 0;
         }
@@ -106,6 +109,7 @@ int zmq::fq_t::recvpipe (msg_t *msg_, int flags_, pipe_t **pipe_)
             pipes.swap (current, active);
             if (current == active)
                 current = 0;
+            served = 0;
         }
     }
 
@@ -136,6 +140,7 @@ bool zmq::fq_t::has_in ()
         pipes.swap (current, active);
         if (current == active)
             current = 0;
+        served = 0;
     }
 
     return false;
@@ -31,7 +31,9 @@ namespace zmq
 
     //  Class manages a set of inbound pipes. On receive it performs fair
     //  queueing so that senders gone berserk won't cause denial of
-    //  service for decent senders.
+    //  service for decent senders. Pipes are served in round-robin fashion,
+    //  each pipe getting to deliver up to as many messages in a row as its
+    //  weight is (deficit round robin with message-sized quantum).
 
     class fq_t
     {
@@ -61,6 +63,9 @@ namespace zmq
         //  Index of the next bound pipe to read a message from.
         pipes_t::size_type current;
 
+        //  Number of messages read from the current pipe in this round.
+        int served;
+
         //  If true, part of a multipart message was already received, but
         //  there are following parts still waiting in the current pipe.
         bool more;
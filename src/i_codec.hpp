@@ -0,0 +1,53 @@
+/*
+    Copyright (c) 2009-2011 250bpm s.r.o.
+    Copyright (c) 2007-2011 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __ZMQ_I_CODEC_HPP_INCLUDED__
+#define __ZMQ_I_CODEC_HPP_INCLUDED__
+
+#include <stddef.h>
+
+namespace zmq
+{
+
+    //  Abstract interface to be implemented by block compression codecs
+    //  applied to the data of stream connections.
+
+    struct i_codec
+    {
+        virtual ~i_codec () {}
+
+        //  Returns the maximal size of compressed form of size_ bytes.
+        virtual size_t bound (size_t size_) = 0;
+
+        //  Compresses in_size_ bytes (at most max_compressed_block) into
+        //  out_ which has to have at least bound (in_size_) bytes. Returns
+        //  the size of compressed data.
+        virtual size_t compress (const unsigned char *in_, size_t in_size_,
+            unsigned char *out_) = 0;
+
+        //  Decompresses in_size_ bytes into out_. Returns -1 if the data
+        //  are malformed or don't decompress to exactly out_size_ bytes.
+        virtual int decompress (const unsigned char *in_, size_t in_size_,
+            unsigned char *out_, size_t out_size_) = 0;
+    };
+
+}
+
+#endif
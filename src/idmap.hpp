@@ -0,0 +1,229 @@
+/*
+    Copyright (c) 2009-2011 250bpm s.r.o.
+    Copyright (c) 2007-2011 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __ZMQ_IDMAP_HPP_INCLUDED__
+#define __ZMQ_IDMAP_HPP_INCLUDED__
+
+#include <new>
+#include <stddef.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include "stdint.hpp"
+#include "err.hpp"
+
+namespace zmq
+{
+
+    //  Hash table mapping peer identities to values of type T. Identities
+    //  are looked up directly from the raw bytes (e.g. message data) so
+    //  no key object has to be constructed. Short identities, including
+    //  all the auto-generated ones, are stored inline in the table slot.
+    //  Open addressing with linear probing and backward-shift deletion is
+    //  used, so lookup, insertion and removal are all O(1) on average.
+    //  T must be default-constructible and assignable.
+
+    template <typename T> class idmap_t
+    {
+    public:
+
+        inline idmap_t () :
+            slots (NULL),
+            capacity (0),
+            count (0)
+        {
+        }
+
+        inline ~idmap_t ()
+        {
+            for (size_t i = 0; i != capacity; i++)
+                if (slots [i].used && slots [i].size > inline_size)
+                    free (slots [i].key.ptr);
+            delete [] slots;
+        }
+
+        //  Returns the value associated with the identity or NULL if there
+        //  is no such identity in the map.
+        inline T *find (const unsigned char *id_, size_t size_)
+        {
+            if (!count)
+                return NULL;
+            uint32_t hash = hash_id (id_, size_);
+            for (size_t i = hash & (capacity - 1); slots [i].used;
+                  i = (i + 1) & (capacity - 1))
+                if (slots [i].hash == hash && equals (slots [i], id_, size_))
+                    return &slots [i].value;
+            return NULL;
+        }
+
+        //  Adds the identity to the map. Returns false if the identity
+        //  is already present.
+        inline bool insert (const unsigned char *id_, size_t size_,
+            const T &value_)
+        {
+            if (find (id_, size_))
+                return false;
+
+            //  Keep the load factor under 1/2 to keep the probe
+            //  sequences short.
+            if ((count + 1) * 2 > capacity)
+                resize (capacity ? capacity * 2 : min_capacity);
+
+            slot_t slot;
+            slot.used = true;
+            slot.hash = hash_id (id_, size_);
+            slot.size = size_;
+            if (size_ <= inline_size)
+                memcpy (slot.key.buf, id_, size_);
+            else {
+                slot.key.ptr = (unsigned char*) malloc (size_);
+                alloc_assert (slot.key.ptr);
+                memcpy (slot.key.ptr, id_, size_);
+            }
+            slot.value = value_;
+            place (slot);
+            count++;
+            return true;
+        }
+
+        //  Removes the identity from the map. Returns false if there was
+        //  no such identity.
+        inline bool erase (const unsigned char *id_, size_t size_)
+        {
+            if (!count)
+                return false;
+            uint32_t hash = hash_id (id_, size_);
+            size_t i = hash & (capacity - 1);
+            while (true) {
+                if (!slots [i].used)
+                    return false;
+                if (slots [i].hash == hash && equals (slots [i], id_, size_))
+                    break;
+                i = (i + 1) & (capacity - 1);
+            }
+            if (slots [i].size > inline_size)
+                free (slots [i].key.ptr);
+            slots [i].used = false;
+            count--;
+
+            //  Shift the subsequent entries of the cluster back so that
+            //  no tombstones are needed.
+            size_t hole = i;
+            for (size_t j = (i + 1) & (capacity - 1); slots [j].used;
+                  j = (j + 1) & (capacity - 1)) {
+                size_t home = slots [j].hash & (capacity - 1);
+                if (((j - home) & (capacity - 1)) >=
+                      ((j - hole) & (capacity - 1))) {
+                    slots [hole] = slots [j];
+                    slots [j].used = false;
+                    hole = j;
+                }
+            }
+            return true;
+        }
+
+        inline size_t size ()
+        {
+            return count;
+        }
+
+        inline bool empty ()
+        {
+            return count == 0;
+        }
+
+    private:
+
+        //  Identities up to this size are stored directly in the slot.
+        enum {inline_size = 15};
+
+        //  Initial number of slots. Must be a power of two.
+        enum {min_capacity = 16};
+
+        struct slot_t
+        {
+            bool used;
+            uint32_t hash;
+            size_t size;
+            union {
+                unsigned char buf [inline_size];
+                unsigned char *ptr;
+            } key;
+            T value;
+        };
+
+        //  FNV-1a hash of the identity.
+        static inline uint32_t hash_id (const unsigned char *id_, size_t size_)
+        {
+            uint32_t hash = 2166136261u;
+            for (size_t i = 0; i != size_; i++) {
+                hash ^= id_ [i];
+                hash *= 16777619u;
+            }
+            return hash;
+        }
+
+        static inline bool equals (const slot_t &slot_,
+            const unsigned char *id_, size_t size_)
+        {
+            if (slot_.size != size_)
+                return false;
+            return memcmp (size_ <= inline_size ? slot_.key.buf :
+                slot_.key.ptr, id_, size_) == 0;
+        }
+
+        //  Stores the slot to the first free position of its probe sequence.
+        inline void place (const slot_t &slot_)
+        {
+            size_t i = slot_.hash & (capacity - 1);
+            while (slots [i].used)
+                i = (i + 1) & (capacity - 1);
+            slots [i] = slot_;
+        }
+
+        inline void resize (size_t capacity_)
+        {
+            slot_t *old_slots = slots;
+            size_t old_capacity = capacity;
+
+            slots = new (std::nothrow) slot_t [capacity_];
+            alloc_assert (slots);
+            for (size_t i = 0; i != capacity_; i++)
+                slots [i].used = false;
+            capacity = capacity_;
+
+            //  Keys are moved to the new slots along with their storage.
+            for (size_t i = 0; i != old_capacity; i++)
+                if (old_slots [i].used)
+                    place (old_slots [i]);
+            delete [] old_slots;
+        }
+
+        slot_t *slots;
+        size_t capacity;
+        size_t count;
+
+        idmap_t (const idmap_t&);
+        const idmap_t &operator = (const idmap_t&);
+    };
+
+}
+
+#endif
@@ -82,6 +82,11 @@ void zmq::io_object_t::reset_pollout (handle_t handle_)
     poller->reset_pollout (handle_);
 }
 
+bool zmq::io_object_t::set_edge_triggered (handle_t handle_)
+{
+    return poller->set_edge_triggered (handle_);
+}
+
 void zmq::io_object_t::add_timer (int timeout_, int id_)
 {
     poller->add_timer (timeout_, this, id_);
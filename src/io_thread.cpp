@@ -27,10 +27,12 @@
 #include "ctx.hpp"
 
 zmq::io_thread_t::io_thread_t (ctx_t *ctx_, uint32_t tid_) :
-    object_t (ctx_, tid_)
+    object_t (ctx_, tid_),
+    batch (ctx_)
 {
     poller = new (std::nothrow) poller_t;
     alloc_assert (poller);
+    poller->set_command_batch (&batch);
 
     mailbox_handle = poller->add_fd (mailbox.get_fd (), this);
     poller->set_pollin (mailbox_handle);
@@ -95,6 +97,11 @@ void zmq::io_thread_t::timer_event (int id_)
     zmq_assert (false);
 }
 
+zmq::command_batch_t *zmq::io_thread_t::get_command_batch ()
+{
+    return &batch;
+}
+
 zmq::poller_t *zmq::io_thread_t::get_poller ()
 {
     zmq_assert (poller);
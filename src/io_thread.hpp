@@ -29,6 +29,7 @@
 #include "poller.hpp"
 #include "i_poll_events.hpp"
 #include "mailbox.hpp"
+#include "command_batch.hpp"
 
 namespace zmq
 {
@@ -71,6 +72,9 @@ namespace zmq
         //  Returns load experienced by the I/O thread.
         int get_load ();
 
+        //  Returns the batch of pipe activations sent from this thread.
+        command_batch_t *get_command_batch ();
+
     private:
 
         //  I/O thread accesses incoming commands via this mailbox.
@@ -82,6 +86,10 @@ namespace zmq
         //  I/O multiplexing is performed using a poller object.
         poller_t *poller;
 
+        //  Pipe activations sent from this thread, delivered by the poller
+        //  before it waits for new events.
+        command_batch_t batch;
+
         io_thread_t (const io_thread_t&);
         const io_thread_t &operator = (const io_thread_t&);
     };
@@ -42,10 +42,11 @@ namespace zmq
     public:
 
         //  If 'delay' is true connecter first waits for a while, then starts
-        //  connection process.
+        //  connection process. If 'shm' is true, the connection is
+        //  a shm:// one.
         ipc_connecter_t (zmq::io_thread_t *io_thread_,
             zmq::session_base_t *session_, const options_t &options_,
-            const char *address_, bool delay_);
+            const char *address_, bool delay_, bool shm_);
         ~ipc_connecter_t ();
 
     private:
@@ -103,6 +104,9 @@ namespace zmq
         //  If true, connecter is waiting a while before trying to connect.
         bool wait;
 
+        //  True if the messages are passed through shared memory.
+        bool shm;
+
         //  Reference to the session we belong to.
         zmq::session_base_t *session;
 
@@ -27,6 +27,7 @@
 #include <string.h>
 
 #include "stream_engine.hpp"
+#include "shm_engine.hpp"
 #include "ipc_address.hpp"
 #include "io_thread.hpp"
 #include "session_base.hpp"
@@ -40,12 +41,13 @@
 #include <sys/un.h>
 
 zmq::ipc_listener_t::ipc_listener_t (io_thread_t *io_thread_,
-      socket_base_t *socket_, const options_t &options_) :
+      socket_base_t *socket_, const options_t &options_, bool shm_) :
     own_t (io_thread_, options_),
     io_object_t (io_thread_),
     has_file (false),
     s (retired_fd),
-    socket (socket_)
+    socket (socket_),
+    shm (shm_)
 {
 }
 
@@ -78,7 +80,13 @@ void zmq::ipc_listener_t::in_event ()
         return;
 
     //  Create the engine object for this connection.
-    stream_engine_t *engine = new (std::nothrow) stream_engine_t (fd, options);
+    i_engine *engine;
+#if defined ZMQ_HAVE_LINUX
+    if (shm)
+        engine = new (std::nothrow) shm_engine_t (fd, options, false);
+    else
+#endif
+        engine = new (std::nothrow) stream_engine_t (fd, options);
     alloc_assert (engine);
 
     //  Choose I/O thread to run connecter in. Given that we are already
@@ -108,7 +116,8 @@ int zmq::ipc_listener_t::get_address (std::string *addr_)
     }
     
     // Store the address for retrieval by users using wildcards
-    *addr_ = std::string("ipc://") + std::string(sun.sun_path);
+    *addr_ = std::string(shm ? "shm://" : "ipc://") +
+        std::string(sun.sun_path);
 
     return 0;
 }
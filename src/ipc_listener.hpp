@@ -42,8 +42,10 @@ namespace zmq
     {
     public:
 
+        //  If 'shm' is true, the accepted connections are shm:// ones.
         ipc_listener_t (zmq::io_thread_t *io_thread_,
-            zmq::socket_base_t *socket_, const options_t &options_);
+            zmq::socket_base_t *socket_, const options_t &options_,
+            bool shm_);
         ~ipc_listener_t ();
 
         //  Set address to listen on.
@@ -84,6 +86,9 @@ namespace zmq
         //  Socket the listerner belongs to.
         zmq::socket_base_t *socket;
 
+        //  True if the messages are passed through shared memory.
+        bool shm;
+
         ipc_listener_t (const ipc_listener_t&);
         const ipc_listener_t &operator = (const ipc_listener_t&);
     };
@@ -141,6 +141,12 @@ void zmq::kqueue_t::reset_pollout (handle_t handle_)
    }
 }
 
+bool zmq::kqueue_t::set_edge_triggered (handle_t handle_)
+{
+    //  Edge-triggered polling is not supported.
+    return false;
+}
+
 void zmq::kqueue_t::start ()
 {
     worker.start (worker_routine, this);
@@ -158,6 +164,9 @@ void zmq::kqueue_t::loop ()
         //  Execute any due timers.
         int timeout = (int) execute_timers ();
 
+        //  Deliver the commands batched by the event and timer handlers.
+        flush_commands ();
+
         //  Wait for events.
         struct kevent ev_buf [max_io_events];
         timespec ts = {timeout / 1000, (timeout % 1000) * 1000000};
@@ -190,6 +199,8 @@ void zmq::kqueue_t::loop ()
             delete *it;
         retired.clear ();
     }
+
+    flush_commands ();
 }
 
 void zmq::kqueue_t::worker_routine (void *arg_)
@@ -20,16 +20,50 @@
     along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <algorithm>
+
 #include "lb.hpp"
 #include "pipe.hpp"
 #include "err.hpp"
 #include "msg.hpp"
+#include "likely.hpp"
+
+//  Number of points each pipe occupies on the hash ring. The more points,
+//  the more evenly are the keys spread among the pipes.
+static const int ring_replicas = 64;
+
+//  Final avalanche step of MurmurHash3. It is a bijection, so the points of
+//  a single pipe are distinct. The points of different pipes may coincide
+//  though, for example when their seeds are less than ring_replicas apart.
+static inline uint32_t mix (uint32_t hash_)
+{
+    hash_ ^= hash_ >> 16;
+    hash_ *= 0x85ebca6bu;
+    hash_ ^= hash_ >> 13;
+    hash_ *= 0xc2b2ae35u;
+    hash_ ^= hash_ >> 16;
+    return hash_;
+}
+
+//  FNV-1a hash of the data.
+static uint32_t fnv (const unsigned char *data_, size_t size_)
+{
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i != size_; i++) {
+        hash ^= data_ [i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
 
 zmq::lb_t::lb_t () :
     active (0),
     current (0),
     more (false),
-    dropping (false)
+    dropping (false),
+    urgent_pipe (NULL),
+    strategy (ZMQ_LB_ROUND_ROBIN),
+    key_size (0)
 {
 }
 
@@ -43,6 +77,31 @@ void zmq::lb_t::attach (pipe_t *pipe_)
     pipes.push_back (pipe_);
     pipes.swap (active, pipes.size () - 1);
     active++;
+
+    //  Place the pipe on the hash ring. The peer is named by its identity,
+    //  if known, or by the endpoint the pipe was connected to. Pipes with
+    //  the same name, such as those accepted on a bound endpoint, take
+    //  the lowest instance number whose seed is not on the ring yet.
+    uint32_t name;
+    if (pipe_->get_identity_size ())
+        name = fnv (pipe_->get_identity (), pipe_->get_identity_size ());
+    else
+        name = fnv ((const unsigned char*) pipe_->get_endpoint ().data (),
+            pipe_->get_endpoint ().size ());
+    uint32_t seed = name;
+    for (uint32_t instance = 1; true; instance++) {
+        ring_t::iterator it = ring.begin ();
+        while (it != ring.end () && it->seed != seed)
+            ++it;
+        if (it == ring.end ())
+            break;
+        seed = mix (name + instance);
+    }
+    for (int i = 0; i != ring_replicas; i++) {
+        ring_point_t point = {mix (seed + i), seed, pipe_};
+        ring.insert (std::upper_bound (ring.begin (), ring.end (), point),
+            point);
+    }
 }
 
 void zmq::lb_t::terminated (pipe_t *pipe_)
@@ -51,8 +110,10 @@ void zmq::lb_t::terminated (pipe_t *pipe_)
 
     //  If we are in the middle of multipart message and current pipe
     //  have disconnected, we have to drop the remainder of the message.
-    if (index == current && more)
+    if (more && (urgent_pipe ? pipe_ == urgent_pipe : index == current))
         dropping = true;
+    if (pipe_ == urgent_pipe)
+        urgent_pipe = NULL;
 
     //  Remove the pipe from the list; adjust number of active pipes
     //  accordingly.
@@ -62,6 +123,14 @@ void zmq::lb_t::terminated (pipe_t *pipe_)
             current = 0;
     }
     pipes.erase (pipe_);
+
+    //  Remove the pipe from the hash ring. The keys it was responsible for
+    //  fall to the following points on the ring.
+    ring_t::iterator it = ring.begin ();
+    for (ring_t::iterator point = ring.begin (); point != ring.end (); ++point)
+        if (point->pipe != pipe_)
+            *it++ = *point;
+    ring.erase (it, ring.end ());
 }
 
 void zmq::lb_t::activated (pipe_t *pipe_)
@@ -71,6 +140,12 @@ void zmq::lb_t::activated (pipe_t *pipe_)
     active++;
 }
 
+void zmq::lb_t::set_strategy (int strategy_, int key_size_)
+{
+    strategy = strategy_;
+    key_size = (size_t) key_size_;
+}
+
 int zmq::lb_t::send (msg_t *msg_, int flags_)
 {
     //  Drop the message if required. If we are at the end of the message
@@ -88,6 +163,28 @@ int zmq::lb_t::send (msg_t *msg_, int flags_)
         return 0;
     }
 
+    //  The rest of an urgent message goes to the same inactive pipe as
+    //  the first part.
+    if (unlikely (urgent_pipe != NULL))
+        return send_urgent (urgent_pipe, msg_);
+
+    //  The pipe for the keyed message is given by the key. Unlike with
+    //  other strategies, if the pipe is full no other pipe is tried.
+    //  Still, it may have room for an urgent message.
+    if (strategy == ZMQ_LB_KEY_HASH && !more) {
+        if (send_keyed (msg_) != 0) {
+            if (errno != EAGAIN || pipes.empty () ||
+                  !(msg_->flags () & msg_t::urgent))
+                return -1;
+            return send_urgent (lookup (msg_), msg_);
+        }
+    }
+
+    //  At the beginning of a message, choose the least loaded pipe if
+    //  required. Otherwise the pipes are simply round-robined.
+    if (strategy == ZMQ_LB_LEAST_OUTSTANDING && !more && active > 1)
+        current = least_outstanding ();
+
     while (active > 0) {
         if (pipes [current]->write (msg_)) {
             more = msg_->flags () & msg_t::more ? true : false;
@@ -102,8 +199,14 @@ int zmq::lb_t::send (msg_t *msg_, int flags_)
             current = 0;
     }
 
-    //  If there are no pipes we cannot send the message.
+    //  If there are no pipes we cannot send the message. Urgent messages
+    //  have an allowance of their own though, so the inactive pipes may
+    //  still take them.
     if (active == 0) {
+        if (msg_->flags () & msg_t::urgent)
+            for (pipes_t::size_type i = 0; i != pipes.size (); i++)
+                if (send_urgent (pipes [i], msg_) == 0)
+                    return 0;
         errno = EAGAIN;
         return -1;
     }
@@ -122,6 +225,84 @@ int zmq::lb_t::send (msg_t *msg_, int flags_)
     return 0;
 }
 
+int zmq::lb_t::send_keyed (msg_t *msg_)
+{
+    if (active == 0) {
+        errno = EAGAIN;
+        return -1;
+    }
+
+    pipes_t::size_type index = pipes.index (lookup (msg_));
+    if (index >= active) {
+        errno = EAGAIN;
+        return -1;
+    }
+
+    //  Make the rest of the send function write to the chosen pipe.
+    current = index;
+    if (pipes [current]->check_write (msg_))
+        return 0;
+
+    //  The pipe is full. Deactivate it.
+    active--;
+    pipes.swap (current, active);
+    current = 0;
+    errno = EAGAIN;
+    return -1;
+}
+
+int zmq::lb_t::send_urgent (pipe_t *pipe_, msg_t *msg_)
+{
+    if (!pipe_->write (msg_)) {
+        errno = EAGAIN;
+        return -1;
+    }
+
+    more = msg_->flags () & msg_t::more ? true : false;
+    urgent_pipe = more ? pipe_ : NULL;
+    if (!more)
+        pipe_->flush ();
+
+    //  Detach the message from the data buffer.
+    int rc = msg_->init ();
+    errno_assert (rc == 0);
+
+    return 0;
+}
+
+zmq::pipe_t *zmq::lb_t::lookup (msg_t *msg_)
+{
+    zmq_assert (!ring.empty ());
+
+    //  Hash of the key, spread evenly over the ring.
+    size_t size = msg_->size ();
+    if (key_size && key_size < size)
+        size = key_size;
+    ring_point_t point = {mix (fnv ((const unsigned char*) msg_->data (),
+        size)), 0, NULL};
+
+    ring_t::iterator it = std::lower_bound (ring.begin (), ring.end (),
+        point);
+    if (it == ring.end ())
+        it = ring.begin ();
+    return it->pipe;
+}
+
+zmq::lb_t::pipes_t::size_type zmq::lb_t::least_outstanding ()
+{
+    pipes_t::size_type result = current;
+    uint64_t min = pipes [current]->get_outstanding ();
+    for (pipes_t::size_type i = 1; min && i != active; i++) {
+        pipes_t::size_type index = (current + i) % active;
+        uint64_t outstanding = pipes [index]->get_outstanding ();
+        if (outstanding < min) {
+            result = index;
+            min = outstanding;
+        }
+    }
+    return result;
+}
+
 bool zmq::lb_t::has_out ()
 {
     //  If one part of the message was already written we can definitely
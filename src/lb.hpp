@@ -22,8 +22,12 @@
 #ifndef __ZMQ_LB_HPP_INCLUDED__
 #define __ZMQ_LB_HPP_INCLUDED__
 
+#include <stddef.h>
+#include <vector>
+
 #include "array.hpp"
 #include "pipe.hpp"
+#include "stdint.hpp"
 
 namespace zmq
 {
@@ -42,6 +46,10 @@ namespace zmq
         void activated (pipe_t *pipe_);
         void terminated (pipe_t *pipe_);
 
+        //  Sets the strategy (ZMQ_LB_* constant) used to choose the pipe
+        //  for the next message. Key size is used by ZMQ_LB_KEY_HASH only.
+        void set_strategy (int strategy_, int key_size_);
+
         int send (msg_t *msg_, int flags_);
         bool has_out ();
 
@@ -64,6 +72,58 @@ namespace zmq
         //  True if we are dropping current message.
         bool dropping;
 
+        //  Inactive pipe the urgent message being sent goes to, NULL if
+        //  the message goes to one of the active pipes.
+        pipe_t *urgent_pipe;
+
+        //  Load-balancing strategy in use.
+        int strategy;
+
+        //  Number of leading bytes of the first message part to hash.
+        //  Zero means the whole part.
+        size_t key_size;
+
+        //  Hash ring used by ZMQ_LB_KEY_HASH strategy. Each pipe is
+        //  represented by a number of points on the ring. Message goes to
+        //  the pipe owning the first point following the hash of its key,
+        //  thus when a pipe is added or removed only the keys in its
+        //  vicinity are remapped. The ring contains inactive pipes as well
+        //  so that the key is not remapped when the peer is merely busy.
+        //  The points are derived from the name of the peer rather than
+        //  from the order the pipes were attached in, so that the peer
+        //  gets the same keys whichever way the ring was built. For the same
+        //  reason, points with the same hash are ordered by the seed they
+        //  were derived from, which is unique to the pipe.
+        struct ring_point_t
+        {
+            uint32_t hash;
+            uint32_t seed;
+            pipe_t *pipe;
+
+            bool operator < (const ring_point_t &other_) const
+            {
+                return hash < other_.hash ||
+                    (hash == other_.hash && seed < other_.seed);
+            }
+        };
+        typedef std::vector <ring_point_t> ring_t;
+        ring_t ring;
+
+        //  Returns the pipe responsible for the key of the message.
+        pipe_t *lookup (msg_t *msg_);
+
+        //  Sends the first part of a message to the pipe chosen by its key.
+        int send_keyed (msg_t *msg_);
+
+        //  Sends the message part to the inactive pipe. Such pipe may still
+        //  have room for urgent messages.
+        int send_urgent (pipe_t *pipe_, msg_t *msg_);
+
+        //  Returns index of the active pipe with the fewest outstanding
+        //  messages. The search starts at the current pipe so that the
+        //  pipes with equal load are used in round-robin fashion.
+        pipes_t::size_type least_outstanding ();
+
         lb_t (const lb_t&);
         const lb_t &operator = (const lb_t&);
     };
@@ -0,0 +1,205 @@
+/*
+    Copyright (c) 2009-2011 250bpm s.r.o.
+    Copyright (c) 2007-2011 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <string.h>
+
+#include "lz_codec.hpp"
+#include "config.hpp"
+#include "err.hpp"
+
+//  Reads 4 bytes from possibly unaligned address.
+static inline uint32_t read32 (const unsigned char *p_)
+{
+    uint32_t value;
+    memcpy (&value, p_, sizeof (value));
+    return value;
+}
+
+//  Writes the length which didn't fit into the nibble of the token.
+static inline unsigned char *put_length (unsigned char *op_, size_t length_)
+{
+    while (length_ >= 255) {
+        *op_++ = 255;
+        length_ -= 255;
+    }
+    *op_++ = (unsigned char) length_;
+    return op_;
+}
+
+//  Reads the length continuing the nibble of the token. Returns false if
+//  the input ends prematurely.
+static inline bool get_length (const unsigned char *&ip_,
+    const unsigned char *end_, size_t &length_)
+{
+    unsigned char b;
+    do {
+        if (ip_ == end_)
+            return false;
+        b = *ip_++;
+        length_ += b;
+    } while (b == 255);
+    return true;
+}
+
+zmq::lz_codec_t::lz_codec_t ()
+{
+}
+
+zmq::lz_codec_t::~lz_codec_t ()
+{
+}
+
+size_t zmq::lz_codec_t::bound (size_t size_)
+{
+    return size_ + size_ / 255 + 16;
+}
+
+size_t zmq::lz_codec_t::compress (const unsigned char *in_, size_t in_size_,
+    unsigned char *out_)
+{
+    zmq_assert (in_size_ <= max_compressed_block);
+
+    const unsigned char *ip = in_;
+    const unsigned char *anchor = in_;
+    const unsigned char *end = in_ + in_size_;
+    unsigned char *op = out_;
+
+    //  Stale positions from the previous block are harmless, candidate
+    //  matches are always verified, but they would hide nearer positions.
+    memset (table, 0, sizeof (table));
+
+    if (in_size_ > min_match) {
+
+        //  The last position a whole sequence can be read from.
+        const unsigned char *limit = end - min_match;
+
+        //  Number of positions without a match found. The longer the data
+        //  don't compress, the more positions are skipped.
+        size_t misses = 0;
+
+        ip++;
+        while (ip <= limit) {
+            uint32_t seq = read32 (ip);
+            uint32_t hash = (seq * 2654435761U) >> (32 - hash_bits);
+            const unsigned char *ref = in_ + table [hash];
+            table [hash] = (uint16_t) (ip - in_);
+
+            if (ref >= ip || read32 (ref) != seq) {
+                ip += 1 + (misses++ >> 5);
+                continue;
+            }
+            misses = 0;
+
+            //  Extend the match backwards into the pending literals
+            //  and forwards as far as it goes.
+            while (ip > anchor && ref > in_ && ip [-1] == ref [-1]) {
+                ip--;
+                ref--;
+            }
+            const unsigned char *match_end = ip + min_match;
+            const unsigned char *ref_end = ref + min_match;
+            while (match_end < end && *match_end == *ref_end) {
+                match_end++;
+                ref_end++;
+            }
+
+            //  Emit the sequence.
+            size_t literals = ip - anchor;
+            size_t match = match_end - ip - min_match;
+            size_t offset = ip - ref;
+            unsigned char *token = op++;
+            *token = (unsigned char) ((literals < 15 ? literals : 15) << 4 |
+                (match < 15 ? match : 15));
+            if (literals >= 15)
+                op = put_length (op, literals - 15);
+            memcpy (op, anchor, literals);
+            op += literals;
+            *op++ = (unsigned char) (offset & 0xff);
+            *op++ = (unsigned char) (offset >> 8);
+            if (match >= 15)
+                op = put_length (op, match - 15);
+
+            ip = match_end;
+            anchor = ip;
+        }
+    }
+
+    //  The rest of the block is passed as literals.
+    size_t literals = end - anchor;
+    *op++ = (unsigned char) ((literals < 15 ? literals : 15) << 4);
+    if (literals >= 15)
+        op = put_length (op, literals - 15);
+    memcpy (op, anchor, literals);
+    op += literals;
+
+    zmq_assert ((size_t) (op - out_) <= bound (in_size_));
+    return op - out_;
+}
+
+int zmq::lz_codec_t::decompress (const unsigned char *in_, size_t in_size_,
+    unsigned char *out_, size_t out_size_)
+{
+    const unsigned char *ip = in_;
+    const unsigned char *end = in_ + in_size_;
+    unsigned char *op = out_;
+    unsigned char *out_end = out_ + out_size_;
+
+    while (ip != end) {
+
+        //  Copy the literals.
+        unsigned char token = *ip++;
+        size_t literals = token >> 4;
+        if (literals == 15 && !get_length (ip, end, literals))
+            return -1;
+        if (literals > (size_t) (end - ip) ||
+              literals > (size_t) (out_end - op))
+            return -1;
+        memcpy (op, ip, literals);
+        ip += literals;
+        op += literals;
+
+        //  The last sequence has no match.
+        if (ip == end)
+            break;
+
+        //  Copy the match. It may overlap with its own output.
+        if (end - ip < 2)
+            return -1;
+        size_t offset = ip [0] | ((size_t) ip [1] << 8);
+        ip += 2;
+        size_t match = token & 0x0f;
+        if (match == 15 && !get_length (ip, end, match))
+            return -1;
+        match += min_match;
+        if (offset == 0 || offset > (size_t) (op - out_) ||
+              match > (size_t) (out_end - op))
+            return -1;
+        const unsigned char *ref = op - offset;
+        if (offset >= match) {
+            memcpy (op, ref, match);
+            op += match;
+        }
+        else
+            while (match--)
+                *op++ = *ref++;
+    }
+
+    return op == out_end ? 0 : -1;
+}
@@ -0,0 +1,71 @@
+/*
+    Copyright (c) 2009-2011 250bpm s.r.o.
+    Copyright (c) 2007-2011 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __ZMQ_LZ_CODEC_HPP_INCLUDED__
+#define __ZMQ_LZ_CODEC_HPP_INCLUDED__
+
+#include "i_codec.hpp"
+#include "stdint.hpp"
+
+namespace zmq
+{
+
+    //  Fast compressor of the LZ77 family. The compressed block is
+    //  a sequence of literal runs each followed by a back reference of
+    //  at least min_match bytes into the data already decompressed.
+    //  Each sequence starts with a byte holding the literal run length
+    //  in the high nibble and the match length in the low one. Lengths
+    //  that don't fit into a nibble continue in subsequent bytes, each
+    //  byte of 255 meaning that yet another byte follows. The literals
+    //  are followed by 2-byte little-endian offset of the match. The last
+    //  sequence of the block consists of literals only.
+
+    class lz_codec_t : public i_codec
+    {
+    public:
+
+        lz_codec_t ();
+        ~lz_codec_t ();
+
+        //  i_codec interface implementation.
+        size_t bound (size_t size_);
+        size_t compress (const unsigned char *in_, size_t in_size_,
+            unsigned char *out_);
+        int decompress (const unsigned char *in_, size_t in_size_,
+            unsigned char *out_, size_t out_size_);
+
+    private:
+
+        enum {
+            min_match = 4,
+            hash_bits = 12
+        };
+
+        //  Positions of the last occurrences of 4-byte sequences within
+        //  the block being compressed, indexed by hash of the sequence.
+        uint16_t table [1 << hash_bits];
+
+        lz_codec_t (const lz_codec_t&);
+        const lz_codec_t &operator = (const lz_codec_t&);
+    };
+
+}
+
+#endif
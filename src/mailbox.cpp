@@ -52,6 +52,19 @@ void zmq::mailbox_t::send (const command_t &cmd_)
         signaler.send ();
 }
 
+void zmq::mailbox_t::send (const command_t *cmds_, size_t count_)
+{
+    //  Writing all the commands before flushing the pipe means at most one
+    //  signal for the whole batch.
+    sync.lock ();
+    for (size_t i = 0; i != count_; i++)
+        cpipe.write (cmds_ [i], false);
+    bool ok = cpipe.flush ();
+    sync.unlock ();
+    if (!ok)
+        signaler.send ();
+}
+
 int zmq::mailbox_t::recv (command_t *cmd_, int timeout_)
 {
     //  Try to get the command straight away.
@@ -44,6 +44,7 @@ namespace zmq
 
         fd_t get_fd ();
         void send (const command_t &cmd_);
+        void send (const command_t *cmds_, size_t count_);
         int recv (command_t *cmd_, int timeout_);
         
     private:
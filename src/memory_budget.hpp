@@ -0,0 +1,100 @@
+/*
+    Copyright (c) 2009-2011 250bpm s.r.o.
+    Copyright (c) 2007-2011 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __ZMQ_MEMORY_BUDGET_HPP_INCLUDED__
+#define __ZMQ_MEMORY_BUDGET_HPP_INCLUDED__
+
+#include <stddef.h>
+
+#include "atomic_counter.hpp"
+#include "stdint.hpp"
+
+namespace zmq
+{
+
+    //  Context-wide account of the memory used by messages in flight.
+    //  Pipes charge the budget when a message is written and release it
+    //  when the message is read; engines charge their I/O buffers while
+    //  plugged. The memory is accounted in blocks so that a 32-bit
+    //  atomic counter is sufficient even for large limits.
+
+    class memory_budget_t
+    {
+    public:
+
+        inline memory_budget_t () :
+            limit (0)
+        {
+        }
+
+        //  Sets the limit in bytes. Zero means no limit.
+        inline void set_limit (uint64_t limit_)
+        {
+            limit = (uint32_t) ((limit_ + block_size - 1) / block_size);
+        }
+
+        inline uint64_t get_limit ()
+        {
+            return (uint64_t) limit * block_size;
+        }
+
+        //  Returns the amount of memory currently accounted for, in bytes.
+        inline uint64_t get_used ()
+        {
+            return (uint64_t) used.get () * block_size;
+        }
+
+        inline void charge (size_t size_)
+        {
+            used.add (blocks (size_));
+        }
+
+        inline void release (size_t size_)
+        {
+            used.sub (blocks (size_));
+        }
+
+        //  Returns true if the memory in use have reached the limit.
+        inline bool exceeded ()
+        {
+            return limit && used.get () >= limit;
+        }
+
+    private:
+
+        enum {block_size = 64};
+
+        static inline atomic_counter_t::integer_t blocks (size_t size_)
+        {
+            return (atomic_counter_t::integer_t)
+                ((size_ + block_size - 1) / block_size);
+        }
+
+        //  Limit and the memory in use, in blocks.
+        volatile uint32_t limit;
+        atomic_counter_t used;
+
+        memory_budget_t (const memory_budget_t&);
+        const memory_budget_t &operator = (const memory_budget_t&);
+    };
+
+}
+
+#endif
@@ -50,6 +50,8 @@ namespace zmq
         enum
         {
             more = 1,
+            stamp = 2,
+            urgent = 4,
             identity = 64,
             shared = 128
         };
@@ -29,6 +29,7 @@
 #include "io_thread.hpp"
 #include "session_base.hpp"
 #include "socket_base.hpp"
+#include "command_batch.hpp"
 
 zmq::object_t::object_t (ctx_t *ctx_, uint32_t tid_) :
     ctx (ctx_),
@@ -65,7 +66,9 @@ void zmq::object_t::process_command (command_t &cmd_)
         break;
 
     case command_t::activate_write:
-        process_activate_write (cmd_.args.activate_write.msgs_read);
+        process_activate_write (cmd_.args.activate_write.msgs_read,
+            cmd_.args.activate_write.bytes_read,
+            cmd_.args.activate_write.urgent_msgs_read);
         break;
 
     case command_t::stop:
@@ -96,6 +99,10 @@ void zmq::object_t::process_command (command_t &cmd_)
         process_hiccup (cmd_.args.hiccup.pipe);
         break;
 
+    case command_t::urgent_lane:
+        process_urgent_lane (cmd_.args.urgent_lane.pipe);
+        break;
+
     case command_t::pipe_term:
         process_pipe_term ();
         break;
@@ -242,11 +249,11 @@ void zmq::object_t::send_activate_read (pipe_t *destination_)
 #endif
     cmd.destination = destination_;
     cmd.type = command_t::activate_read;
-    send_command (cmd);
+    post_command (cmd);
 }
 
 void zmq::object_t::send_activate_write (pipe_t *destination_,
-    uint64_t msgs_read_)
+    uint64_t msgs_read_, uint64_t bytes_read_, uint64_t urgent_msgs_read_)
 {
     command_t cmd;
 #if defined ZMQ_MAKE_VALGRIND_HAPPY
@@ -255,7 +262,9 @@ void zmq::object_t::send_activate_write (pipe_t *destination_,
     cmd.destination = destination_;
     cmd.type = command_t::activate_write;
     cmd.args.activate_write.msgs_read = msgs_read_;
-    send_command (cmd);
+    cmd.args.activate_write.bytes_read = bytes_read_;
+    cmd.args.activate_write.urgent_msgs_read = urgent_msgs_read_;
+    post_command (cmd);
 }
 
 void zmq::object_t::send_hiccup (pipe_t *destination_, void *pipe_)
@@ -267,6 +276,20 @@ void zmq::object_t::send_hiccup (pipe_t *destination_, void *pipe_)
     cmd.destination = destination_;
     cmd.type = command_t::hiccup;
     cmd.args.hiccup.pipe = pipe_;
+    flush_posted_commands ();
+    send_command (cmd);
+}
+
+void zmq::object_t::send_urgent_lane (pipe_t *destination_, void *pipe_)
+{
+    command_t cmd;
+#if defined ZMQ_MAKE_VALGRIND_HAPPY
+    memset (&cmd, 0, sizeof (cmd));
+#endif
+    cmd.destination = destination_;
+    cmd.type = command_t::urgent_lane;
+    cmd.args.urgent_lane.pipe = pipe_;
+    flush_posted_commands ();
     send_command (cmd);
 }
 
@@ -278,6 +301,7 @@ void zmq::object_t::send_pipe_term (pipe_t *destination_)
 #endif
     cmd.destination = destination_;
     cmd.type = command_t::pipe_term;
+    flush_posted_commands ();
     send_command (cmd);
 }
 
@@ -289,6 +313,7 @@ void zmq::object_t::send_pipe_term_ack (pipe_t *destination_)
 #endif
     cmd.destination = destination_;
     cmd.type = command_t::pipe_term_ack;
+    flush_posted_commands ();
     send_command (cmd);
 }
 
@@ -392,7 +417,8 @@ void zmq::object_t::process_activate_read ()
     zmq_assert (false);
 }
 
-void zmq::object_t::process_activate_write (uint64_t msgs_read_)
+void zmq::object_t::process_activate_write (uint64_t msgs_read_,
+    uint64_t bytes_read_, uint64_t urgent_msgs_read_)
 {
     zmq_assert (false);
 }
@@ -402,6 +428,11 @@ void zmq::object_t::process_hiccup (void *pipe_)
     zmq_assert (false);
 }
 
+void zmq::object_t::process_urgent_lane (void *pipe_)
+{
+    zmq_assert (false);
+}
+
 void zmq::object_t::process_pipe_term ()
 {
     zmq_assert (false);
@@ -447,3 +478,19 @@ void zmq::object_t::send_command (command_t &cmd_)
     ctx->send_command (cmd_.destination->get_tid (), cmd_);
 }
 
+void zmq::object_t::post_command (command_t &cmd_)
+{
+    command_batch_t *batch = ctx->get_command_batch (tid);
+    if (batch)
+        batch->post (cmd_);
+    else
+        send_command (cmd_);
+}
+
+void zmq::object_t::flush_posted_commands ()
+{
+    command_batch_t *batch = ctx->get_command_batch (tid);
+    if (batch)
+        batch->flush ();
+}
+
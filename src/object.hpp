@@ -80,8 +80,10 @@ namespace zmq
              bool inc_seqnum_ = true);
         void send_activate_read (zmq::pipe_t *destination_);
         void send_activate_write (zmq::pipe_t *destination_,
-             uint64_t msgs_read_);
+             uint64_t msgs_read_, uint64_t bytes_read_,
+             uint64_t urgent_msgs_read_);
         void send_hiccup (zmq::pipe_t *destination_, void *pipe_);
+        void send_urgent_lane (zmq::pipe_t *destination_, void *pipe_);
         void send_pipe_term (zmq::pipe_t *destination_);
         void send_pipe_term_ack (zmq::pipe_t *destination_);
         void send_term_req (zmq::own_t *destination_,
@@ -100,8 +102,10 @@ namespace zmq
         virtual void process_attach (zmq::i_engine *engine_);
         virtual void process_bind (zmq::pipe_t *pipe_);
         virtual void process_activate_read ();
-        virtual void process_activate_write (uint64_t msgs_read_);
+        virtual void process_activate_write (uint64_t msgs_read_,
+            uint64_t bytes_read_, uint64_t urgent_msgs_read_);
         virtual void process_hiccup (void *pipe_);
+        virtual void process_urgent_lane (void *pipe_);
         virtual void process_pipe_term ();
         virtual void process_pipe_term_ack ();
         virtual void process_term_req (zmq::own_t *object_);
@@ -125,6 +129,14 @@ namespace zmq
 
         void send_command (command_t &cmd_);
 
+        //  Pipe activations sent from an I/O thread are batched till the end
+        //  of the current loop iteration. Other commands to the pipes flush
+        //  the batch first so that they are not overtaken by activations.
+        //  As the batch is accessed without locking, this is only valid for
+        //  pipes that are used exclusively by their I/O thread.
+        void post_command (command_t &cmd_);
+        void flush_posted_commands ();
+
         object_t (const object_t&);
         const object_t &operator = (const object_t&);
     };
@@ -28,6 +28,10 @@
 zmq::options_t::options_t () :
     sndhwm (1000),
     rcvhwm (1000),
+    sndhwm_bytes (0),
+    rcvhwm_bytes (0),
+    swap (0),
+    ttl (0),
     affinity (0),
     identity_size (0),
     rate (100),
@@ -48,7 +52,14 @@ zmq::options_t::options_t () :
     delay_on_disconnect (true),
     filter (false),
     send_identity (false),
-    recv_identity (false)
+    recv_identity (false),
+    conflate (-1),
+    lvc (-1),
+    lb_strategy (ZMQ_LB_ROUND_ROBIN),
+    lb_key_size (0),
+    fq_weight (1),
+    compression (ZMQ_COMPRESSION_NONE),
+    subscription_batch (0)
 {
 }
 
@@ -73,6 +84,38 @@ int zmq::options_t::setsockopt (int option_, const void *optval_,
         rcvhwm = *((int*) optval_);
         return 0;
 
+    case ZMQ_SNDHWM_BYTES:
+        if (optvallen_ != sizeof (int64_t) || *((int64_t*) optval_) < 0) {
+            errno = EINVAL;
+            return -1;
+        }
+        sndhwm_bytes = *((int64_t*) optval_);
+        return 0;
+
+    case ZMQ_RCVHWM_BYTES:
+        if (optvallen_ != sizeof (int64_t) || *((int64_t*) optval_) < 0) {
+            errno = EINVAL;
+            return -1;
+        }
+        rcvhwm_bytes = *((int64_t*) optval_);
+        return 0;
+
+    case ZMQ_SWAP:
+        if (optvallen_ != sizeof (int64_t) || *((int64_t*) optval_) < 0) {
+            errno = EINVAL;
+            return -1;
+        }
+        swap = *((int64_t*) optval_);
+        return 0;
+
+    case ZMQ_TTL:
+        if (optvallen_ != sizeof (int) || *((int*) optval_) < 0) {
+            errno = EINVAL;
+            return -1;
+        }
+        ttl = *((int*) optval_);
+        return 0;
+
     case ZMQ_AFFINITY:
         if (optvallen_ != sizeof (uint64_t)) {
             errno = EINVAL;
@@ -213,6 +256,112 @@ int zmq::options_t::setsockopt (int option_, const void *optval_,
             ipv4only = val;
             return 0;
         }
+
+    case ZMQ_CONFLATE:
+        {
+            if (optvallen_ != sizeof (int) || *((int*) optval_) < -1) {
+                errno = EINVAL;
+                return -1;
+            }
+
+            //  Conflation makes sense only for publish-subscribe pattern.
+            if (type != ZMQ_PUB && type != ZMQ_XPUB && type != ZMQ_SUB &&
+                  type != ZMQ_XSUB) {
+                errno = EINVAL;
+                return -1;
+            }
+            conflate = *((int*) optval_);
+            return 0;
+        }
+
+    case ZMQ_LAST_VALUE_CACHE:
+        {
+            if (optvallen_ != sizeof (int) || *((int*) optval_) < -1) {
+                errno = EINVAL;
+                return -1;
+            }
+
+            //  Only publishers cache the messages.
+            if (type != ZMQ_PUB && type != ZMQ_XPUB) {
+                errno = EINVAL;
+                return -1;
+            }
+            lvc = *((int*) optval_);
+            return 0;
+        }
+
+    case ZMQ_LB_STRATEGY:
+        {
+            if (optvallen_ != sizeof (int) ||
+                  (*((int*) optval_) != ZMQ_LB_ROUND_ROBIN &&
+                  *((int*) optval_) != ZMQ_LB_LEAST_OUTSTANDING &&
+                  *((int*) optval_) != ZMQ_LB_KEY_HASH)) {
+                errno = EINVAL;
+                return -1;
+            }
+
+            //  Only load-balancing sockets have a choice of the pipe.
+            if (type != ZMQ_PUSH && type != ZMQ_DEALER && type != ZMQ_REQ) {
+                errno = EINVAL;
+                return -1;
+            }
+
+            //  The first part of a request is the empty delimiter, so there's
+            //  no key to route on.
+            if (type == ZMQ_REQ && *((int*) optval_) == ZMQ_LB_KEY_HASH) {
+                errno = EINVAL;
+                return -1;
+            }
+            lb_strategy = *((int*) optval_);
+            return 0;
+        }
+
+    case ZMQ_LB_KEY_SIZE:
+        if (optvallen_ != sizeof (int) || *((int*) optval_) < 0) {
+            errno = EINVAL;
+            return -1;
+        }
+        lb_key_size = *((int*) optval_);
+        return 0;
+
+    case ZMQ_FQ_WEIGHT:
+        if (optvallen_ != sizeof (int) || *((int*) optval_) < 1) {
+            errno = EINVAL;
+            return -1;
+        }
+        fq_weight = *((int*) optval_);
+        return 0;
+
+    case ZMQ_COMPRESSION:
+        if (optvallen_ != sizeof (int) ||
+              (*((int*) optval_) != ZMQ_COMPRESSION_NONE &&
+              *((int*) optval_) != ZMQ_COMPRESSION_LZ)) {
+            errno = EINVAL;
+            return -1;
+        }
+        compression = *((int*) optval_);
+        return 0;
+
+    case ZMQ_SUBSCRIPTION_BATCH:
+        {
+            if (optvallen_ != sizeof (int)) {
+                errno = EINVAL;
+                return -1;
+            }
+            int val = *((int*) optval_);
+            if (val != 0 && val != 1) {
+                errno = EINVAL;
+                return -1;
+            }
+
+            //  Only subscribers send subscriptions upstream.
+            if (type != ZMQ_SUB && type != ZMQ_XSUB) {
+                errno = EINVAL;
+                return -1;
+            }
+            subscription_batch = val;
+            return 0;
+        }
     }
 
     errno = EINVAL;
@@ -241,6 +390,42 @@ int zmq::options_t::getsockopt (int option_, void *optval_, size_t *optvallen_)
         *optvallen_ = sizeof (int);
         return 0;
 
+    case ZMQ_SNDHWM_BYTES:
+        if (*optvallen_ < sizeof (int64_t)) {
+            errno = EINVAL;
+            return -1;
+        }
+        *((int64_t*) optval_) = sndhwm_bytes;
+        *optvallen_ = sizeof (int64_t);
+        return 0;
+
+    case ZMQ_RCVHWM_BYTES:
+        if (*optvallen_ < sizeof (int64_t)) {
+            errno = EINVAL;
+            return -1;
+        }
+        *((int64_t*) optval_) = rcvhwm_bytes;
+        *optvallen_ = sizeof (int64_t);
+        return 0;
+
+    case ZMQ_SWAP:
+        if (*optvallen_ < sizeof (int64_t)) {
+            errno = EINVAL;
+            return -1;
+        }
+        *((int64_t*) optval_) = swap;
+        *optvallen_ = sizeof (int64_t);
+        return 0;
+
+    case ZMQ_TTL:
+        if (*optvallen_ < sizeof (int)) {
+            errno = EINVAL;
+            return -1;
+        }
+        *((int*) optval_) = ttl;
+        *optvallen_ = sizeof (int);
+        return 0;
+
     case ZMQ_AFFINITY:
         if (*optvallen_ < sizeof (uint64_t)) {
             errno = EINVAL;
@@ -385,6 +570,69 @@ int zmq::options_t::getsockopt (int option_, void *optval_, size_t *optvallen_)
         *optvallen_ = sizeof (int);
         return 0;
         
+    case ZMQ_CONFLATE:
+        if (*optvallen_ < sizeof (int)) {
+            errno = EINVAL;
+            return -1;
+        }
+        *((int*) optval_) = conflate;
+        *optvallen_ = sizeof (int);
+        return 0;
+
+    case ZMQ_LAST_VALUE_CACHE:
+        if (*optvallen_ < sizeof (int)) {
+            errno = EINVAL;
+            return -1;
+        }
+        *((int*) optval_) = lvc;
+        *optvallen_ = sizeof (int);
+        return 0;
+
+    case ZMQ_LB_STRATEGY:
+        if (*optvallen_ < sizeof (int)) {
+            errno = EINVAL;
+            return -1;
+        }
+        *((int*) optval_) = lb_strategy;
+        *optvallen_ = sizeof (int);
+        return 0;
+
+    case ZMQ_LB_KEY_SIZE:
+        if (*optvallen_ < sizeof (int)) {
+            errno = EINVAL;
+            return -1;
+        }
+        *((int*) optval_) = lb_key_size;
+        *optvallen_ = sizeof (int);
+        return 0;
+
+    case ZMQ_FQ_WEIGHT:
+        if (*optvallen_ < sizeof (int)) {
+            errno = EINVAL;
+            return -1;
+        }
+        *((int*) optval_) = fq_weight;
+        *optvallen_ = sizeof (int);
+        return 0;
+
+    case ZMQ_COMPRESSION:
+        if (*optvallen_ < sizeof (int)) {
+            errno = EINVAL;
+            return -1;
+        }
+        *((int*) optval_) = compression;
+        *optvallen_ = sizeof (int);
+        return 0;
+
+    case ZMQ_SUBSCRIPTION_BATCH:
+        if (*optvallen_ < sizeof (int)) {
+            errno = EINVAL;
+            return -1;
+        }
+        *((int*) optval_) = subscription_batch;
+        *optvallen_ = sizeof (int);
+        return 0;
+
     case ZMQ_LAST_ENDPOINT:
         // don't allow string which cannot contain the entire message
         if (*optvallen_ < last_endpoint.size() + 1) {
@@ -42,6 +42,18 @@ namespace zmq
         int sndhwm;
         int rcvhwm;
 
+        //  High-water marks for message pipes in bytes. Zero means no limit.
+        int64_t sndhwm_bytes;
+        int64_t rcvhwm_bytes;
+
+        //  Maximal number of bytes to spool to disk once the outbound pipe
+        //  reaches its high-water mark. Zero means no spooling.
+        int64_t swap;
+
+        //  Maximal time in milliseconds a message can wait in the socket's
+        //  queues before being dropped. Zero means no limit.
+        int ttl;
+
         //  I/O thread affinity.
         uint64_t affinity;
 
@@ -110,6 +122,34 @@ namespace zmq
 
         //  Receivers identity from all new connections.
         bool recv_identity;
+
+        //  Length of the topic prefix used to conflate messages on their way
+        //  to subscribers. If negative, messages are not conflated.
+        int conflate;
+
+        //  Length of the topic prefix used to index (X)PUB's last value
+        //  cache. If negative, no messages are cached.
+        int lvc;
+
+        //  Strategy used to choose the pipe to send the next message to
+        //  by load-balancing sockets.
+        int lb_strategy;
+
+        //  Number of leading bytes of the first message part used as the
+        //  routing key by ZMQ_LB_KEY_HASH strategy. Zero means whole part.
+        int lb_key_size;
+
+        //  Number of messages fair-queueing sockets read in a row from
+        //  the connections created while this value is in effect.
+        int fq_weight;
+
+        //  Codec used to compress the data sent over stream connections,
+        //  one of ZMQ_COMPRESSION_* values.
+        int compression;
+
+        //  If 1, (X)SUB sends the subscriptions upstream in batches.
+        //  Peers that don't understand the batches require this to be 0.
+        int subscription_batch;
     };
 
 }
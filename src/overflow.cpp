@@ -0,0 +1,216 @@
+/*
+    Copyright (c) 2009-2011 250bpm s.r.o.
+    Copyright (c) 2007-2011 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <new>
+#include <algorithm>
+
+#include "overflow.hpp"
+#include "err.hpp"
+
+zmq::overflow_t::overflow_t (int conflate_, int64_t swap_) :
+    conflate (conflate_),
+    swap (swap_),
+    spool (NULL),
+    delimited (false),
+    reader_waiting (false),
+    writer_waiting (false)
+{
+}
+
+zmq::overflow_t::~overflow_t ()
+{
+    for (conflated_t::iterator it = conflated.begin ();
+          it != conflated.end (); ++it)
+        close (it->second);
+    for (held_t::iterator it = held.begin (); it != held.end (); ++it)
+        close (*it);
+    delete spool;
+}
+
+bool zmq::overflow_t::check_write ()
+{
+    //  Conflated messages replace the older ones, so there's always space.
+    if (conflate >= 0)
+        return true;
+
+    //  The spool is only ever created by the writer, so if it exists and
+    //  nothing is put aside, there's space for a message for sure.
+    if (spool && empty ())
+        return true;
+
+    sync.lock ();
+
+    //  If the spool can't be created, the swap is switched off and
+    //  the pipe behaves as if there was none.
+    if (!spool && swap > 0) {
+        spool = new (std::nothrow) spool_t ();
+        alloc_assert (spool);
+        if (spool->init () != 0) {
+            delete spool;
+            spool = NULL;
+            swap = 0;
+        }
+    }
+
+    //  Messages that didn't fit on the disk have to be spooled before any
+    //  new ones. If the disk is still full, it is treated the same way as
+    //  an exhausted swap.
+    while (!held.empty () && spool_msg (held.front ()))
+        held.pop_front ();
+
+    bool result = spool && held.empty () && spool->size () < uint64_t (swap);
+    if (!result)
+        writer_waiting = true;
+    sync.unlock ();
+    return result;
+}
+
+bool zmq::overflow_t::write (parts_t &parts_)
+{
+    zmq_assert (!parts_.empty ());
+
+    sync.lock ();
+
+    if (conflate >= 0) {
+
+        //  The topic is determined by the first part of the message, not
+        //  counting the deadline stamp. If there's an older message with
+        //  the same topic, it is replaced, retaining its original position
+        //  in the queue.
+        msg_t &first = parts_ [0].flags () & msg_t::stamp ?
+            parts_ [1] : parts_ [0];
+        size_t size = std::min (first.size (), (size_t) conflate);
+        blob_t topic ((unsigned char*) first.data (), size);
+        conflated_t::iterator it = conflated.find (topic);
+        if (it == conflated.end ()) {
+            it = conflated.insert (conflated_t::value_type (topic,
+                parts_t ())).first;
+            conflated_queue.push_back (it);
+            count.add (1);
+        }
+        else
+            close (it->second);
+        it->second.swap (parts_);
+    }
+    else {
+        zmq_assert (spool);
+        if (!held.empty () || !spool_msg (parts_)) {
+            held.push_back (parts_t ());
+            held.back ().swap (parts_);
+        }
+        count.add (1);
+    }
+
+    bool wake = reader_waiting;
+    reader_waiting = false;
+
+    //  Waiting for the spooled data to get to the disk may take a while,
+    //  so it's done without blocking the reader.
+    bool write_back = spool && spool->write_back_due ();
+    sync.unlock ();
+    if (write_back)
+        spool->write_back ();
+    return wake;
+}
+
+bool zmq::overflow_t::delimit (bool *wake_)
+{
+    sync.lock ();
+    if (empty ()) {
+        sync.unlock ();
+        return false;
+    }
+    delimited = true;
+    *wake_ = reader_waiting;
+    reader_waiting = false;
+    sync.unlock ();
+    return true;
+}
+
+bool zmq::overflow_t::check_read (bool *delimited_)
+{
+    //  Nothing's been put aside since the reader started waiting.
+    if (empty () && reader_waiting) {
+        *delimited_ = false;
+        return false;
+    }
+
+    sync.lock ();
+    bool result = !conflated_queue.empty () ||
+        (spool && spool->has_msg ()) || !held.empty ();
+    if (!result) {
+        *delimited_ = delimited;
+        reader_waiting = !delimited;
+    }
+    sync.unlock ();
+    return result;
+}
+
+void zmq::overflow_t::read (parts_t &parts_, bool *writable_)
+{
+    sync.lock ();
+
+    if (!conflated_queue.empty ()) {
+        conflated_t::iterator it = conflated_queue.front ();
+        parts_.swap (it->second);
+        conflated.erase (it);
+        conflated_queue.pop_front ();
+    }
+    else if (!spool->has_msg ()) {
+        parts_.swap (held.front ());
+        held.pop_front ();
+    }
+    else {
+        bool more = true;
+        while (more) {
+            msg_t msg;
+            bool ok = spool->read (&msg);
+            zmq_assert (ok);
+            more = msg.flags () & msg_t::more ? true : false;
+            parts_.push_back (msg);
+        }
+    }
+    count.sub (1);
+
+    *writable_ = writer_waiting && (conflate >= 0 ||
+        (held.empty () && spool->size () < uint64_t (swap)));
+    if (*writable_)
+        writer_waiting = false;
+
+    sync.unlock ();
+}
+
+bool zmq::overflow_t::spool_msg (parts_t &parts_)
+{
+    for (parts_t::size_type i = 0; i != parts_.size (); i++)
+        if (!spool->write (parts_ [i], i + 1 != parts_.size ()))
+            return false;
+    close (parts_);
+    return true;
+}
+
+void zmq::overflow_t::close (parts_t &parts_)
+{
+    for (parts_t::size_type i = 0; i != parts_.size (); i++) {
+        int rc = parts_ [i].close ();
+        errno_assert (rc == 0);
+    }
+    parts_.clear ();
+}
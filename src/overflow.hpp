@@ -0,0 +1,149 @@
+/*
+    Copyright (c) 2009-2011 250bpm s.r.o.
+    Copyright (c) 2007-2011 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __ZMQ_OVERFLOW_HPP_INCLUDED__
+#define __ZMQ_OVERFLOW_HPP_INCLUDED__
+
+#include <map>
+#include <deque>
+#include <vector>
+
+#include "msg.hpp"
+#include "blob.hpp"
+#include "mutex.hpp"
+#include "spool.hpp"
+#include "stdint.hpp"
+#include "atomic_counter.hpp"
+
+namespace zmq
+{
+
+    //  Messages that haven't fit into the pipe. The writer puts complete
+    //  messages aside here once the pipe reaches its high watermark and
+    //  the reader takes them directly once it has read everything from
+    //  the pipe, so that the put-aside messages flow even if the writer
+    //  stays idle. The messages are either conflated, keeping the latest
+    //  message per topic, or spooled to disk in the order they were
+    //  written. Messages that can't be spooled because the disk is full
+    //  are held in memory and the writer is told there's no more space
+    //  till they are spooled or taken by the reader. Unlike the pipe
+    //  itself, the object is accessed by both the writer and the reader,
+    //  so the access is synchronised. The number of messages put aside
+    //  is maintained outside of the lock so that the common case of no
+    //  messages being put aside doesn't need locking.
+
+    class overflow_t
+    {
+    public:
+
+        typedef std::vector <msg_t> parts_t;
+
+        //  If conflate_ is non-negative, it is the length of the topic
+        //  prefix used to conflate the messages. Otherwise the messages
+        //  are spooled to disk, up to swap_ bytes.
+        overflow_t (int conflate_, int64_t swap_);
+        ~overflow_t ();
+
+        //  Returns true if there are no messages put aside. Doesn't lock.
+        inline bool empty ()
+        {
+            return count.get () == 0;
+        }
+
+        //  Returns true if another message can be put aside. If not,
+        //  the writer is marked as waiting for the reader to make space.
+        bool check_write ();
+
+        //  Puts the complete message aside. The parts are taken over.
+        //  Returns true if the reader is waiting for messages and has to
+        //  be woken up.
+        bool write (parts_t &parts_);
+
+        //  Marks the end of the message stream, unless there are no
+        //  messages put aside. Returns false in such case. wake_ is set
+        //  the same way as by write.
+        bool delimit (bool *wake_);
+
+        //  Returns true if there's a message to take. If not, the reader
+        //  is marked as waiting for messages, unless the end of the message
+        //  stream was reached, in which case delimited_ is set.
+        bool check_read (bool *delimited_);
+
+        //  Takes the next message. Mustn't be called unless check_read
+        //  returned true. writable_ is set if the writer was waiting
+        //  for space and can go on now.
+        void read (parts_t &parts_, bool *writable_);
+
+    private:
+
+        //  Closes all the parts and clears the vector.
+        static void close (parts_t &parts_);
+
+        //  Writes the message to the spool. The parts are closed unless
+        //  the spool is out of disk space, in which case false is returned.
+        bool spool_msg (parts_t &parts_);
+
+        //  Length of the topic prefix, negative if not conflating.
+        int conflate;
+
+        //  Conflated messages indexed by topic, at most one per topic.
+        //  Queue holds the topics in the order they should be read.
+        typedef std::map <blob_t, parts_t> conflated_t;
+        conflated_t conflated;
+        typedef std::deque <conflated_t::iterator> conflated_queue_t;
+        conflated_queue_t conflated_queue;
+
+        //  Maximal size of the spool in bytes and the spool itself.
+        //  The spool is created on first use. If it can't be created,
+        //  swap is set to zero and no messages are accepted.
+        int64_t swap;
+        spool_t *spool;
+
+        //  Messages that couldn't be spooled, in the order they were
+        //  written. They follow the messages in the spool.
+        typedef std::deque <parts_t> held_t;
+        held_t held;
+
+        //  Number of messages put aside. Changed under the lock, but can be
+        //  read without it.
+        atomic_counter_t count;
+
+        //  True if the end of the message stream was marked.
+        bool delimited;
+
+        //  True if the reader found no messages and waits for more. Only
+        //  the reader sets it, and only the writer resets it, after it has
+        //  increased the count. Thus, if the reader sees the flag still set
+        //  after seeing the count at zero, the writer is bound to wake it up
+        //  and the reader needn't lock. Volatile as it's read without it.
+        volatile bool reader_waiting;
+
+        //  True if the writer found no space and waits for the reader.
+        bool writer_waiting;
+
+        mutex_t sync;
+
+        overflow_t (const overflow_t&);
+        const overflow_t &operator = (const overflow_t&);
+    };
+
+}
+
+#endif
@@ -240,7 +240,7 @@ void zmq::pgm_receiver_t::in_event ()
 
         //  Push all the data to the decoder.
         ssize_t processed = it->second.decoder->process_buffer (data, received);
-        if (processed < received) {
+        if (processed < received || it->second.decoder->stuck ()) {
             //  Save some state so we can resume the decoding process later.
             pending_bytes = received - processed;
             pending_ptr = data + processed;
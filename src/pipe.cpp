@@ -22,26 +22,40 @@
 
 #include <new>
 #include <stddef.h>
+#include <string.h>
+#include <algorithm>
 
 #include "pipe.hpp"
+#include "ctx.hpp"
+#include "wire.hpp"
 #include "err.hpp"
 
 int zmq::pipepair (class object_t *parents_ [2], class pipe_t* pipes_ [2],
-    int hwms_ [2], bool delays_ [2])
+    int hwms_ [2], int64_t hwm_bytes_ [2], bool delays_ [2],
+    int conflates_ [2])
 {
     //   Creates two pipe objects. These objects are connected by two ypipes,
-    //   each to pass messages in one direction.
+    //   each to pass messages in one direction. The ypipes share the memory
+    //   chunks with other pipes in the context.
 
-    pipe_t::upipe_t *upipe1 = new (std::nothrow) pipe_t::upipe_t ();
+    chunk_pool_t *pool = parents_ [0]->get_ctx ()->get_chunk_pool ();
+    pipe_t::upipe_t *upipe1 = new (std::nothrow) pipe_t::upipe_t (pool);
     alloc_assert (upipe1);
-    pipe_t::upipe_t *upipe2 = new (std::nothrow) pipe_t::upipe_t ();
+    pipe_t::upipe_t *upipe2 = new (std::nothrow) pipe_t::upipe_t (pool);
     alloc_assert (upipe2);
 
+    //  The memory is charged by one end of the pipe and released by
+    //  the other, so both have to agree on the budget. The limit may be
+    //  set concurrently, hence the budget is looked up only once.
+    memory_budget_t *budget = parents_ [0]->get_ctx ()->get_memory_budget ();
+
     pipes_ [0] = new (std::nothrow) pipe_t (parents_ [0], upipe1, upipe2,
-        hwms_ [1], hwms_ [0], delays_ [0]);
+        hwms_ [1], hwms_ [0], hwm_bytes_ [1], hwm_bytes_ [0], delays_ [0],
+        conflates_ [0], budget);
     alloc_assert (pipes_ [0]);
     pipes_ [1] = new (std::nothrow) pipe_t (parents_ [1], upipe2, upipe1,
-        hwms_ [0], hwms_ [1], delays_ [1]);
+        hwms_ [0], hwms_ [1], hwm_bytes_ [0], hwm_bytes_ [1], delays_ [1],
+        conflates_ [1], budget);
     alloc_assert (pipes_ [1]);
 
     pipes_ [0]->set_peer (pipes_ [1]);
@@ -51,10 +65,13 @@ int zmq::pipepair (class object_t *parents_ [2], class pipe_t* pipes_ [2],
 }
 
 zmq::pipe_t::pipe_t (object_t *parent_, upipe_t *inpipe_, upipe_t *outpipe_,
-      int inhwm_, int outhwm_, bool delay_) :
+      int inhwm_, int outhwm_, int64_t inhwm_bytes_, int64_t outhwm_bytes_,
+      bool delay_, int conflate_, memory_budget_t *budget_) :
     object_t (parent_),
     inpipe (inpipe_),
     outpipe (outpipe_),
+    urgent_inpipe (NULL),
+    urgent_outpipe (NULL),
     in_active (true),
     out_active (true),
     hwm (outhwm_),
@@ -62,15 +79,47 @@ zmq::pipe_t::pipe_t (object_t *parent_, upipe_t *inpipe_, upipe_t *outpipe_,
     msgs_read (0),
     msgs_written (0),
     peers_msgs_read (0),
+    hwm_bytes (outhwm_bytes_),
+    lwm_bytes ((inhwm_bytes_ + 1) / 2),
+    bytes_read (0),
+    bytes_written (0),
+    bytes_more (0),
+    msgs_acked (0),
+    bytes_acked (0),
+    batch_reading (false),
+    peers_bytes_read (0),
+    urgent_msgs_read (0),
+    urgent_msgs_written (0),
+    urgent_msgs_acked (0),
+    peers_urgent_msgs_read (0),
     peer (NULL),
+    budget (budget_),
     sink (NULL),
     state (active),
-    delay (delay_)
+    delay (delay_),
+    weight (1),
+    identity_size (0),
+    more_out (false),
+    urgent_out (false),
+    more_in (false),
+    urgent_in (false),
+    inoverflow (NULL),
+    outoverflow (NULL),
+    overflowing (false),
+    parts_in_pos (0),
+    ttl (0),
+    expired (NULL)
 {
+    if (conflate_ >= 0) {
+        outoverflow = new (std::nothrow) overflow_t (conflate_, 0);
+        alloc_assert (outoverflow);
+    }
 }
 
 zmq::pipe_t::~pipe_t ()
 {
+    close_parts (parts_out);
+    drop_fetched ();
 }
 
 void zmq::pipe_t::set_peer (pipe_t *peer_)
@@ -78,6 +127,7 @@ void zmq::pipe_t::set_peer (pipe_t *peer_)
     //  Peer can be set once only.
     zmq_assert (!peer);
     peer = peer_;
+    peer->inoverflow = outoverflow;
 }
 
 void zmq::pipe_t::set_event_sink (i_pipe_events *sink_)
@@ -87,25 +137,111 @@ void zmq::pipe_t::set_event_sink (i_pipe_events *sink_)
     sink = sink_;
 }
 
-void zmq::pipe_t::set_identity (const blob_t &identity_)
+void zmq::pipe_t::set_identity (const unsigned char *data_, size_t size_)
+{
+    zmq_assert (size_ <= sizeof identity);
+    identity_size = (unsigned char) size_;
+    memcpy (identity, data_, size_);
+}
+
+void zmq::pipe_t::set_endpoint (const std::string &endpoint_)
+{
+    endpoint = endpoint_;
+}
+
+const std::string &zmq::pipe_t::get_endpoint ()
+{
+    return endpoint;
+}
+
+void zmq::pipe_t::set_weight (int weight_)
+{
+    zmq_assert (weight_ > 0);
+    weight = weight_;
+}
+
+int zmq::pipe_t::get_weight ()
+{
+    return weight;
+}
+
+void zmq::pipe_t::set_ttl (int ttl_, atomic_counter_t *expired_)
+{
+    zmq_assert (ttl_ >= 0);
+    ttl = ttl_;
+
+    //  The pipes are not attached yet, so the peer can be set up from here.
+    peer->expired = expired_;
+}
+
+void zmq::pipe_t::set_swap (int64_t swap_)
 {
-    identity = identity_;
+    zmq_assert (swap_ >= 0);
+
+    //  The pipes are not attached yet, so the peer can be set up from here.
+    //  Conflating pipe has its overflow already.
+    if (swap_ > 0 && !outoverflow) {
+        outoverflow = new (std::nothrow) overflow_t (-1, swap_);
+        alloc_assert (outoverflow);
+        peer->inoverflow = outoverflow;
+    }
 }
 
-zmq::blob_t zmq::pipe_t::get_identity ()
+const unsigned char *zmq::pipe_t::get_identity ()
 {
     return identity;
 }
 
+size_t zmq::pipe_t::get_identity_size ()
+{
+    return identity_size;
+}
+
 bool zmq::pipe_t::check_read ()
 {
     if (unlikely (!in_active || (state != active && state != pending)))
         return false;
 
-    //  Check if there's an item in the pipe.
-    if (!inpipe->check_read ()) {
-        in_active = false;
-        return false;
+    //  Urgent messages are read first. Once a message is started, the rest
+    //  of it is read from the same lane.
+    if (unlikely (urgent_inpipe != NULL) &&
+          (more_in ? urgent_in : check_urgent ()))
+        return true;
+
+    //  Messages fetched from the overflow precede those in the pipe.
+    if (unlikely (has_fetched ()))
+        return true;
+
+    //  Check if there's an item in the pipe. Messages that expired while
+    //  waiting in the pipe are dropped on the way. Once the pipe is drained,
+    //  the messages put aside by the writer follow.
+    while (true) {
+        if (!inpipe->check_read ()) {
+            bool delimited;
+            if (check_overflow (&delimited)) {
+                if (has_fetched ())
+                    return true;
+                continue;
+            }
+            if (delimited) {
+                delimit ();
+                return false;
+            }
+
+            in_active = false;
+
+            //  Writer blocked by the memory budget waits for the pipe to be
+            //  drained. Let it know.
+            if (budget && msgs_read != msgs_acked)
+                acknowledge ();
+            return false;
+        }
+        if (likely (!inpipe->probe (is_stamp)))
+            break;
+        msg_t stamp;
+        bool ok = inpipe->read (&stamp);
+        zmq_assert (ok);
+        expire (&stamp, inpipe);
     }
 
     //  If the next item in the pipe is message delimiter,
@@ -126,9 +262,51 @@ bool zmq::pipe_t::read (msg_t *msg_)
     if (unlikely (!in_active || (state != active && state != pending)))
         return false;
 
-    if (!inpipe->read (msg_)) {
-        in_active = false;
-        return false;
+    upipe_t *lane;
+    while (true) {
+
+        //  Urgent messages are read first. Once a message is started, the
+        //  rest of it is read from the same lane.
+        lane = inpipe;
+        if (unlikely (urgent_inpipe != NULL) &&
+              (more_in ? urgent_in : urgent_inpipe->check_read ()))
+            lane = urgent_inpipe;
+
+        //  Messages fetched from the overflow precede those in the pipe.
+        //  They are not accounted for by the watermarks nor the budget.
+        if (unlikely (lane == inpipe && has_fetched ())) {
+            *msg_ = parts_in [parts_in_pos++];
+            if (parts_in_pos == parts_in.size ()) {
+                parts_in.clear ();
+                parts_in_pos = 0;
+            }
+            more_in = msg_->flags () & msg_t::more ? true : false;
+            urgent_in = false;
+            return true;
+        }
+
+        if (!lane->read (msg_)) {
+
+            //  Once the pipe is drained, the messages put aside by
+            //  the writer follow.
+            bool delimited = false;
+            if (lane == inpipe && check_overflow (&delimited))
+                continue;
+            if (delimited) {
+                delimit ();
+                return false;
+            }
+
+            in_active = false;
+            if (budget && msgs_read != msgs_acked)
+                acknowledge ();
+            return false;
+        }
+
+        //  Messages that expired while waiting in the pipe are dropped.
+        if (likely (!(msg_->flags () & msg_t::stamp)))
+            break;
+        expire (msg_, lane);
     }
 
     //  If delimiter was read, start termination process of the pipe.
@@ -137,23 +315,69 @@ bool zmq::pipe_t::read (msg_t *msg_)
         return false;
     }
 
-    if (!(msg_->flags () & msg_t::more))
-        msgs_read++;
+    if (budget)
+        budget->release (footprint (*msg_));
 
-    if (lwm > 0 && msgs_read % lwm == 0)
-        send_activate_write (peer, msgs_read);
+    more_in = msg_->flags () & msg_t::more ? true : false;
+    urgent_in = lane == urgent_inpipe;
+    bytes_read += msg_->size ();
+    if (!more_in)
+        message_read (urgent_in);
 
     return true;
 }
 
+size_t zmq::pipe_t::read (msg_t *msgs_, size_t count_)
+{
+    //  Only the first read may find the pipe empty and mark the reader as
+    //  asleep. The rest of the batch is taken from the messages already
+    //  prefetched. That way a drained pipe is not put to sleep when there
+    //  are messages to process anyway, forcing the writer to wake the
+    //  reader up afterwards.
+    batch_reading = true;
+    size_t n = 0;
+    if (count_ && read (&msgs_ [0])) {
+        n = 1;
+        while (n != count_ && (inpipe->prefetched () || has_fetched ()) &&
+              read (&msgs_ [n]))
+            n++;
+    }
+    batch_reading = false;
+
+    //  Once the pipe starts terminating, the peer may be gone any time.
+    if ((state == active || state == pending) && ack_due ())
+        acknowledge ();
+
+    return n;
+}
+
 bool zmq::pipe_t::check_write (msg_t *msg_)
 {
-    if (unlikely (!out_active || state != active))
+    if (unlikely (state != active))
         return false;
 
-    bool full = hwm > 0 && msgs_written - peers_msgs_read == uint64_t (hwm);
+    //  The limits are checked at the beginning of a message only. Once
+    //  the first part is written, the rest of the message is accepted.
+    if (more_out)
+        return true;
+
+    //  Urgent messages are never conflated or spooled. They have an
+    //  allowance of their own so that they get through even if the pipe
+    //  is full of other messages. Thus they don't care whether the pipe
+    //  is active.
+    if (unlikely (msg_->flags () & msg_t::urgent)) {
+        if (unlikely (is_urgent_full ())) {
+            out_active = false;
+            return false;
+        }
+        return true;
+    }
 
-    if (unlikely (full)) {
+    //  The message has to be put aside if there are older messages put
+    //  aside already, so the overflow's limit applies in such case.
+    if (unlikely (!out_active ||
+          ((is_full () || (outoverflow && !outoverflow->empty ())) &&
+          !(outoverflow && outoverflow->check_write ())))) {
         out_active = false;
         return false;
     }
@@ -166,25 +390,120 @@ bool zmq::pipe_t::write (msg_t *msg_)
     if (unlikely (!check_write (msg_)))
         return false;
 
-    bool more = msg_->flags () & msg_t::more ? true : false;
-    outpipe->write (*msg_, more);
-    if (!more)
-        msgs_written++;
+    write_part (msg_, false);
+    return true;
+}
 
+size_t zmq::pipe_t::write (msg_t *msgs_, size_t count_)
+{
+    size_t n = 0;
+    while (n != count_ && write (&msgs_ [n]))
+        n++;
+    return n;
+}
+
+bool zmq::pipe_t::write_control (msg_t *msg_)
+{
+    zmq_assert (!(msg_->flags () & msg_t::more));
+    if (unlikely (state != active || more_out))
+        return false;
+
+    write_part (msg_, true);
     return true;
 }
 
+void zmq::pipe_t::write_part (msg_t *msg_, bool control_)
+{
+    bool more = msg_->flags () & msg_t::more ? true : false;
+
+    //  The lane is chosen according to the first part of the message.
+    if (!more_out)
+        urgent_out = msg_->flags () & msg_t::urgent ? true : false;
+
+    //  Each message is preceded by its deadline stamp, if required. Identity
+    //  messages are never stamped as they must not be dropped.
+    bool stamped = ttl > 0 && !more_out &&
+        !(msg_->flags () & msg_t::identity);
+
+    //  The message is put aside if the pipe is full or if there are older
+    //  messages put aside already. All the parts of the message go to
+    //  the same place as the first one.
+    if (unlikely (outoverflow != NULL && !urgent_out)) {
+        if (!more_out)
+            overflowing = (!control_ && is_full ()) || !outoverflow->empty ();
+        if (overflowing) {
+            if (unlikely (stamped)) {
+                msg_t stamp;
+                init_stamp (stamp);
+                parts_out.push_back (stamp);
+            }
+            parts_out.push_back (*msg_);
+            more_out = more;
+            if (!more) {
+
+                //  Messages written to the pipe are read before the ones
+                //  put aside, so make them visible to the reader first.
+                flush ();
+                if (outoverflow->write (parts_out))
+                    send_activate_read (peer);
+                zmq_assert (parts_out.empty ());
+            }
+            return;
+        }
+    }
+
+    //  The lane for urgent messages is created on first use.
+    upipe_t *lane = outpipe;
+    if (unlikely (urgent_out)) {
+        if (!urgent_outpipe) {
+            urgent_outpipe = new (std::nothrow) upipe_t (
+                get_ctx ()->get_chunk_pool ());
+            alloc_assert (urgent_outpipe);
+            send_urgent_lane (peer, (void*) urgent_outpipe);
+        }
+        lane = urgent_outpipe;
+    }
+
+    if (unlikely (stamped))
+        write_stamp (lane);
+    bytes_more += msg_->size ();
+    if (budget)
+        budget->charge (footprint (*msg_));
+    lane->write (*msg_, more);
+    more_out = more;
+    if (!more) {
+        msgs_written++;
+        if (urgent_out)
+            urgent_msgs_written++;
+        bytes_written += bytes_more;
+        bytes_more = 0;
+    }
+}
+
 void zmq::pipe_t::rollback ()
 {
     //  Remove incomplete message from the outbound pipe.
     msg_t msg;
     if (outpipe) {
-		while (outpipe->unwrite (&msg)) {
+		upipe_t *lane = urgent_out ? urgent_outpipe : outpipe;
+		while (lane->unwrite (&msg)) {
 		    zmq_assert (msg.flags () & msg_t::more);
+		    if (budget)
+		        budget->release (footprint (msg));
 		    int rc = msg.close ();
 		    errno_assert (rc == 0);
 		}
     }
+    bytes_more = 0;
+
+    //  Remove incomplete message being put aside. It hasn't been passed to
+    //  the overflow yet, so the older message with the same topic, if any,
+    //  is retained.
+    close_parts (parts_out);
+
+    more_out = false;
+    urgent_out = false;
+    overflowing = false;
 }
 
 void zmq::pipe_t::flush ()
@@ -197,7 +516,14 @@ void zmq::pipe_t::flush ()
     if (state == terminating)
         return;
 
-    if (outpipe && !outpipe->flush ())
+    if (!outpipe)
+        return;
+
+    //  Reader may be waiting for either of the lanes.
+    bool dormant = urgent_outpipe && !urgent_outpipe->flush ();
+    if (!outpipe->flush ())
+        dormant = true;
+    if (dormant)
         send_activate_read (peer);
 }
 
@@ -209,10 +535,13 @@ void zmq::pipe_t::process_activate_read ()
     }
 }
 
-void zmq::pipe_t::process_activate_write (uint64_t msgs_read_)
+void zmq::pipe_t::process_activate_write (uint64_t msgs_read_,
+    uint64_t bytes_read_, uint64_t urgent_msgs_read_)
 {
     //  Remember the peers's message sequence number.
     peers_msgs_read = msgs_read_;
+    peers_bytes_read = bytes_read_;
+    peers_urgent_msgs_read = urgent_msgs_read_;
 
     if (!out_active && state == active) {
         out_active = true;
@@ -220,6 +549,19 @@ void zmq::pipe_t::process_activate_write (uint64_t msgs_read_)
     }
 }
 
+void zmq::pipe_t::process_urgent_lane (void *pipe_)
+{
+    zmq_assert (!urgent_inpipe);
+    urgent_inpipe = (upipe_t*) pipe_;
+
+    //  The writer doesn't know whether we are waiting for messages and
+    //  there may already be urgent messages in the lane.
+    if (!in_active && (state == active || state == pending)) {
+        in_active = true;
+        sink->read_activated (this);
+    }
+}
+
 void zmq::pipe_t::process_hiccup (void *pipe_)
 {
     //  Destroy old outpipe. Note that the read end of the pipe was already
@@ -228,6 +570,8 @@ void zmq::pipe_t::process_hiccup (void *pipe_)
     outpipe->flush ();
     msg_t msg;
     while (outpipe->read (&msg)) {
+       if (budget && !msg.is_delimiter ())
+           budget->release (footprint (msg));
        int rc = msg.close ();
        errno_assert (rc == 0);
     }
@@ -254,6 +598,7 @@ void zmq::pipe_t::process_pipe_term ()
         if (!delay) {
             state = terminating;
             outpipe = NULL;
+            outoverflow = NULL;
             send_pipe_term_ack (peer);
             return;
         }
@@ -268,6 +613,7 @@ void zmq::pipe_t::process_pipe_term ()
     if (state == delimited) {
         state = terminating;
         outpipe = NULL;
+        outoverflow = NULL;
         send_pipe_term_ack (peer);
         return;
     }
@@ -278,6 +624,7 @@ void zmq::pipe_t::process_pipe_term ()
     if (state == terminated) {
         state = double_terminated;
         outpipe = NULL;
+        outoverflow = NULL;
         send_pipe_term_ack (peer);
         return;
     }
@@ -300,6 +647,7 @@ void zmq::pipe_t::process_pipe_term_ack ()
     else if (state == double_terminated);
     else if (state == terminated) {
         outpipe = NULL;
+        outoverflow = NULL;
         send_pipe_term_ack (peer);
     }
     else
@@ -309,13 +657,22 @@ void zmq::pipe_t::process_pipe_term_ack ()
     //  pipe (which is an inbound pipe from its point of view).
     //  First, delete all the unread messages in the pipe. We have to do it by
     //  hand because msg_t doesn't have automatic destructor. Then deallocate
-    //  the ypipe itself.
-    msg_t msg;
-    while (inpipe->read (&msg)) {
-       int rc = msg.close ();
-       errno_assert (rc == 0);
+    //  the ypipe itself. Same applies to the lane for urgent messages and
+    //  to the messages put aside.
+    upipe_t *lanes [2] = {inpipe, urgent_inpipe};
+    for (int i = 0; i != 2; i++) {
+        if (!lanes [i])
+            continue;
+        msg_t msg;
+        while (lanes [i]->read (&msg)) {
+           if (budget && !msg.is_delimiter ())
+               budget->release (footprint (msg));
+           int rc = msg.close ();
+           errno_assert (rc == 0);
+        }
+        delete lanes [i];
     }
-    delete inpipe;
+    delete inoverflow;
 
     //  Deallocate the pipe object
     delete this;
@@ -346,6 +703,7 @@ void zmq::pipe_t::terminate (bool delay_)
     //  'terminate'. We can act as if all the pending messages were read.
     else if (state == pending && !delay) {
             outpipe = NULL;
+            outoverflow = NULL;
             send_pipe_term_ack (peer);
             state = terminating;
     }
@@ -376,10 +734,17 @@ void zmq::pipe_t::terminate (bool delay_)
 
 		//  Push delimiter into the outbound pipe. Note that watermarks are not
 		//  checked thus the delimiter can be written even though the pipe is full.
-		msg_t msg;
-		msg.init_delimiter ();
-		outpipe->write (msg, false);
+		//  If there are messages put aside, the delimiter is put after them
+		//  instead so that the reader gets them before the pipe terminates.
+		bool wake = false;
+		if (!outoverflow || !outoverflow->delimit (&wake)) {
+		    msg_t msg;
+		    msg.init_delimiter ();
+		    outpipe->write (msg, false);
+		}
 		flush ();
+		if (wake)
+		    send_activate_read (peer);
     }
 }
 
@@ -388,6 +753,11 @@ bool zmq::pipe_t::is_delimiter (msg_t &msg_)
     return msg_.is_delimiter ();
 }
 
+bool zmq::pipe_t::is_stamp (msg_t &msg_)
+{
+    return msg_.flags () & msg_t::stamp ? true : false;
+}
+
 int zmq::pipe_t::compute_lwm (int hwm_)
 {
     //  Compute the low water mark. Following point should be taken
@@ -416,6 +786,190 @@ int zmq::pipe_t::compute_lwm (int hwm_)
     return result;
 }
 
+uint64_t zmq::pipe_t::get_outstanding ()
+{
+    return msgs_written - peers_msgs_read;
+}
+
+bool zmq::pipe_t::is_full ()
+{
+    //  Byte limit is checked before the message is written, so a single
+    //  message larger than the limit still gets through.
+    //  Memory budget is shared with other pipes that may hold all of it.
+    //  To make sure the writer is eventually woken up, the pipe is never
+    //  considered full because of the budget when the peer has read all
+    //  the messages written. Thus each pipe can exceed the budget by one
+    //  message at most.
+    return (hwm > 0 && msgs_written - peers_msgs_read >= uint64_t (hwm)) ||
+        (hwm_bytes > 0 && bytes_written - peers_bytes_read >= hwm_bytes) ||
+        (budget && msgs_written != peers_msgs_read && budget->exceeded ());
+}
+
+bool zmq::pipe_t::is_urgent_full ()
+{
+    //  The high watermarks and the memory budget don't apply. Urgent
+    //  messages are still accounted for by them, so the other messages
+    //  wait till the urgent ones are read.
+    return urgent_msgs_written - peers_urgent_msgs_read >=
+        uint64_t (urgent_hwm);
+}
+
+void zmq::pipe_t::acknowledge ()
+{
+    msgs_acked = msgs_read;
+    bytes_acked = bytes_read;
+    urgent_msgs_acked = urgent_msgs_read;
+    send_activate_write (peer, msgs_read, bytes_read, urgent_msgs_read);
+}
+
+void zmq::pipe_t::message_read (bool urgent_)
+{
+    //  Once in a while, let the writer know how many messages and bytes were
+    //  read so that it can go on writing. Given that the writer accounts for
+    //  whole messages, this is done only at message boundaries.
+    msgs_read++;
+    if (urgent_)
+        urgent_msgs_read++;
+    if (!batch_reading && ack_due ())
+        acknowledge ();
+}
+
+bool zmq::pipe_t::ack_due ()
+{
+    return (lwm > 0 && msgs_read - msgs_acked >= uint64_t (lwm)) ||
+        (lwm_bytes > 0 && bytes_read - bytes_acked >= lwm_bytes) ||
+        urgent_msgs_read - urgent_msgs_acked >= uint64_t (urgent_hwm + 1) / 2;
+}
+
+void zmq::pipe_t::init_stamp (msg_t &msg_)
+{
+    int rc = msg_.init_size (8);
+    errno_assert (rc == 0);
+    put_uint64 ((unsigned char*) msg_.data (), clock.now_ms () + ttl);
+    msg_.set_flags (msg_t::more | msg_t::stamp);
+}
+
+void zmq::pipe_t::write_stamp (upipe_t *lane_)
+{
+    //  Stamp is written as a part of the message so that it can't be read
+    //  before the message is complete and is rolled back along with it.
+    msg_t stamp;
+    init_stamp (stamp);
+    if (budget)
+        budget->charge (footprint (stamp));
+    lane_->write (stamp, true);
+}
+
+void zmq::pipe_t::expire (msg_t *stamp_, upipe_t *lane_)
+{
+    uint64_t deadline = get_uint64 ((unsigned char*) stamp_->data ());
+    if (budget)
+        budget->release (footprint (*stamp_));
+    int rc = stamp_->close ();
+    errno_assert (rc == 0);
+    if (likely (clock.now_ms () < deadline))
+        return;
+
+    //  Drop the whole message. It is accounted for as read so that it
+    //  doesn't hold the writer back.
+    bool more = true;
+    while (more) {
+        msg_t msg;
+        bool ok = lane_->read (&msg);
+        zmq_assert (ok);
+        more = msg.flags () & msg_t::more ? true : false;
+        bytes_read += msg.size ();
+        if (budget)
+            budget->release (footprint (msg));
+        rc = msg.close ();
+        errno_assert (rc == 0);
+    }
+    if (expired)
+        expired->add (1);
+    message_read (lane_ == urgent_inpipe);
+}
+
+bool zmq::pipe_t::check_urgent ()
+{
+    while (urgent_inpipe->check_read ()) {
+        if (likely (!urgent_inpipe->probe (is_stamp)))
+            return true;
+        msg_t stamp;
+        bool ok = urgent_inpipe->read (&stamp);
+        zmq_assert (ok);
+        expire (&stamp, urgent_inpipe);
+    }
+    return false;
+}
+
+size_t zmq::pipe_t::footprint (msg_t &msg_)
+{
+    return sizeof (msg_t) + msg_.size ();
+}
+
+bool zmq::pipe_t::check_overflow (bool *delimited_)
+{
+    *delimited_ = false;
+    if (!inoverflow)
+        return false;
+
+    while (inoverflow->check_read (delimited_)) {
+
+        //  Messages written to the pipe before the first message was put
+        //  aside have to be read first. Once there's a message put aside,
+        //  the writer doesn't write to the pipe till it's taken, so it's
+        //  enough to check the pipe once more at this point.
+        if (inpipe->check_read ())
+            return true;
+
+        bool writable;
+        inoverflow->read (parts_in, &writable);
+        parts_in_pos = 0;
+
+        //  The writer waits for the space in the overflow.
+        if (writable)
+            acknowledge ();
+
+        //  Drop the message if it has expired while put aside.
+        if (!(parts_in [0].flags () & msg_t::stamp))
+            return true;
+        uint64_t deadline = get_uint64 ((unsigned char*) parts_in [0].data ());
+        int rc = parts_in [0].close ();
+        errno_assert (rc == 0);
+        parts_in_pos = 1;
+        if (likely (clock.now_ms () < deadline))
+            return true;
+        drop_fetched ();
+        if (expired)
+            expired->add (1);
+    }
+    return false;
+}
+
+bool zmq::pipe_t::has_fetched ()
+{
+    return parts_in_pos != parts_in.size ();
+}
+
+void zmq::pipe_t::drop_fetched ()
+{
+    for (; parts_in_pos != parts_in.size (); parts_in_pos++) {
+        int rc = parts_in [parts_in_pos].close ();
+        errno_assert (rc == 0);
+    }
+    parts_in.clear ();
+    parts_in_pos = 0;
+}
+
+void zmq::pipe_t::close_parts (overflow_t::parts_t &parts_)
+{
+    for (overflow_t::parts_t::size_type i = 0; i != parts_.size (); i++) {
+        int rc = parts_ [i].close ();
+        errno_assert (rc == 0);
+    }
+    parts_.clear ();
+}
+
 void zmq::pipe_t::delimit ()
 {
     if (state == active) {
@@ -425,6 +979,7 @@ void zmq::pipe_t::delimit ()
 
     if (state == pending) {
         outpipe = NULL;
+        outoverflow = NULL;
         send_pipe_term_ack (peer);
         state = terminating;
         return;
@@ -444,10 +999,14 @@ void zmq::pipe_t::hiccup ()
     //  responsible for deallocating it.
     inpipe = NULL;
 
-    //  Create new inpipe.
-    inpipe = new (std::nothrow) pipe_t::upipe_t ();
+    //  Create new inpipe. Parts of the message being read from the old one
+    //  won't arrive any more.
+    inpipe = new (std::nothrow) pipe_t::upipe_t (
+        get_ctx ()->get_chunk_pool ());
     alloc_assert (inpipe);
     in_active = true;
+    if (!urgent_in && !has_fetched ())
+        more_in = false;
 
     //  Notify the peer about the hiccup.
     send_hiccup (peer, (void*) inpipe);
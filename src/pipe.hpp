@@ -23,13 +23,18 @@
 #ifndef __ZMQ_PIPE_HPP_INCLUDED__
 #define __ZMQ_PIPE_HPP_INCLUDED__
 
+#include <string>
+
 #include "msg.hpp"
 #include "ypipe.hpp"
 #include "config.hpp"
 #include "object.hpp"
 #include "stdint.hpp"
 #include "array.hpp"
-#include "blob.hpp"
+#include "memory_budget.hpp"
+#include "overflow.hpp"
+#include "clock.hpp"
+#include "atomic_counter.hpp"
 
 namespace zmq
 {
@@ -40,11 +45,16 @@ namespace zmq
     //  Create a pipepair for bi-directional transfer of messages.
     //  First HWM is for messages passed from first pipe to the second pipe.
     //  Second HWM is for messages passed from second pipe to the first pipe.
+    //  Byte HWMs limit the total size of the messages in the same manner.
     //  Delay specifies how the pipe behaves when the peer terminates. If true
     //  pipe receives all the pending messages before terminating, otherwise it
     //  terminates straight away.
+    //  Conflate specifies, for each direction, the length of the topic prefix
+    //  used to conflate messages that exceed the HWM. Negative value means
+    //  that no conflation is done.
     int pipepair (zmq::object_t *parents_ [2], zmq::pipe_t* pipes_ [2],
-        int hwms_ [2], bool delays_ [2]);
+        int hwms_ [2], int64_t hwm_bytes_ [2], bool delays_ [2],
+        int conflates_ [2]);
 
     struct i_pipe_events
     {
@@ -68,7 +78,8 @@ namespace zmq
     {
         //  This allows pipepair to create pipe objects.
         friend int pipepair (zmq::object_t *parents_ [2],
-            zmq::pipe_t* pipes_ [2], int hwms_ [2], bool delays_ [2]);
+            zmq::pipe_t* pipes_ [2], int hwms_ [2], int64_t hwm_bytes_ [2],
+            bool delays_ [2], int conflates_ [2]);
 
     public:
 
@@ -76,23 +87,75 @@ namespace zmq
         void set_event_sink (i_pipe_events *sink_);
 
         //  Pipe endpoint can store an opaque ID to be used by its clients.
-        void set_identity (const blob_t &identity_);
-        blob_t get_identity ();
+        //  The ID is stored inline and is at most 255 bytes long.
+        void set_identity (const unsigned char *data_, size_t size_);
+        const unsigned char *get_identity ();
+        size_t get_identity_size ();
+
+        //  Endpoint the pipe was connected to. Empty if the pipe was created
+        //  for a connection accepted on a bound endpoint.
+        void set_endpoint (const std::string &endpoint_);
+        const std::string &get_endpoint ();
+
+        //  Weight of the pipe used by fair queueing on the reader side.
+        void set_weight (int weight_);
+        int get_weight ();
+
+        //  Sets the maximal number of bytes to spool to disk once the
+        //  outbound pipe reaches the high watermark. Zero means that
+        //  the messages are not spooled. Ignored by conflating pipes.
+        //  Has to be called before the pipe is attached.
+        void set_swap (int64_t swap_);
+
+        //  Stamps outbound messages with the deadline of ttl_ milliseconds
+        //  from now. Zero means no deadline. The peer drops the messages
+        //  that expire before being read and counts them in expired_.
+        void set_ttl (int ttl_, atomic_counter_t *expired_);
 
         //  Returns true if there is at least one message to read in the pipe.
         bool check_read ();
 
-        //  Reads a message to the underlying pipe.
+        //  Reads a message to the underlying pipe. Urgent messages are read
+        //  before any other messages in the pipe.
         bool read (msg_t *msg_);
 
+        //  Reads up to count_ message parts from the pipe. Returns the number
+        //  of parts read. The writer is notified about the messages being
+        //  read once per batch.
+        size_t read (msg_t *msgs_, size_t count_);
+
         //  Checks whether messages can be written to the pipe. If writing
         //  the message would cause high watermark the function returns false.
+        //  Conflating pipe never reaches the high watermark.
         bool check_write (msg_t *msg_);
 
         //  Writes a message to the underlying pipe. Returns false if the
         //  message cannot be written because high watermark was reached.
+        //  In conflating mode the messages above the high watermark are
+        //  put aside instead, replacing any older message with the same
+        //  topic. With swap enabled, such messages are spooled to disk
+        //  instead. Either way, the reader takes them once it has read
+        //  all the messages from the pipe, without the writer's help.
+        //  Urgent messages are passed in a separate lane which the reader
+        //  drains first. They are never conflated or spooled.
         bool write (msg_t *msg_);
 
+        //  Writes up to count_ message parts to the pipe. Returns the number
+        //  of parts written.
+        size_t write (msg_t *msgs_, size_t count_);
+
+        //  Writes a single-part message generated by the socket itself
+        //  rather than by the user, such as a subscription replayed to
+        //  a new peer. The high watermarks and the memory budget don't
+        //  apply, so the write fails only if the pipe is shutting down or
+        //  if the user is in the middle of writing a message.
+        bool write_control (msg_t *msg_);
+
+        //  Returns the number of messages written to the pipe that the
+        //  reader haven't confirmed to have read yet. The reader confirms
+        //  reading in batches of LWM messages, so this is an upper bound.
+        uint64_t get_outstanding ();
+
         //  Remove unfinished parts of the outbound message from the pipe.
         void rollback ();
 
@@ -117,18 +180,78 @@ namespace zmq
 
         //  Command handlers.
         void process_activate_read ();
-        void process_activate_write (uint64_t msgs_read_);
+        void process_activate_write (uint64_t msgs_read_,
+            uint64_t bytes_read_, uint64_t urgent_msgs_read_);
         void process_hiccup (void *pipe_);
+        void process_urgent_lane (void *pipe_);
         void process_pipe_term ();
         void process_pipe_term_ack ();
 
         //  Handler for delimiter read from the pipe.
         void delimit ();
 
+        //  Returns true if the outbound pipe have reached high watermark.
+        bool is_full ();
+
+        //  Returns true if the outbound lane for urgent messages has used
+        //  up its allowance.
+        bool is_urgent_full ();
+
+        //  Lets the writer know how many messages and bytes were read.
+        void acknowledge ();
+
+        //  Accounts for a whole message being read.
+        void message_read (bool urgent_);
+
+        //  Returns true if the reader has read enough since the last
+        //  acknowledgement to let the writer know.
+        bool ack_due ();
+
+        //  Fills in the deadline stamp for the next outbound message.
+        void init_stamp (msg_t &msg_);
+
+        //  Writes the deadline stamp to the outbound lane.
+        void write_stamp (upipe_t *lane_);
+
+        //  Processes the deadline stamp read from the inbound lane. If
+        //  the message that follows has expired, it is dropped.
+        void expire (msg_t *stamp_, upipe_t *lane_);
+
+        //  Returns true if there's an urgent message to read. Expired
+        //  messages are dropped on the way.
+        bool check_urgent ();
+
+        //  Writes the message part to the pipe or puts it aside. Control
+        //  messages are put aside only to keep them in order with older
+        //  messages put aside already.
+        void write_part (msg_t *msg_, bool control_);
+
+        //  Memory the message part is accounted for in the memory budget.
+        static size_t footprint (msg_t &msg_);
+
+        //  Called when the inbound pipe is found empty. Fetches the next
+        //  message put aside by the writer, if any. Returns true if there
+        //  is a message to read, either fetched or written to the pipe
+        //  in the meantime. Sets delimited_ if the end of the message
+        //  stream was reached.
+        bool check_overflow (bool *delimited_);
+
+        //  Returns true if there are parts fetched from the overflow
+        //  left to read.
+        bool has_fetched ();
+
+        //  Drops the parts fetched from the overflow that weren't read.
+        void drop_fetched ();
+
+        //  Closes all the parts and clears the vector.
+        static void close_parts (overflow_t::parts_t &parts_);
+
         //  Constructor is private. Pipe can only be created using
         //  pipepair function.
         pipe_t (object_t *parent_, upipe_t *inpipe_, upipe_t *outpipe_,
-            int inhwm_, int outhwm_, bool delay_);
+            int inhwm_, int outhwm_, int64_t inhwm_bytes_,
+            int64_t outhwm_bytes_, bool delay_, int conflate_,
+            memory_budget_t *budget_);
 
         //  Pipepair uses this function to let us know about
         //  the peer pipe object.
@@ -141,6 +264,12 @@ namespace zmq
         upipe_t *inpipe;
         upipe_t *outpipe;
 
+        //  Lanes for urgent messages in both directions. Outbound lane is
+        //  created when the first urgent message is written. The reader
+        //  is responsible for deallocating it, same as with the pipes.
+        upipe_t *urgent_inpipe;
+        upipe_t *urgent_outpipe;
+
         //  Can the pipe be read from / written to?
         bool in_active;
         bool out_active;
@@ -159,9 +288,45 @@ namespace zmq
         //  can be higher at the moment.
         uint64_t peers_msgs_read;
 
+        //  High watermark for the outbound pipe and low watermark for
+        //  the inbound pipe in bytes. Zero means no limit.
+        uint64_t hwm_bytes;
+        uint64_t lwm_bytes;
+
+        //  Total size of the messages read and written so far. Size of
+        //  a message is accounted once the whole message is written.
+        uint64_t bytes_read;
+        uint64_t bytes_written;
+
+        //  Size of the parts of the message being written so far.
+        uint64_t bytes_more;
+
+        //  Values of msgs_read and bytes_read last sent to the peer.
+        uint64_t msgs_acked;
+        uint64_t bytes_acked;
+
+        //  If true, the messages are being read in a batch and the writer
+        //  will be notified at the end of it.
+        bool batch_reading;
+
+        //  Last received peer's bytes_read.
+        uint64_t peers_bytes_read;
+
+        //  Number of urgent messages read and written so far, the value
+        //  last sent to the peer and the last one received from it. Urgent
+        //  messages are accounted for in the counters above as well.
+        uint64_t urgent_msgs_read;
+        uint64_t urgent_msgs_written;
+        uint64_t urgent_msgs_acked;
+        uint64_t peers_urgent_msgs_read;
+
         //  The pipe object on the other side of the pipepair.
         pipe_t *peer;
 
+        //  Context-wide memory budget the messages are accounted to, NULL
+        //  if there's no memory limit. Shared by both ends of the pipe.
+        memory_budget_t *budget;
+
         //  Sink to send events to.
         i_pipe_events *sink;
 
@@ -188,12 +353,64 @@ namespace zmq
         //  asks us to.
         bool delay;
 
+        //  Number of messages the reader may read in a row from this pipe
+        //  when fair-queueing among multiple pipes.
+        int weight;
+
         //  Identity of the writer. Used uniquely by the reader side.
-        blob_t identity;
+        unsigned char identity_size;
+        unsigned char identity [255];
+
+        //  Endpoint the pipe was connected to.
+        std::string endpoint;
+
+        //  True if the outbound message being written is incomplete.
+        bool more_out;
+
+        //  True if the outbound message being written goes to the urgent
+        //  lane.
+        bool urgent_out;
+
+        //  True if the inbound message being read is incomplete and if it
+        //  comes from the urgent lane.
+        bool more_in;
+        bool urgent_in;
+
+        //  Messages that haven't fit into the pipes, NULL if they are
+        //  neither conflated nor spooled. Same as with the pipes, the reader
+        //  is responsible for deallocating the object.
+        overflow_t *inoverflow;
+        overflow_t *outoverflow;
+
+        //  True if the outbound message being written is being put aside
+        //  rather than written to the pipe. The parts are collected in
+        //  parts_out and passed to the overflow once the message is
+        //  complete, so that an incomplete message never replaces or
+        //  precedes a complete one.
+        bool overflowing;
+        overflow_t::parts_t parts_out;
+
+        //  Parts of the inbound message fetched from the overflow and
+        //  the position of the next one to read.
+        overflow_t::parts_t parts_in;
+        size_t parts_in_pos;
+
+        //  Time in milliseconds the outbound messages can wait before
+        //  being read. Zero means no limit.
+        int ttl;
+
+        //  Counter of the expired inbound messages, NULL if there's none.
+        atomic_counter_t *expired;
+
+        //  Source of the timestamps for the stamps.
+        clock_t clock;
 
         //  Returns true if the message is delimiter; false otherwise.
         static bool is_delimiter (msg_t &msg_);
 
+        //  Returns true if the message is deadline stamp; false otherwise.
+        static bool is_stamp (msg_t &msg_);
+
         //  Computes appropriate low watermark from the given high watermark.
         static int compute_lwm (int hwm_);
 
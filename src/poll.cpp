@@ -106,6 +106,12 @@ void zmq::poll_t::reset_pollout (handle_t handle_)
     pollset [index].events &= ~((short) POLLOUT);
 }
 
+bool zmq::poll_t::set_edge_triggered (handle_t handle_)
+{
+    //  Edge-triggered polling is not supported.
+    return false;
+}
+
 void zmq::poll_t::start ()
 {
     worker.start (worker_routine, this);
@@ -123,6 +129,9 @@ void zmq::poll_t::loop ()
         //  Execute any due timers.
         int timeout = (int) execute_timers ();
 
+        //  Deliver the commands batched by the event and timer handlers.
+        flush_commands ();
+
         //  Wait for events.
         int rc = poll (&pollset [0], pollset.size (), timeout ? timeout : -1);
         if (rc == -1 && errno == EINTR)
@@ -166,6 +175,8 @@ void zmq::poll_t::loop ()
             retired = false;
         }
     }
+
+    flush_commands ();
 }
 
 void zmq::poll_t::worker_routine (void *arg_)
@@ -58,6 +58,7 @@ namespace zmq
         void reset_pollin (handle_t handle_);
         void set_pollout (handle_t handle_);
         void reset_pollout (handle_t handle_);
+        bool set_edge_triggered (handle_t handle_);
         void start ();
         void stop ();
 
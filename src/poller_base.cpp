@@ -18,11 +18,15 @@
     along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <algorithm>
+
 #include "poller_base.hpp"
 #include "i_poll_events.hpp"
+#include "command_batch.hpp"
 #include "err.hpp"
 
-zmq::poller_base_t::poller_base_t ()
+zmq::poller_base_t::poller_base_t () :
+    batch (NULL)
 {
 }
 
@@ -97,3 +101,41 @@ uint64_t zmq::poller_base_t::execute_timers ()
     //  There are no more timers.
     return 0;
 }
+
+void zmq::poller_base_t::set_command_batch (command_batch_t *batch_)
+{
+    batch = batch_;
+}
+
+void zmq::poller_base_t::flush_commands ()
+{
+    if (batch)
+        batch->flush ();
+}
+
+void zmq::poller_base_t::schedule_update (void *entry_)
+{
+    updates.push_back (entry_);
+}
+
+void zmq::poller_base_t::cancel_update (void *entry_)
+{
+    //  Complexity of this operation is O(n). We assume the number of
+    //  updates scheduled at the same time is small.
+    updates_t::iterator it = std::find (updates.begin (), updates.end (),
+        entry_);
+    zmq_assert (it != updates.end ());
+    updates.erase (it);
+}
+
+void zmq::poller_base_t::apply_updates ()
+{
+    for (updates_t::size_type i = 0; i != updates.size (); i++)
+        apply_update (updates [i]);
+    updates.clear ();
+}
+
+void zmq::poller_base_t::apply_update (void *entry_)
+{
+    zmq_assert (false);
+}
@@ -22,6 +22,7 @@
 #define __ZMQ_POLLER_BASE_HPP_INCLUDED__
 
 #include <map>
+#include <vector>
 
 #include "clock.hpp"
 #include "atomic_counter.hpp"
@@ -30,6 +31,7 @@ namespace zmq
 {
 
     struct i_poll_events;
+    class command_batch_t;
 
     class poller_base_t
     {
@@ -50,6 +52,10 @@ namespace zmq
         //  Cancel the timer created by sink_ object with ID equal to id_.
         void cancel_timer (zmq::i_poll_events *sink_, int id_);
 
+        //  Sets the batch of commands to be delivered before the poller
+        //  starts waiting for events.
+        void set_command_batch (zmq::command_batch_t *batch_);
+
     protected:
 
         //  Called by individual poller implementations to manage the load.
@@ -59,6 +65,28 @@ namespace zmq
         //  to wait to match the next timer or 0 meaning "no timers".
         uint64_t execute_timers ();
 
+        //  Delivers the batched commands, if any.
+        void flush_commands ();
+
+        //  Schedules update of the events polled for on the fd identified
+        //  by entry_. Instead of updating the pollset each time an fd's
+        //  interest changes, the individual poller implementations record
+        //  the change and schedule the update, which is applied by
+        //  apply_updates. Each entry is to be scheduled once at most.
+        void schedule_update (void *entry_);
+
+        //  Drops the scheduled update of the entry, e.g. because its fd
+        //  was removed from the poller.
+        void cancel_update (void *entry_);
+
+        //  Applies the scheduled updates. Called by individual poller
+        //  implementations before waiting for events.
+        void apply_updates ();
+
+        //  Updates the pollset to match the events the owner of the entry
+        //  is interested in. Pollers scheduling updates must implement it.
+        virtual void apply_update (void *entry_);
+
     private:
 
         //  Clock instance private to this I/O thread.
@@ -77,6 +105,14 @@ namespace zmq
         //  registered.
         atomic_counter_t load;
 
+        //  Commands sent from the I/O thread, NULL if commands are not
+        //  batched.
+        command_batch_t *batch;
+
+        //  Entries whose pollset update was scheduled but not applied yet.
+        typedef std::vector <void*> updates_t;
+        updates_t updates;
+
         poller_base_t (const poller_base_t&);
         const poller_base_t &operator = (const poller_base_t&);
     };
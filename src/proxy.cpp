@@ -0,0 +1,287 @@
+/*
+    Copyright (c) 2009-2011 250bpm s.r.o.
+    Copyright (c) 2007-2011 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "proxy.hpp"
+#include "io_thread.hpp"
+#include "socket_base.hpp"
+#include "options.hpp"
+#include "likely.hpp"
+#include "err.hpp"
+
+zmq::proxy_t::proxy_t (io_thread_t *io_thread_, socket_base_t *frontend_,
+      socket_base_t *backend_, socket_base_t *capture_) :
+    own_t (io_thread_, options_t ()),
+    poller (io_thread_->get_poller ()),
+    terminated (false)
+{
+    sockets [frontend] = frontend_;
+    sockets [backend] = backend_;
+    sockets [capture] = capture_;
+
+    for (int i = 0; i != socket_count; i++) {
+        handlers [i].proxy = this;
+        handlers [i].index = i;
+    }
+
+    for (int i = 0; i != 2; i++) {
+        int rc = pending [i].init ();
+        errno_assert (rc == 0);
+        has_pending [i] = false;
+        msgs [i] = 0;
+        bytes [i] = 0;
+    }
+}
+
+zmq::proxy_t::~proxy_t ()
+{
+    zmq_assert (terminated);
+    for (int i = 0; i != 2; i++) {
+        int rc = pending [i].close ();
+        errno_assert (rc == 0);
+    }
+}
+
+void zmq::proxy_t::start ()
+{
+    send_plug (this);
+}
+
+void zmq::proxy_t::stop ()
+{
+    //  If the proxy was already shut down because of context termination,
+    //  the I/O thread may not exist any more. Otherwise ask the I/O thread
+    //  to shut the proxy down. The command is sent while holding the lock
+    //  so that it is guaranteed to be processed before the I/O thread exits.
+    sync.lock ();
+    bool running = !terminated;
+    if (running)
+        send_stop ();
+    sync.unlock ();
+    if (!running)
+        return;
+
+    //  Wait till the sockets are released.
+    while (true) {
+        int rc = done.wait (-1);
+        if (rc == 0)
+            break;
+        errno_assert (errno == EINTR);
+    }
+    done.recv ();
+}
+
+int zmq::proxy_t::getstat (int stat_, void *value_, size_t *valuelen_)
+{
+    if (*valuelen_ < sizeof (uint64_t)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    sync.lock ();
+    uint64_t value = 0;
+    switch (stat_) {
+    case ZMQ_PROXY_FRONTEND_MSGS:
+        value = msgs [frontend];
+        break;
+    case ZMQ_PROXY_FRONTEND_BYTES:
+        value = bytes [frontend];
+        break;
+    case ZMQ_PROXY_BACKEND_MSGS:
+        value = msgs [backend];
+        break;
+    case ZMQ_PROXY_BACKEND_BYTES:
+        value = bytes [backend];
+        break;
+    default:
+        sync.unlock ();
+        errno = EINVAL;
+        return -1;
+    }
+    sync.unlock ();
+
+    *((uint64_t*) value_) = value;
+    *valuelen_ = sizeof (uint64_t);
+    return 0;
+}
+
+void zmq::proxy_t::process_plug ()
+{
+    //  From now on, the sockets are accessed exclusively from this thread.
+    for (int i = 0; i != socket_count; i++) {
+        if (!sockets [i])
+            continue;
+        handles [i] = poller->add_fd (
+            sockets [i]->get_mailbox ()->get_fd (), &handlers [i]);
+        poller->set_pollin (handles [i]);
+    }
+
+    //  Messages may have been queued before the proxy was started.
+    if (forward (frontend, backend) != 0 || forward (backend, frontend) != 0)
+        shutdown ();
+}
+
+void zmq::proxy_t::process_stop ()
+{
+    shutdown ();
+    done.send ();
+}
+
+void zmq::proxy_t::socket_event (int index_)
+{
+    if (terminated)
+        return;
+
+    //  Process commands such as pipe activations. The context termination
+    //  is reported as an error here.
+    if (sockets [index_]->process_commands (0, false) != 0) {
+        if (errno == ETERM) {
+            shutdown ();
+            return;
+        }
+        errno_assert (errno == EINTR);
+    }
+
+    if (forward (frontend, backend) != 0 || forward (backend, frontend) != 0)
+        shutdown ();
+}
+
+int zmq::proxy_t::forward (int from_, int to_)
+{
+    socket_base_t *from = sockets [from_];
+    socket_base_t *to = sockets [to_];
+    socket_base_t *cap = sockets [capture];
+    msg_t &msg = pending [from_];
+    uint64_t nmsgs = 0;
+    uint64_t nbytes = 0;
+    int rc;
+
+    while (true) {
+
+        //  Get the next message part, unless there's one left over from
+        //  the last time the destination was full.
+        if (!has_pending [from_]) {
+            rc = from->recv (&msg, ZMQ_DONTWAIT);
+            if (rc != 0) {
+                if (errno == ETERM)
+                    return -1;
+                break;
+            }
+            has_pending [from_] = true;
+
+            //  Pass the copy of the message part to the capture socket. If it
+            //  is not able to accept it, the copy is dropped.
+            if (cap) {
+                msg_t copy;
+                rc = copy.init ();
+                errno_assert (rc == 0);
+                rc = copy.copy (msg);
+                errno_assert (rc == 0);
+                rc = cap->send (&copy, ZMQ_DONTWAIT |
+                    (msg.flags () & msg_t::more ? ZMQ_SNDMORE : 0));
+                if (unlikely (rc != 0)) {
+                    int err = errno;
+                    rc = copy.close ();
+                    errno_assert (rc == 0);
+                    if (err == ETERM)
+                        return -1;
+                }
+            }
+        }
+        bool more = msg.flags () & msg_t::more ? true : false;
+        size_t size = msg.size ();
+
+        //  Move the message part to the destination. The content is not
+        //  copied, only the message structure is.
+        rc = to->send (&msg, ZMQ_DONTWAIT | (more ? ZMQ_SNDMORE : 0) |
+            (msg.flags () & msg_t::urgent ? ZMQ_URGENT : 0));
+        if (rc != 0) {
+            if (errno == ETERM)
+                return -1;
+
+            //  Keep the message till the destination becomes writable.
+            //  Activation of the destination will wake the proxy up.
+            if (errno == EAGAIN)
+                break;
+
+            //  The destination doesn't accept the message at all
+            //  (e.g. wrong socket state). Drop it.
+            rc = msg.close ();
+            errno_assert (rc == 0);
+            rc = msg.init ();
+            errno_assert (rc == 0);
+            has_pending [from_] = false;
+            continue;
+        }
+        has_pending [from_] = false;
+        nmsgs++;
+        nbytes += size;
+    }
+
+    if (nmsgs) {
+        sync.lock ();
+        msgs [from_] += nmsgs;
+        bytes [from_] += nbytes;
+        sync.unlock ();
+    }
+    return 0;
+}
+
+void zmq::proxy_t::shutdown ()
+{
+    sync.lock ();
+    if (terminated) {
+        sync.unlock ();
+        return;
+    }
+
+    //  Release the sockets. Same as with zmq_close, the rest of the socket
+    //  shutdown is done by the reaper thread.
+    for (int i = 0; i != socket_count; i++) {
+        if (!sockets [i])
+            continue;
+        poller->rm_fd (handles [i]);
+        int rc = sockets [i]->close ();
+        errno_assert (rc == 0);
+    }
+    for (int i = 0; i != 2; i++) {
+        int rc = pending [i].close ();
+        errno_assert (rc == 0);
+        rc = pending [i].init ();
+        errno_assert (rc == 0);
+        has_pending [i] = false;
+    }
+    terminated = true;
+    sync.unlock ();
+}
+
+void zmq::proxy_t::handler_t::in_event ()
+{
+    proxy->socket_event (index);
+}
+
+void zmq::proxy_t::handler_t::out_event ()
+{
+    zmq_assert (false);
+}
+
+void zmq::proxy_t::handler_t::timer_event (int id_)
+{
+    zmq_assert (false);
+}
@@ -0,0 +1,131 @@
+/*
+    Copyright (c) 2009-2011 250bpm s.r.o.
+    Copyright (c) 2007-2011 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __ZMQ_PROXY_HPP_INCLUDED__
+#define __ZMQ_PROXY_HPP_INCLUDED__
+
+#include <stddef.h>
+
+#include "own.hpp"
+#include "poller.hpp"
+#include "i_poll_events.hpp"
+#include "signaler.hpp"
+#include "mutex.hpp"
+#include "stdint.hpp"
+#include "msg.hpp"
+
+namespace zmq
+{
+
+    class io_thread_t;
+    class socket_base_t;
+
+    //  Proxy shuffles messages between frontend and backend socket within
+    //  an I/O thread. Once started, the proxy owns the sockets: it polls
+    //  their mailboxes in the I/O thread and moves the messages from one
+    //  socket to the other without involving any application thread.
+    //  Optionally, copy of each message part is sent to the capture socket.
+
+    class proxy_t : public own_t
+    {
+    public:
+
+        proxy_t (zmq::io_thread_t *io_thread_, zmq::socket_base_t *frontend_,
+            zmq::socket_base_t *backend_, zmq::socket_base_t *capture_);
+        ~proxy_t ();
+
+        //  Hands the sockets over to the I/O thread. Called from the
+        //  application thread.
+        void start ();
+
+        //  Stops the proxy and closes the sockets. Blocks until the I/O
+        //  thread releases the sockets. Called from the application thread.
+        void stop ();
+
+        //  Retrieves the statistics. May be called from any thread.
+        int getstat (int stat_, void *value_, size_t *valuelen_);
+
+    private:
+
+        enum {frontend = 0, backend = 1, capture = 2, socket_count = 3};
+
+        //  Dispatches poller events from particular socket's mailbox
+        //  to the proxy.
+        class handler_t : public i_poll_events
+        {
+        public:
+
+            void in_event ();
+            void out_event ();
+            void timer_event (int id_);
+
+            proxy_t *proxy;
+            int index;
+        };
+
+        //  Handlers for incoming commands.
+        void process_plug ();
+        void process_stop ();
+
+        //  Invoked when there are commands pending for the socket.
+        void socket_event (int index_);
+
+        //  Moves all the available messages from one socket to the other.
+        //  Returns -1 if the context was terminated.
+        int forward (int from_, int to_);
+
+        //  Unregisters the sockets from the poller and closes them.
+        void shutdown ();
+
+        socket_base_t *sockets [socket_count];
+        handler_t handlers [socket_count];
+        poller_t::handle_t handles [socket_count];
+
+        //  Poller of the I/O thread the proxy runs in.
+        poller_t *poller;
+
+        //  Message that could not be passed to the destination socket
+        //  because of the high watermark, one for each direction.
+        msg_t pending [2];
+        bool has_pending [2];
+
+        //  Statistics, i.e. number of message parts and bytes passed
+        //  from the frontend and from the backend socket.
+        uint64_t msgs [2];
+        uint64_t bytes [2];
+
+        //  If true, the proxy was already shut down, either by the user
+        //  or because the context was terminated.
+        bool terminated;
+
+        //  Synchronises access to statistics and the terminated flag.
+        mutex_t sync;
+
+        //  Signals application thread waiting in stop that the sockets
+        //  were released.
+        signaler_t done;
+
+        proxy_t (const proxy_t&);
+        const proxy_t &operator = (const proxy_t&);
+    };
+
+}
+
+#endif
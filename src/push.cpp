@@ -50,6 +50,22 @@ void zmq::push_t::xterminated (pipe_t *pipe_)
     lb.terminated (pipe_);
 }
 
+int zmq::push_t::xsetsockopt (int option_, const void *optval_,
+    size_t optvallen_)
+{
+    if (option_ != ZMQ_LB_STRATEGY && option_ != ZMQ_LB_KEY_SIZE) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    //  Let the generic option parser check the value, then pass it on
+    //  to the load balancer.
+    int rc = options.setsockopt (option_, optval_, optvallen_);
+    if (rc == 0)
+        lb.set_strategy (options.lb_strategy, options.lb_key_size);
+    return rc;
+}
+
 int zmq::push_t::xsend (msg_t *msg_, int flags_)
 {
     return lb.send (msg_, flags_);
@@ -179,3 +179,11 @@ int zmq::req_session_t::write (msg_t *msg_)
     return -1;
 }
 
+size_t zmq::req_session_t::write_batch (msg_t *msgs_, size_t count_)
+{
+    //  Each message has to be checked against the state machine.
+    size_t n = 0;
+    while (n != count_ && write (&msgs_ [n]) == 0)
+        n++;
+    return n;
+}
@@ -136,6 +136,12 @@ void zmq::select_t::reset_pollout (handle_t handle_)
     FD_CLR (handle_, &source_set_out);
 }
 
+bool zmq::select_t::set_edge_triggered (handle_t handle_)
+{
+    //  Edge-triggered polling is not supported.
+    return false;
+}
+
 void zmq::select_t::start ()
 {
     worker.start (worker_routine, this);
@@ -153,6 +159,9 @@ void zmq::select_t::loop ()
         //  Execute any due timers.
         int timeout = (int) execute_timers ();
 
+        //  Deliver the commands batched by the event and timer handlers.
+        flush_commands ();
+
         //  Intialise the pollsets.
         memcpy (&readfds, &source_set_in, sizeof source_set_in);
         memcpy (&writefds, &source_set_out, sizeof source_set_out);
@@ -200,6 +209,8 @@ void zmq::select_t::loop ()
             retired = false;
         }
     }
+
+    flush_commands ();
 }
 
 void zmq::select_t::worker_routine (void *arg_)
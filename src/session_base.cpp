@@ -30,6 +30,8 @@
 #include "ipc_connecter.hpp"
 #include "pgm_sender.hpp"
 #include "pgm_receiver.hpp"
+#include "udp_sender.hpp"
+#include "udp_receiver.hpp"
 
 #include "req.hpp"
 #include "xreq.hpp"
@@ -185,12 +187,49 @@ int zmq::session_base_t::write (msg_t *msg_)
     return -1;
 }
 
+size_t zmq::session_base_t::read_batch (msg_t *msgs_, size_t count_)
+{
+    //  Identity is passed on its own.
+    if (send_identity)
+        return read (msgs_) == 0 ? 1 : 0;
+
+    size_t n = pipe ? pipe->read (msgs_, count_) : 0;
+    if (n)
+        incomplete_in = msgs_ [n - 1].flags () & msg_t::more ? true : false;
+    if (n < count_)
+        errno = EAGAIN;
+    return n;
+}
+
+size_t zmq::session_base_t::write_batch (msg_t *msgs_, size_t count_)
+{
+    //  First message to receive is identity (if required).
+    if (recv_identity && count_) {
+        msgs_ [0].set_flags (msg_t::identity);
+        recv_identity = false;
+    }
+
+    size_t n = pipe ? pipe->write (msgs_, count_) : 0;
+    for (size_t i = 0; i != n; i++) {
+        int rc = msgs_ [i].init ();
+        errno_assert (rc == 0);
+    }
+    if (n < count_)
+        errno = EAGAIN;
+    return n;
+}
+
 void zmq::session_base_t::flush ()
 {
     if (pipe)
         pipe->flush ();
 }
 
+zmq::socket_base_t *zmq::session_base_t::get_socket ()
+{
+    return socket;
+}
+
 void zmq::session_base_t::clean_pipes ()
 {
     if (pipe) {
@@ -274,10 +313,22 @@ void zmq::session_base_t::process_attach (i_engine *engine_)
         object_t *parents [2] = {this, socket};
         pipe_t *pipes [2] = {NULL, NULL};
         int hwms [2] = {options.rcvhwm, options.sndhwm};
+        int64_t hwm_bytes [2] = {options.rcvhwm_bytes, options.sndhwm_bytes};
         bool delays [2] = {options.delay_on_close, options.delay_on_disconnect};
-        int rc = pipepair (parents, pipes, hwms, delays);
+        bool pub = options.type == ZMQ_PUB || options.type == ZMQ_XPUB;
+        int conflates [2] = {pub ? -1 : options.conflate,
+            pub ? options.conflate : -1};
+        int rc = pipepair (parents, pipes, hwms, hwm_bytes, delays,
+            conflates);
         errno_assert (rc == 0);
 
+        //  Inbound messages are fair-queued by the socket according to the
+        //  weight in effect when the connection was bound or connected.
+        pipes [1]->set_weight (options.fq_weight);
+        pipes [1]->set_swap (options.swap);
+        pipes [0]->set_ttl (options.ttl, socket->get_expired ());
+        pipes [1]->set_ttl (options.ttl, socket->get_expired ());
+
         //  Plug the local end of the pipe.
         pipes [0]->set_event_sink (this);
 
@@ -402,15 +453,49 @@ void zmq::session_base_t::start_connecting (bool wait_)
     }
 
 #if !defined ZMQ_HAVE_WINDOWS && !defined ZMQ_HAVE_OPENVMS
-    if (protocol == "ipc") {
+    if (protocol == "ipc" || protocol == "shm") {
         ipc_connecter_t *connecter = new (std::nothrow) ipc_connecter_t (
-            io_thread, this, options, address.c_str (), wait_);
+            io_thread, this, options, address.c_str (), wait_,
+            protocol == "shm");
         alloc_assert (connecter);
         launch_child (connecter);
         return;
     }
 #endif
 
+#if defined ZMQ_HAVE_LINUX
+    if (protocol == "udp") {
+
+        //  Same as with PGM, there's no concept of 'connect' with UDP.
+        //  If the socket can't be set up, e.g. because the port is in use,
+        //  no messages are passed.
+        i_engine *engine = NULL;
+        int rc = -1;
+        if (options.type == ZMQ_PUB || options.type == ZMQ_XPUB) {
+            udp_sender_t *udp_sender = new (std::nothrow) udp_sender_t (
+                io_thread, options);
+            alloc_assert (udp_sender);
+            rc = udp_sender->init (address.c_str ());
+            engine = udp_sender;
+        }
+        else if (options.type == ZMQ_SUB || options.type == ZMQ_XSUB) {
+            udp_receiver_t *udp_receiver = new (std::nothrow) udp_receiver_t (
+                io_thread, options);
+            alloc_assert (udp_receiver);
+            rc = udp_receiver->init (address.c_str ());
+            engine = udp_receiver;
+        }
+        else
+            zmq_assert (false);
+
+        if (rc == 0)
+            send_attach (this, engine);
+        else
+            delete engine;
+        return;
+    }
+#endif
+
 #if defined ZMQ_HAVE_OPENPGM
 
     //  Both PGM and EPGM transports are using the same infrastructure.
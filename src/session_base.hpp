@@ -57,6 +57,16 @@ namespace zmq
         virtual int read (msg_t *msg_);
         virtual int write (msg_t *msg_);
         void flush ();
+
+        //  Returns the socket the session belongs to.
+        zmq::socket_base_t *get_socket ();
+
+        //  Batch variants of read and write. They pass up to count_ messages
+        //  and return the number of messages actually passed. If it is less
+        //  than count_, errno is set the same way as by read and write.
+        //  Sessions that override read or write have to override these too.
+        virtual size_t read_batch (msg_t *msgs_, size_t count_);
+        virtual size_t write_batch (msg_t *msgs_, size_t count_);
         void detach ();
 
         //  i_pipe_events interface implementation.
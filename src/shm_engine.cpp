@@ -0,0 +1,493 @@
+/*
+    Copyright (c) 2009-2011 250bpm s.r.o.
+    Copyright (c) 2007-2011 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "shm_engine.hpp"
+
+#if defined ZMQ_HAVE_LINUX
+
+#include <new>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+
+#include "io_thread.hpp"
+#include "session_base.hpp"
+#include "ctx.hpp"
+#include "config.hpp"
+#include "likely.hpp"
+#include "err.hpp"
+#include "ip.hpp"
+
+#ifndef MFD_CLOEXEC
+#define MFD_CLOEXEC 0x0001U
+#endif
+#ifndef MFD_ALLOW_SEALING
+#define MFD_ALLOW_SEALING 0x0002U
+#endif
+#ifndef F_ADD_SEALS
+#define F_ADD_SEALS 1033
+#define F_GET_SEALS 1034
+#define F_SEAL_SEAL 0x0001
+#define F_SEAL_SHRINK 0x0002
+#define F_SEAL_GROW 0x0004
+#endif
+
+//  Seals the shared memory has to carry. Mapping memory that the peer could
+//  shrink would make the accesses beyond the new end of the file fault.
+static const int shm_seals = F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL;
+
+zmq::shm_engine_t::shm_engine_t (fd_t fd_, const options_t &options_,
+      bool connecting_) :
+    s (fd_),
+    connecting (connecting_),
+    memory (NULL),
+    memory_size (0),
+    input_stopped (false),
+    decoder (in_batch_size, options_.maxmsgsize),
+    encoder (out_batch_size),
+    session (NULL),
+    leftover_session (NULL),
+    options (options_),
+    budget (NULL),
+    plugged (false)
+{
+    //  Get the socket into non-blocking mode.
+    unblock_socket (s);
+}
+
+zmq::shm_engine_t::~shm_engine_t ()
+{
+    zmq_assert (!plugged);
+
+    if (memory) {
+        int rc = munmap (memory, memory_size);
+        errno_assert (rc == 0);
+    }
+
+    int rc = close (s);
+    errno_assert (rc == 0);
+}
+
+void zmq::shm_engine_t::plug (io_thread_t *io_thread_,
+    session_base_t *session_)
+{
+    zmq_assert (!plugged);
+    plugged = true;
+    leftover_session = NULL;
+
+    //  Connect to session object.
+    zmq_assert (!session);
+    zmq_assert (session_);
+    encoder.set_session (session_);
+    decoder.set_session (session_);
+    session = session_;
+
+    //  The shared memory is accounted once it is mapped.
+    budget = io_thread_->get_ctx ()->get_memory_budget ();
+
+    //  Connect to I/O threads poller object. The socket is polled for
+    //  input only; the data it carries are the wake-ups from the peer.
+    io_object_t::plug (io_thread_);
+    handle = add_fd (s);
+    set_pollin (handle);
+
+    //  The connecting side creates the shared memory right away. When
+    //  reconnected, the shared memory is created anew.
+    if (connecting && !memory && send_memory () != 0) {
+        error ();
+        return;
+    }
+
+    //  Process the messages the peer may have already sent.
+    in_event ();
+}
+
+void zmq::shm_engine_t::unplug ()
+{
+    zmq_assert (plugged);
+    plugged = false;
+
+    //  Cancel all fd subscriptions.
+    rm_fd (handle);
+
+    //  Disconnect from I/O threads poller object.
+    io_object_t::unplug ();
+
+    if (budget) {
+        if (memory)
+            budget->release (memory_size);
+        budget = NULL;
+    }
+
+    //  Disconnect from session object.
+    encoder.set_session (NULL);
+    decoder.set_session (NULL);
+    leftover_session = session;
+    session = NULL;
+}
+
+void zmq::shm_engine_t::terminate ()
+{
+    unplug ();
+    delete this;
+}
+
+void zmq::shm_engine_t::in_event ()
+{
+    //  The accepting side can't do anything till it gets the shared memory.
+    if (unlikely (!memory)) {
+        int rc = recv_memory ();
+        if (rc != 0) {
+            if (errno != EAGAIN)
+                error ();
+            return;
+        }
+    }
+
+    //  Drop the wake-ups. Reading from the socket is also the way to find
+    //  out that the peer has disconnected.
+    bool disconnection = false;
+    unsigned char buf [64];
+    while (true) {
+        ssize_t nbytes = recv (s, buf, sizeof (buf), 0);
+        if (nbytes == -1) {
+            if (errno == ECONNRESET) {
+                disconnection = true;
+                break;
+            }
+            errno_assert (errno == EAGAIN || errno == EWOULDBLOCK ||
+                errno == EINTR);
+            break;
+        }
+        if (nbytes == 0) {
+            disconnection = true;
+            break;
+        }
+        if (nbytes < (ssize_t) sizeof (buf))
+            break;
+    }
+
+    //  The wake-up may concern either of the rings.
+    if (read_ring () != 0)
+        disconnection = true;
+    if (plugged && !disconnection && write_ring () != 0)
+        disconnection = true;
+
+    if (session && disconnection)
+        error ();
+}
+
+void zmq::shm_engine_t::activate_in ()
+{
+    input_stopped = false;
+    if (read_ring () != 0)
+        error ();
+}
+
+void zmq::shm_engine_t::activate_out ()
+{
+    if (write_ring () != 0)
+        error ();
+}
+
+int zmq::shm_engine_t::read_ring ()
+{
+    if (unlikely (!memory))
+        return 0;
+
+    int result = 0;
+    while (!input_stopped) {
+
+        //  Get the data from the ring.
+        unsigned char *data;
+        size_t size;
+        if (in.read_buffer (&data, &size) != 0) {
+            result = -1;
+            break;
+        }
+
+        //  If there are no data, pass on the messages the session didn't
+        //  accept last time and go to sleep. If the peer has written some
+        //  data in the meantime, go on.
+        if (!size) {
+            if (decoder.stuck ()) {
+                if (decoder.process_buffer (data, 0) == (size_t) -1) {
+                    result = -1;
+                    break;
+                }
+                if (decoder.stuck ()) {
+                    input_stopped = true;
+                    break;
+                }
+            }
+            if (in.reader_sleep ())
+                break;
+            continue;
+        }
+
+        //  Decode the data right from the shared memory.
+        size_t processed = decoder.process_buffer (data, size);
+        if (unlikely (processed == (size_t) -1)) {
+            result = -1;
+            break;
+        }
+
+        //  Free the space in the ring. If the peer waits for it, wake it up.
+        if (processed && in.consume (processed))
+            wake_peer ();
+
+        //  Stop reading if we got stuck. This may happen if queue limits
+        //  are in effect. The session will activate the engine later on.
+        if (processed < size || decoder.stuck ())
+            input_stopped = true;
+
+        if (unlikely (!plugged))
+            break;
+    }
+
+    //  Flush all messages the decoder may have produced.
+    //  If IO handler has unplugged engine, flush transient IO handler.
+    if (unlikely (!plugged)) {
+        zmq_assert (leftover_session);
+        leftover_session->flush ();
+    } else {
+        session->flush ();
+    }
+
+    return result;
+}
+
+int zmq::shm_engine_t::write_ring ()
+{
+    if (unlikely (!memory))
+        return 0;
+
+    while (true) {
+
+        //  Get the free space in the ring. If there's none, go to sleep.
+        //  If the peer has freed some space in the meantime, go on.
+        unsigned char *space;
+        size_t size;
+        if (out.write_buffer (&space, &size) != 0)
+            return -1;
+        if (!size) {
+            if (out.writer_sleep ())
+                return 0;
+            continue;
+        }
+
+        //  Encode the messages right into the shared memory.
+        unsigned char *data = space;
+        size_t nbytes = size;
+        encoder.get_data (&data, &nbytes);
+        zmq_assert (data == space);
+
+        //  If IO handler has unplugged engine, flush transient IO handler.
+        if (unlikely (!plugged)) {
+            zmq_assert (leftover_session);
+            leftover_session->flush ();
+            return 0;
+        }
+
+        //  Pass the data to the peer. If the peer is asleep, wake it up.
+        if (nbytes && out.commit (nbytes))
+            wake_peer ();
+
+        //  If the encoder ran out of messages, the session will activate
+        //  the engine once there are new ones.
+        if (nbytes < size)
+            return 0;
+    }
+}
+
+int zmq::shm_engine_t::send_memory ()
+{
+    size_t size = 2 * shm_ring_t::footprint (shm_ring_size);
+
+    //  Create an anonymous file to hold the shared memory and seal its size.
+    //  Without memfd, there's no way to seal the memory, so the transport
+    //  is not available.
+#if defined SYS_memfd_create
+    fd_t fd = syscall (SYS_memfd_create, "zmq-shm",
+        MFD_CLOEXEC | MFD_ALLOW_SEALING);
+#else
+    fd_t fd = retired_fd;
+    errno = ENOSYS;
+#endif
+    if (fd == retired_fd) {
+        errno_assert (errno == ENOSYS || errno == EINVAL ||
+            errno == EMFILE || errno == ENFILE || errno == ENOMEM);
+        return -1;
+    }
+    int rc = ftruncate (fd, size);
+    errno_assert (rc == 0);
+    rc = fcntl (fd, F_ADD_SEALS, shm_seals);
+    errno_assert (rc == 0);
+    rc = map_memory (fd, size);
+    errno_assert (rc == 0);
+
+    //  Pass the file descriptor to the peer along with a single byte.
+    unsigned char byte = 0;
+    struct iovec iov = {&byte, 1};
+    union {
+        struct cmsghdr align;
+        unsigned char buf [CMSG_SPACE (sizeof (int))];
+    } control;
+    struct msghdr msg;
+    memset (&msg, 0, sizeof (msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof (control.buf);
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR (&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN (sizeof (int));
+    memcpy (CMSG_DATA (cmsg), &fd, sizeof (int));
+    ssize_t nbytes;
+    do {
+        nbytes = sendmsg (s, &msg, MSG_NOSIGNAL);
+    } while (nbytes == -1 && errno == EINTR);
+
+    //  If the peer is gone already, the disconnection is detected when
+    //  reading from the socket.
+    if (nbytes == -1)
+        errno_assert (errno == EPIPE || errno == ECONNRESET);
+
+    rc = close (fd);
+    errno_assert (rc == 0);
+    return 0;
+}
+
+int zmq::shm_engine_t::recv_memory ()
+{
+    unsigned char byte;
+    struct iovec iov = {&byte, 1};
+    union {
+        struct cmsghdr align;
+        unsigned char buf [CMSG_SPACE (sizeof (int))];
+    } control;
+    struct msghdr msg;
+    memset (&msg, 0, sizeof (msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof (control.buf);
+    ssize_t nbytes = recvmsg (s, &msg, MSG_CMSG_CLOEXEC);
+    if (nbytes == -1) {
+        if (errno == EWOULDBLOCK || errno == EINTR)
+            errno = EAGAIN;
+        return -1;
+    }
+
+    //  Peer has closed the connection.
+    if (nbytes == 0) {
+        errno = ECONNRESET;
+        return -1;
+    }
+
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR (&msg);
+    if (!cmsg || cmsg->cmsg_level != SOL_SOCKET ||
+          cmsg->cmsg_type != SCM_RIGHTS ||
+          cmsg->cmsg_len != CMSG_LEN (sizeof (int))) {
+        errno = EPROTO;
+        return -1;
+    }
+    fd_t fd;
+    memcpy (&fd, CMSG_DATA (cmsg), sizeof (int));
+
+    //  Check that the memory is large enough to hold two rings of
+    //  the size this side expects and that the peer can't change the size
+    //  afterwards.
+    struct stat st;
+    int rc = fstat (fd, &st);
+    errno_assert (rc == 0);
+    int seals = fcntl (fd, F_GET_SEALS);
+    if (st.st_size != (off_t) (2 * shm_ring_t::footprint (shm_ring_size)) ||
+          seals == -1 || (seals & shm_seals) != shm_seals) {
+        rc = close (fd);
+        errno_assert (rc == 0);
+        errno = EPROTO;
+        return -1;
+    }
+
+    rc = map_memory (fd, st.st_size);
+    int err = errno;
+    int rc2 = close (fd);
+    errno_assert (rc2 == 0);
+    errno = err;
+    return rc;
+}
+
+int zmq::shm_engine_t::map_memory (fd_t fd_, size_t size_)
+{
+    void *addr = mmap (NULL, size_, PROT_READ | PROT_WRITE, MAP_SHARED,
+        fd_, 0);
+    if (addr == MAP_FAILED)
+        return -1;
+    memory = addr;
+    memory_size = size_;
+
+    //  The first ring carries the data from the connecting side to
+    //  the accepting side, the second one the other way round.
+    void *second = (unsigned char*) memory + memory_size / 2;
+    if (connecting) {
+        out.attach (memory, shm_ring_size);
+        in.attach (second, shm_ring_size);
+    }
+    else {
+        in.attach (memory, shm_ring_size);
+        out.attach (second, shm_ring_size);
+    }
+
+    if (budget)
+        budget->charge (memory_size);
+    return 0;
+}
+
+void zmq::shm_engine_t::wake_peer ()
+{
+    unsigned char byte = 0;
+    ssize_t nbytes;
+    do {
+        nbytes = send (s, &byte, 1, MSG_NOSIGNAL);
+    } while (nbytes == -1 && errno == EINTR);
+
+    //  If the socket is full, the peer has wake-ups pending anyway. If it
+    //  is gone, the disconnection is detected when reading from the socket.
+    if (nbytes == -1)
+        errno_assert (errno == EAGAIN || errno == EWOULDBLOCK ||
+            errno == EPIPE || errno == ECONNRESET);
+}
+
+void zmq::shm_engine_t::error ()
+{
+    zmq_assert (session);
+    session->detach ();
+    unplug ();
+    delete this;
+}
+
+#endif
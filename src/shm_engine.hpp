@@ -0,0 +1,146 @@
+/*
+    Copyright (c) 2009-2011 250bpm s.r.o.
+    Copyright (c) 2007-2011 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __ZMQ_SHM_ENGINE_HPP_INCLUDED__
+#define __ZMQ_SHM_ENGINE_HPP_INCLUDED__
+
+#include "platform.hpp"
+
+#if defined ZMQ_HAVE_LINUX
+
+#include <stddef.h>
+
+#include "fd.hpp"
+#include "i_engine.hpp"
+#include "io_object.hpp"
+#include "encoder.hpp"
+#include "decoder.hpp"
+#include "options.hpp"
+#include "memory_budget.hpp"
+#include "shm_ring.hpp"
+
+namespace zmq
+{
+
+    class io_thread_t;
+    class session_base_t;
+
+    //  This engine handles shm:// connections. The peers are connected by
+    //  a UNIX domain socket, which is used to pass the shared memory from
+    //  the connecting to the accepting side and to wake the peer up later
+    //  on. The messages are passed through a pair of ring buffers in the
+    //  shared memory; the encoder writes the frames directly into the ring
+    //  and the decoder reads them directly from it.
+
+    class shm_engine_t : public io_object_t, public i_engine
+    {
+    public:
+
+        //  If connecting_ is true, the engine creates the shared memory
+        //  and passes it to the peer. Otherwise it waits for the peer to
+        //  pass it.
+        shm_engine_t (fd_t fd_, const options_t &options_, bool connecting_);
+        ~shm_engine_t ();
+
+        //  i_engine interface implementation.
+        void plug (zmq::io_thread_t *io_thread_,
+           zmq::session_base_t *session_);
+        void unplug ();
+        void terminate ();
+        void activate_in ();
+        void activate_out ();
+
+        //  i_poll_events interface implementation.
+        void in_event ();
+
+    private:
+
+        //  Creates the shared memory and passes it to the peer. The size of
+        //  the memory is sealed so that neither peer can change it while
+        //  the other one has it mapped. Returns -1 if the sealed memory
+        //  can't be created.
+        int send_memory ();
+
+        //  Receives the shared memory from the peer. Returns -1 with errno
+        //  set to EAGAIN if it was not received yet. Memory with the size
+        //  that is not sealed is rejected.
+        int recv_memory ();
+
+        //  Maps the shared memory and attaches the rings to it.
+        int map_memory (fd_t fd_, size_t size_);
+
+        //  Passes decoded messages from the inbound ring to the session.
+        //  Returns -1 if the connection has to be dropped.
+        int read_ring ();
+
+        //  Writes encoded messages to the outbound ring. Returns -1 if the
+        //  connection has to be dropped.
+        int write_ring ();
+
+        //  Wakes the peer up.
+        void wake_peer ();
+
+        //  Function to handle network disconnections.
+        void error ();
+
+        //  Underlying socket.
+        fd_t s;
+
+        handle_t handle;
+
+        //  True if this side creates the shared memory.
+        bool connecting;
+
+        //  The shared memory.
+        void *memory;
+        size_t memory_size;
+
+        shm_ring_t in;
+        shm_ring_t out;
+
+        //  True if the session doesn't accept more messages.
+        bool input_stopped;
+
+        decoder_t decoder;
+        encoder_t encoder;
+
+        //  The session this engine is attached to.
+        zmq::session_base_t *session;
+
+        //  Detached transient session.
+        zmq::session_base_t *leftover_session;
+
+        options_t options;
+
+        //  Memory budget the shared memory is accounted to while the engine
+        //  is plugged. NULL if there's no memory limit.
+        memory_budget_t *budget;
+
+        bool plugged;
+
+        shm_engine_t (const shm_engine_t&);
+        const shm_engine_t &operator = (const shm_engine_t&);
+    };
+
+}
+
+#endif
+
+#endif
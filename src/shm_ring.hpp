@@ -0,0 +1,191 @@
+/*
+    Copyright (c) 2009-2011 250bpm s.r.o.
+    Copyright (c) 2007-2011 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __ZMQ_SHM_RING_HPP_INCLUDED__
+#define __ZMQ_SHM_RING_HPP_INCLUDED__
+
+#include "platform.hpp"
+
+#if defined ZMQ_HAVE_LINUX
+
+#include <stddef.h>
+
+#include "stdint.hpp"
+#include "config.hpp"
+
+namespace zmq
+{
+
+    //  Single-producer, single-consumer ring buffer of bytes living in
+    //  memory shared by two processes. Same as with ypipe_t, the writer and
+    //  the reader never block each other. When the reader finds the ring
+    //  empty or the writer finds it full, it marks itself as asleep and the
+    //  other party is told so when it moves the ring on. The actual wake-up
+    //  is left to the user of the ring.
+    //
+    //  The content of the shared memory may be modified by the peer at any
+    //  time, thus the positions read from it are validated and the capacity
+    //  is kept privately.
+
+    class shm_ring_t
+    {
+    public:
+
+        inline shm_ring_t () :
+            header (NULL),
+            data (NULL),
+            capacity (0)
+        {
+        }
+
+        //  Returns the amount of shared memory needed by a ring with data
+        //  area of capacity_ bytes.
+        static inline size_t footprint (uint32_t capacity_)
+        {
+            return sizeof (header_t) + capacity_;
+        }
+
+        //  Uses the memory at base_ as the ring. Memory filled with zeroes
+        //  is an empty ring.
+        inline void attach (void *base_, uint32_t capacity_)
+        {
+            header = (header_t*) base_;
+            data = (unsigned char*) base_ + sizeof (header_t);
+            capacity = capacity_;
+        }
+
+        inline bool attached ()
+        {
+            return header != NULL;
+        }
+
+        //  Returns the contiguous free space in the ring. Returns -1 if the
+        //  peer has corrupted the ring.
+        inline int write_buffer (unsigned char **data_, size_t *size_)
+        {
+            uint32_t w = header->write_pos;
+            uint32_t used = w - header->read_pos;
+            if (used > capacity)
+                return -1;
+
+            //  The space must not be overwritten before the position is read.
+            __sync_synchronize ();
+            uint32_t offset = w & (capacity - 1);
+            *data_ = data + offset;
+            *size_ = capacity - (used > offset ? used : offset);
+            return 0;
+        }
+
+        //  Passes size_ bytes written to the buffer returned by
+        //  write_buffer to the reader. Returns true if the reader is asleep
+        //  and has to be woken up.
+        inline bool commit (size_t size_)
+        {
+            //  The data must be visible before the new position is, and
+            //  the position must be visible before the flag is checked.
+            __sync_synchronize ();
+            header->write_pos += (uint32_t) size_;
+            __sync_synchronize ();
+            return header->reader_asleep &&
+                __sync_bool_compare_and_swap (&header->reader_asleep, 1, 0);
+        }
+
+        //  Called by the writer when the ring is full. Returns false if
+        //  there's free space in the ring meanwhile, so that the writer
+        //  can go on instead of waiting to be woken up.
+        inline bool writer_sleep ()
+        {
+            header->writer_asleep = 1;
+            __sync_synchronize ();
+            if (header->write_pos - header->read_pos >= capacity)
+                return true;
+            __sync_bool_compare_and_swap (&header->writer_asleep, 1, 0);
+            return false;
+        }
+
+        //  Returns the contiguous data available in the ring. Returns -1 if
+        //  the peer has corrupted the ring.
+        inline int read_buffer (unsigned char **data_, size_t *size_)
+        {
+            uint32_t r = header->read_pos;
+            uint32_t used = header->write_pos - r;
+            if (used > capacity)
+                return -1;
+
+            //  The data must not be read before the position is.
+            __sync_synchronize ();
+            uint32_t offset = r & (capacity - 1);
+            *data_ = data + offset;
+            *size_ = used < capacity - offset ? used : capacity - offset;
+            return 0;
+        }
+
+        //  Releases size_ bytes returned by read_buffer to the writer.
+        //  Returns true if the writer is asleep and has to be woken up.
+        inline bool consume (size_t size_)
+        {
+            __sync_synchronize ();
+            header->read_pos += (uint32_t) size_;
+            __sync_synchronize ();
+            return header->writer_asleep &&
+                __sync_bool_compare_and_swap (&header->writer_asleep, 1, 0);
+        }
+
+        //  Called by the reader when the ring is empty. Returns false if
+        //  there are data in the ring meanwhile.
+        inline bool reader_sleep ()
+        {
+            header->reader_asleep = 1;
+            __sync_synchronize ();
+            if (header->write_pos == header->read_pos)
+                return true;
+            __sync_bool_compare_and_swap (&header->reader_asleep, 1, 0);
+            return false;
+        }
+
+    private:
+
+        //  The part of the ring shared with the peer. The positions grow
+        //  forever, wrapping around at 2^32. Each position is kept on its
+        //  own cache line, together with the flag its owner checks after
+        //  moving it. The flags change rarely.
+        struct header_t
+        {
+            volatile uint32_t write_pos;
+            volatile uint32_t reader_asleep;
+            unsigned char pad1 [cache_line_size - 2 * sizeof (uint32_t)];
+            volatile uint32_t read_pos;
+            volatile uint32_t writer_asleep;
+            unsigned char pad2 [cache_line_size - 2 * sizeof (uint32_t)];
+        };
+
+        header_t *header;
+        unsigned char *data;
+        uint32_t capacity;
+
+        shm_ring_t (const shm_ring_t&);
+        const shm_ring_t &operator = (const shm_ring_t&);
+    };
+
+}
+
+#endif
+
+#endif
@@ -39,6 +39,7 @@
 #include "tcp_listener.hpp"
 #include "ipc_listener.hpp"
 #include "tcp_connecter.hpp"
+#include "udp_address.hpp"
 #include "io_thread.hpp"
 #include "session_base.hpp"
 #include "config.hpp"
@@ -122,6 +123,8 @@ zmq::socket_base_t::socket_base_t (ctx_t *parent_, uint32_t tid_) :
     last_tsc (0),
     ticks (0),
     rcvmore (false),
+    compression_raw (0),
+    compression_wire (0),
     thread_safe_flag (false)
 {
 }
@@ -139,6 +142,19 @@ zmq::mailbox_t *zmq::socket_base_t::get_mailbox ()
     return &mailbox;
 }
 
+zmq::atomic_counter_t *zmq::socket_base_t::get_expired ()
+{
+    return &expired;
+}
+
+void zmq::socket_base_t::add_compressed (size_t raw_, size_t wire_)
+{
+    compression_sync.lock ();
+    compression_raw += raw_;
+    compression_wire += wire_;
+    compression_sync.unlock ();
+}
+
 void zmq::socket_base_t::stop ()
 {
     //  Called by ctx when it is terminated (zmq_term).
@@ -173,7 +189,8 @@ int zmq::socket_base_t::check_protocol (const std::string &protocol_)
 {
     //  First check out whether the protcol is something we are aware of.
     if (protocol_ != "inproc" && protocol_ != "ipc" && protocol_ != "tcp" &&
-          protocol_ != "pgm" && protocol_ != "epgm" && protocol_ != "sys") {
+          protocol_ != "pgm" && protocol_ != "epgm" && protocol_ != "sys" &&
+          protocol_ != "shm" && protocol_ != "udp") {
         errno = EPROTONOSUPPORT;
         return -1;
     }
@@ -196,10 +213,18 @@ int zmq::socket_base_t::check_protocol (const std::string &protocol_)
     }
 #endif
 
+    //  Shared memory and UDP transports are available on Linux only.
+#if !defined ZMQ_HAVE_LINUX
+    if (protocol_ == "shm" || protocol_ == "udp") {
+        errno = EPROTONOSUPPORT;
+        return -1;
+    }
+#endif
+
     //  Check whether socket type and transport protocol match.
     //  Specifically, multicast protocols can't be combined with
     //  bi-directional messaging patterns (socket types).
-    if ((protocol_ == "pgm" || protocol_ == "epgm") &&
+    if ((protocol_ == "pgm" || protocol_ == "epgm" || protocol_ == "udp") &&
           options.type != ZMQ_PUB && options.type != ZMQ_SUB &&
           options.type != ZMQ_XPUB && options.type != ZMQ_XSUB) {
         errno = ENOCOMPATPROTO;
@@ -291,6 +316,30 @@ int zmq::socket_base_t::getsockopt (int option_, void *optval_,
         return 0;
     }
 
+    if (option_ == ZMQ_EXPIRED) {
+        if (*optvallen_ < sizeof (uint64_t)) {
+            errno = EINVAL;
+            return -1;
+        }
+        *((uint64_t*) optval_) = expired.get ();
+        *optvallen_ = sizeof (uint64_t);
+        return 0;
+    }
+
+    if (option_ == ZMQ_COMPRESSION_RAW_BYTES ||
+          option_ == ZMQ_COMPRESSION_WIRE_BYTES) {
+        if (*optvallen_ < sizeof (uint64_t)) {
+            errno = EINVAL;
+            return -1;
+        }
+        compression_sync.lock ();
+        *((uint64_t*) optval_) = option_ == ZMQ_COMPRESSION_RAW_BYTES ?
+            compression_raw : compression_wire;
+        compression_sync.unlock ();
+        *optvallen_ = sizeof (uint64_t);
+        return 0;
+    }
+
     return options.getsockopt (option_, optval_, optvallen_);
 }
 
@@ -317,10 +366,10 @@ int zmq::socket_base_t::bind (const char *addr_)
         return register_endpoint (addr_, endpoint);
     }
 
-    if (protocol == "pgm" || protocol == "epgm") {
+    if (protocol == "pgm" || protocol == "epgm" || protocol == "udp") {
 
         //  For convenience's sake, bind can be used interchageable with
-        //  connect for PGM and EPGM transports.
+        //  connect for PGM, EPGM and UDP transports.
         return connect (addr_); 
     }
 
@@ -348,9 +397,9 @@ int zmq::socket_base_t::bind (const char *addr_)
     }
 
 #if !defined ZMQ_HAVE_WINDOWS && !defined ZMQ_HAVE_OPENVMS
-    if (protocol == "ipc") {
+    if (protocol == "ipc" || protocol == "shm") {
         ipc_listener_t *listener = new (std::nothrow) ipc_listener_t (
-            io_thread, this, options);
+            io_thread, this, options, protocol == "shm");
         alloc_assert (listener);
         int rc = listener->set_address (address.c_str ());
         if (rc != 0) {
@@ -409,15 +458,45 @@ int zmq::socket_base_t::connect (const char *addr_)
             rcvhwm = 0;
         else
             rcvhwm = options.rcvhwm + peer.options.sndhwm;
+        int64_t sndhwm_bytes;
+        int64_t rcvhwm_bytes;
+        if (options.sndhwm_bytes == 0 || peer.options.rcvhwm_bytes == 0)
+            sndhwm_bytes = 0;
+        else
+            sndhwm_bytes = options.sndhwm_bytes + peer.options.rcvhwm_bytes;
+        if (options.rcvhwm_bytes == 0 || peer.options.sndhwm_bytes == 0)
+            rcvhwm_bytes = 0;
+        else
+            rcvhwm_bytes = options.rcvhwm_bytes + peer.options.sndhwm_bytes;
+
+        //  Messages are conflated on their way from publisher to subscriber.
+        //  Either of the peers may ask for conflation.
+        int conflate = std::max (options.conflate, peer.options.conflate);
+        bool pub = options.type == ZMQ_PUB || options.type == ZMQ_XPUB;
 
         //  Create a bi-directional pipe to connect the peers.
         object_t *parents [2] = {this, peer.socket};
         pipe_t *pipes [2] = {NULL, NULL};
         int hwms [2] = {sndhwm, rcvhwm};
+        int64_t hwm_bytes [2] = {sndhwm_bytes, rcvhwm_bytes};
         bool delays [2] = {options.delay_on_disconnect, options.delay_on_close};
-        int rc = pipepair (parents, pipes, hwms, delays);
+        int conflates [2] = {pub ? conflate : -1, pub ? -1 : conflate};
+        int rc = pipepair (parents, pipes, hwms, hwm_bytes, delays,
+            conflates);
         errno_assert (rc == 0);
 
+        //  Each peer fair-queues inbound messages using its own weight.
+        pipes [0]->set_weight (options.fq_weight);
+        pipes [1]->set_weight (peer.options.fq_weight);
+        pipes [0]->set_swap (options.swap);
+        pipes [1]->set_swap (peer.options.swap);
+
+        //  Messages are stamped according to the TTL of the sending socket
+        //  and accounted to it when they expire.
+        pipes [0]->set_ttl (options.ttl, &expired);
+        pipes [1]->set_ttl (peer.options.ttl, peer.socket->get_expired ());
+        pipes [0]->set_endpoint (addr_);
+
         //  Attach local end of the pipe to this socket object.
         attach_pipe (pipes [0]);
 
@@ -428,7 +507,7 @@ int zmq::socket_base_t::connect (const char *addr_)
             zmq_assert (rc == 0);
             memcpy (id.data (), options.identity, options.identity_size);
             id.set_flags (msg_t::identity);
-            bool written = pipes [0]->write (&id);
+            bool written = pipes [0]->write_control (&id);
             zmq_assert (written);
         }
 
@@ -440,6 +519,19 @@ int zmq::socket_base_t::connect (const char *addr_)
         return 0;
     }
 
+#if defined ZMQ_HAVE_LINUX
+    //  The UDP socket is created once the session is started, so check
+    //  the address beforehand for the errors to be reported.
+    if (protocol == "udp") {
+        udp_address_t udp_address;
+        rc = udp_address.resolve (address.c_str (),
+            options.type == ZMQ_SUB || options.type == ZMQ_XSUB,
+            options.ipv4only ? true : false);
+        if (rc != 0)
+            return -1;
+    }
+#endif
+
     //  Choose the I/O thread to run the session in.
     io_thread_t *io_thread = choose_io_thread (options.affinity);
     if (!io_thread) {
@@ -456,14 +548,23 @@ int zmq::socket_base_t::connect (const char *addr_)
     object_t *parents [2] = {this, session};
     pipe_t *pipes [2] = {NULL, NULL};
     int hwms [2] = {options.sndhwm, options.rcvhwm};
+    int64_t hwm_bytes [2] = {options.sndhwm_bytes, options.rcvhwm_bytes};
     bool delays [2] = {options.delay_on_disconnect, options.delay_on_close};
-    rc = pipepair (parents, pipes, hwms, delays);
+    bool pub = options.type == ZMQ_PUB || options.type == ZMQ_XPUB;
+    int conflates [2] = {pub ? options.conflate : -1,
+        pub ? -1 : options.conflate};
+    rc = pipepair (parents, pipes, hwms, hwm_bytes, delays, conflates);
     errno_assert (rc == 0);
-
-    //  PGM does not support subscription forwarding; ask for all data to be
-    //  sent to this pipe.
+    pipes [0]->set_weight (options.fq_weight);
+    pipes [0]->set_swap (options.swap);
+    pipes [0]->set_ttl (options.ttl, &expired);
+    pipes [1]->set_ttl (options.ttl, &expired);
+    pipes [0]->set_endpoint (addr_);
+
+    //  PGM and UDP do not support subscription forwarding; ask for all data
+    //  to be sent to this pipe.
     bool icanhasall = false;
-    if (protocol == "pgm" || protocol == "epgm")
+    if (protocol == "pgm" || protocol == "epgm" || protocol == "udp")
         icanhasall = true;
 
     //  Attach local end of the pipe to the socket object.
@@ -498,11 +599,13 @@ int zmq::socket_base_t::send (msg_t *msg_, int flags_)
         return -1;
 
     //  Clear any user-visible flags that are set on the message.
-    msg_->reset_flags (msg_t::more);
+    msg_->reset_flags (msg_t::more | msg_t::urgent);
 
     //  At this point we impose the flags on the message.
     if (flags_ & ZMQ_SNDMORE)
         msg_->set_flags (msg_t::more);
+    if (flags_ & ZMQ_URGENT)
+        msg_->set_flags (msg_t::urgent);
 
     //  Try to send the message.
     rc = xsend (msg_, flags_);
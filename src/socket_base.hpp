@@ -49,6 +49,7 @@ namespace zmq
         public i_pipe_events
     {
         friend class reaper_t;
+        friend class proxy_t;
 
     public:
 
@@ -62,6 +63,14 @@ namespace zmq
         //  Returns the mailbox associated with this socket.
         mailbox_t *get_mailbox ();
 
+        //  Returns the counter of messages dropped because of ZMQ_TTL.
+        //  The counter is updated by the pipes from any thread.
+        atomic_counter_t *get_expired ();
+
+        //  Accounts the data sent compressed by the socket's engines.
+        //  This function can be called from a different thread!
+        void add_compressed (size_t raw_, size_t wire_);
+
         //  Interrupt blocking call if the socket is stuck in one.
         //  This function can be called from a different thread!
         void stop ();
@@ -196,6 +205,15 @@ namespace zmq
         //  True if the last message received had MORE flag set.
         bool rcvmore;
 
+        //  Number of messages dropped because they exceeded ZMQ_TTL.
+        atomic_counter_t expired;
+
+        //  Amount of data the socket's engines compressed and the amount
+        //  of data actually sent over the network in their stead.
+        mutex_t compression_sync;
+        uint64_t compression_raw;
+        uint64_t compression_wire;
+
         socket_base_t (const socket_base_t&);
         const socket_base_t &operator = (const socket_base_t&);
         bool thread_safe_flag;
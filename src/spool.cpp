@@ -0,0 +1,318 @@
+/*
+    Copyright (c) 2009-2011 250bpm s.r.o.
+    Copyright (c) 2007-2011 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "spool.hpp"
+#include "platform.hpp"
+#include "err.hpp"
+
+#if defined ZMQ_HAVE_WINDOWS
+
+//  Spooling to disk is not supported on Windows. The pipe acts as if the
+//  spool was full.
+
+zmq::spool_t::spool_t () :
+    fd (-1)
+{
+}
+
+zmq::spool_t::~spool_t ()
+{
+}
+
+int zmq::spool_t::init ()
+{
+    errno = ENOTSUP;
+    return -1;
+}
+
+bool zmq::spool_t::write (msg_t &msg_, bool more_)
+{
+    zmq_assert (false);
+    return false;
+}
+
+bool zmq::spool_t::read (msg_t *msg_)
+{
+    return false;
+}
+
+bool zmq::spool_t::empty ()
+{
+    return true;
+}
+
+bool zmq::spool_t::has_msg ()
+{
+    return false;
+}
+
+uint64_t zmq::spool_t::size ()
+{
+    return 0;
+}
+
+bool zmq::spool_t::write_back_due ()
+{
+    return false;
+}
+
+void zmq::spool_t::write_back ()
+{
+}
+
+#else
+
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "msg.hpp"
+#include "wire.hpp"
+#include "config.hpp"
+
+//  Each message part is stored as 8-byte size, 1 byte of flags (more and
+//  stamp) and the data.
+static const size_t header_size = 9;
+
+zmq::spool_t::spool_t () :
+    fd (-1),
+    file_size (0),
+    read_pos (0),
+    write_pos (0),
+    commit_pos (0),
+    unsynced (0),
+    write_back_pending (false)
+{
+    write_window.data = NULL;
+    write_window.offset = 0;
+    read_window.data = NULL;
+    read_window.offset = 0;
+}
+
+zmq::spool_t::~spool_t ()
+{
+    unmap (write_window);
+    unmap (read_window);
+    if (fd != -1) {
+        int rc = close (fd);
+        errno_assert (rc == 0);
+    }
+}
+
+int zmq::spool_t::init ()
+{
+    const char *dir = getenv ("TMPDIR");
+    std::string path (dir && *dir ? dir : "/tmp");
+    path += "/zmq-spool-XXXXXX";
+
+    fd = mkstemp (&path [0]);
+    if (fd == -1)
+        return -1;
+
+    //  The file is not accessible by name. It vanishes once closed.
+    int rc = unlink (path.c_str ());
+    errno_assert (rc == 0);
+    return 0;
+}
+
+bool zmq::spool_t::write (msg_t &msg_, bool more_)
+{
+    unsigned char header [header_size];
+    put_uint64 (header, msg_.size ());
+    header [8] = (more_ ? msg_t::more : 0) | (msg_.flags () & msg_t::stamp);
+    if (!copy_out (write_pos, header, header_size) ||
+          !copy_out (write_pos + header_size, msg_.data (), msg_.size ())) {
+        write_pos = commit_pos;
+        return false;
+    }
+    write_pos += header_size + msg_.size ();
+    if (!more_)
+        commit_pos = write_pos;
+    return true;
+}
+
+bool zmq::spool_t::read (msg_t *msg_)
+{
+    if (!has_msg ())
+        return false;
+
+    unsigned char header [header_size];
+    copy_in (read_pos, header, header_size);
+    size_t size = (size_t) get_uint64 (header);
+    int rc = msg_->init_size (size);
+    errno_assert (rc == 0);
+    copy_in (read_pos + header_size, msg_->data (), size);
+    msg_->set_flags (header [8]);
+    read_pos += header_size + size;
+
+    //  If the spool is drained, start from the beginning of the file
+    //  again and release the disk space.
+    if (read_pos == write_pos) {
+        unmap (write_window);
+        unmap (read_window);
+        rc = ftruncate (fd, 0);
+        errno_assert (rc == 0);
+        file_size = 0;
+        read_pos = 0;
+        write_pos = 0;
+        commit_pos = 0;
+    }
+
+    return true;
+}
+
+bool zmq::spool_t::empty ()
+{
+    return read_pos == write_pos;
+}
+
+bool zmq::spool_t::has_msg ()
+{
+    return read_pos < commit_pos;
+}
+
+uint64_t zmq::spool_t::size ()
+{
+    return write_pos - read_pos;
+}
+
+bool zmq::spool_t::write_back_due ()
+{
+    bool result = write_back_pending;
+    write_back_pending = false;
+    return result;
+}
+
+void zmq::spool_t::write_back ()
+{
+#if defined ZMQ_HAVE_LINUX
+    int rc = fdatasync (fd);
+#else
+    int rc = fsync (fd);
+#endif
+    errno_assert (rc == 0);
+}
+
+bool zmq::spool_t::copy_out (uint64_t pos_, const void *data_, size_t size_)
+{
+    const unsigned char *data = (const unsigned char*) data_;
+    while (size_) {
+        if (!map (write_window, pos_))
+            return false;
+        size_t offset = (size_t) (pos_ - write_window.offset);
+        size_t size = spool_chunk_size - offset;
+        if (size > size_)
+            size = size_;
+        memcpy (write_window.data + offset, data, size);
+        data += size;
+        pos_ += size;
+        size_ -= size;
+    }
+    return true;
+}
+
+void zmq::spool_t::copy_in (uint64_t pos_, void *data_, size_t size_)
+{
+    unsigned char *data = (unsigned char*) data_;
+    while (size_) {
+        bool ok = map (read_window, pos_);
+        errno_assert (ok);
+        size_t offset = (size_t) (pos_ - read_window.offset);
+        size_t size = spool_chunk_size - offset;
+        if (size > size_)
+            size = size_;
+        memcpy (data, read_window.data + offset, size);
+        data += size;
+        pos_ += size;
+        size_ -= size;
+    }
+}
+
+bool zmq::spool_t::map (window_t &window_, uint64_t pos_)
+{
+    uint64_t offset = pos_ - pos_ % spool_chunk_size;
+    if (window_.data && window_.offset == offset)
+        return true;
+    unmap (window_);
+
+    //  Grow the file as needed. The disk space is reserved up front. Were
+    //  the file sparse, writing to the mapping on a full disk would kill
+    //  the process with SIGBUS.
+    if (file_size < offset + spool_chunk_size) {
+#if defined ZMQ_HAVE_OSX
+        //  There's no posix_fallocate on OS X. Write the chunk instead.
+        static const unsigned char zeros [4096] = {0};
+        for (uint64_t pos = file_size; pos != offset + spool_chunk_size;
+              pos += sizeof zeros) {
+            ssize_t nbytes = pwrite (fd, zeros, sizeof zeros, (off_t) pos);
+            if (nbytes != (ssize_t) sizeof zeros) {
+                if (nbytes != -1)
+                    errno = ENOSPC;
+                return false;
+            }
+        }
+#else
+        int rc = posix_fallocate (fd, (off_t) file_size,
+            (off_t) (offset + spool_chunk_size - file_size));
+        if (rc != 0) {
+            errno = rc;
+            return false;
+        }
+#endif
+        file_size = offset + spool_chunk_size;
+    }
+
+    void *data = mmap (NULL, spool_chunk_size, PROT_READ | PROT_WRITE,
+        MAP_SHARED, fd, (off_t) offset);
+    if (data == MAP_FAILED)
+        return false;
+    window_.data = (unsigned char*) data;
+    window_.offset = offset;
+    return true;
+}
+
+void zmq::spool_t::unmap (window_t &window_)
+{
+    if (!window_.data)
+        return;
+
+    //  Start writing the chunk to the disk without waiting for it to
+    //  complete. Chunks are thus written in large sequential batches.
+    //  Once in a while, ask the writer to wait for the write-back to
+    //  finish so that the dirty pages don't accumulate faster than
+    //  the disk can take. The waiting itself is left to the caller, who
+    //  can do it without blocking the other side of the spool.
+    if (&window_ == &write_window) {
+        int rc = msync (window_.data, spool_chunk_size, MS_ASYNC);
+        errno_assert (rc == 0);
+        if (++unsynced == spool_sync_chunks) {
+            write_back_pending = true;
+            unsynced = 0;
+        }
+    }
+    int rc = munmap (window_.data, spool_chunk_size);
+    errno_assert (rc == 0);
+    window_.data = NULL;
+}
+
+#endif
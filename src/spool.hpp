@@ -0,0 +1,128 @@
+/*
+    Copyright (c) 2009-2011 250bpm s.r.o.
+    Copyright (c) 2007-2011 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __ZMQ_SPOOL_HPP_INCLUDED__
+#define __ZMQ_SPOOL_HPP_INCLUDED__
+
+#include <stddef.h>
+
+#include "stdint.hpp"
+
+namespace zmq
+{
+
+    class msg_t;
+
+    //  Queue of message parts stored in a temporary file. Parts are appended
+    //  at the end of the file and read from its beginning; both ends access
+    //  the file via a memory-mapped window of spool_chunk_size bytes, so
+    //  the I/O is purely sequential. Disk space for a chunk is reserved
+    //  before it's mapped, so a full disk makes the write fail rather than
+    //  fault on access to the mapping. Dirty chunks are handed over to the
+    //  OS for write-back as soon as the writer leaves them. Once every
+    //  spool_sync_chunks chunks the writer is asked to wait for the
+    //  write-back to finish, so that the spool doesn't pile up dirty pages
+    //  in memory. It's a matter of flow control, not durability; the file
+    //  is unlinked and doesn't survive the process. Once the spool is
+    //  drained, the file is truncated.
+
+    class spool_t
+    {
+    public:
+
+        spool_t ();
+        ~spool_t ();
+
+        //  Creates the backing file. Returns -1 and sets errno on failure.
+        int init ();
+
+        //  Appends the message part to the spool. The part itself is left
+        //  intact. Returns false if there's no disk space left, in which
+        //  case the incomplete message written so far is dropped.
+        bool write (msg_t &msg_, bool more_);
+
+        //  Reads next part from the spool. Returns false if there's no
+        //  complete message to read.
+        bool read (msg_t *msg_);
+
+        //  Returns true if there are no message parts in the spool.
+        bool empty ();
+
+        //  Returns true if there is a part of a complete message to read.
+        bool has_msg ();
+
+        //  Number of bytes stored in the spool.
+        uint64_t size ();
+
+        //  Returns true if the writer should wait for the write-back of
+        //  the spooled data by calling write_back. The flag is reset.
+        bool write_back_due ();
+
+        //  Waits for the data written so far to get to the disk. Unlike
+        //  the other functions it can be called while the spool is being
+        //  accessed by another thread.
+        void write_back ();
+
+    private:
+
+        //  Memory-mapped part of the file.
+        struct window_t
+        {
+            unsigned char *data;
+            uint64_t offset;
+        };
+
+        //  Copies data from/to the file, moving the window as needed.
+        //  Writing fails if the disk space can't be reserved.
+        bool copy_out (uint64_t pos_, const void *data_, size_t size_);
+        void copy_in (uint64_t pos_, void *data_, size_t size_);
+
+        //  Makes the window cover the chunk containing the position,
+        //  growing the file if needed. Returns false and sets errno if
+        //  the disk space can't be reserved or the chunk can't be mapped.
+        bool map (window_t &window_, uint64_t pos_);
+        void unmap (window_t &window_);
+
+        //  Backing file.
+        int fd;
+        uint64_t file_size;
+
+        window_t write_window;
+        window_t read_window;
+
+        //  Position of the next part to read and to write.
+        uint64_t read_pos;
+        uint64_t write_pos;
+
+        //  End of the last complete message.
+        uint64_t commit_pos;
+
+        //  Number of chunks written since the writer was last asked to
+        //  wait for the write-back.
+        int unsynced;
+        bool write_back_pending;
+
+        spool_t (const spool_t&);
+        const spool_t &operator = (const spool_t&);
+    };
+
+}
+
+#endif
@@ -37,7 +37,9 @@
 
 #include "stream_engine.hpp"
 #include "io_thread.hpp"
+#include "ctx.hpp"
 #include "session_base.hpp"
+#include "socket_base.hpp"
 #include "config.hpp"
 #include "err.hpp"
 #include "ip.hpp"
@@ -53,8 +55,20 @@ zmq::stream_engine_t::stream_engine_t (fd_t fd_, const options_t &options_) :
     session (NULL),
     leftover_session (NULL),
     options (options_),
-    plugged (false)
+    budget (NULL),
+    plugged (false),
+    edge_triggered (false),
+    input_stopped (false),
+    compressor (NULL),
+    decompressor (NULL),
+    detecting (true),
+    socket (NULL)
 {
+    if (options.compression != ZMQ_COMPRESSION_NONE) {
+        compressor = new (std::nothrow) compressor_t (options.compression);
+        alloc_assert (compressor);
+    }
+
     //  Get the socket into non-blocking mode.
     unblock_socket (s);
 
@@ -101,6 +115,9 @@ zmq::stream_engine_t::~stream_engine_t ()
 #endif
 		s = retired_fd;
     }
+
+    delete compressor;
+    delete decompressor;
 }
 
 void zmq::stream_engine_t::plug (io_thread_t *io_thread_,
@@ -116,12 +133,22 @@ void zmq::stream_engine_t::plug (io_thread_t *io_thread_,
     encoder.set_session (session_);
     decoder.set_session (session_);
     session = session_;
+    socket = session_->get_socket ();
+
+    //  Account the I/O buffers.
+    budget = io_thread_->get_ctx ()->get_memory_budget ();
+    if (budget)
+        budget->charge (buffer_size ());
 
     //  Connect to I/O threads poller object.
     io_object_t::plug (io_thread_);
     handle = add_fd (s);
-    set_pollin (handle);
-    set_pollout (handle);
+    edge_triggered = set_edge_triggered (handle);
+    input_stopped = false;
+    if (!edge_triggered) {
+        set_pollin (handle);
+        set_pollout (handle);
+    }
 
     //  Flush all the data that may have been already received downstream.
     in_event ();
@@ -138,11 +165,17 @@ void zmq::stream_engine_t::unplug ()
     //  Disconnect from I/O threads poller object.
     io_object_t::unplug ();
 
+    if (budget) {
+        budget->release (buffer_size ());
+        budget = NULL;
+    }
+
     //  Disconnect from session object.
     encoder.set_session (NULL);
     decoder.set_session (NULL);
     leftover_session = session;
     session = NULL;
+    socket = NULL;
 }
 
 void zmq::stream_engine_t::terminate ()
@@ -153,44 +186,102 @@ void zmq::stream_engine_t::terminate ()
 
 void zmq::stream_engine_t::in_event ()
 {
-    bool disconnection = false;
+    //  In edge-triggered mode the data are left in the socket while the
+    //  input is stopped. They are read once the input is activated again.
+    if (edge_triggered && input_stopped)
+        return;
 
-    //  If there's no data to process in the buffer...
-    if (!insize) {
+    bool disconnection = false;
 
-        //  Retrieve the buffer and read as much data as possible.
-        //  Note that buffer can be arbitrarily large. However, we assume
-        //  the underlying TCP layer has fixed buffer size and thus the
-        //  number of bytes read will be always limited.
-        decoder.get_buffer (&inpos, &insize);
-        insize = read (inpos, insize);
+    while (true) {
 
-        //  Check whether the peer has closed the connection.
-        if (insize == (size_t) -1) {
-            insize = 0;
-            disconnection = true;
-        }
-    }
+        //  Whether there's no more data in the socket at the moment.
+        bool drained = false;
 
-    //  Push the data to the decoder.
-    size_t processed = decoder.process_buffer (inpos, insize);
+        //  Whether the session doesn't accept more messages.
+        bool stopped = false;
 
-    if (unlikely (processed == (size_t) -1)) {
-        disconnection = true;
-    }
-    else {
+        //  If there's no data to process in the buffer... Messages decoded
+        //  already but not accepted by the session are passed on first.
+        //  Reading further might hit the end of the stream and drop them.
+        if (!insize && decoder.stuck ())
+            ;
+        else if (!insize && decompressor) {
+            if (read_compressed (&drained) != 0)
+                disconnection = true;
+        }
+        else if (!insize) {
+
+            //  Retrieve the buffer and read as much data as possible.
+            //  Note that buffer can be arbitrarily large. However, we assume
+            //  the underlying TCP layer has fixed buffer size and thus the
+            //  number of bytes read will be always limited.
+            decoder.get_buffer (&inpos, &insize);
+            size_t bufsize = insize;
+            insize = read (inpos, insize);
+
+            //  Check whether the peer has closed the connection.
+            if (insize == (size_t) -1) {
+                insize = 0;
+                disconnection = true;
+            }
+            else
+                drained = insize < bufsize;
+
+            //  Zero byte can't start an uncompressed stream. It's the first
+            //  byte of the compressed stream greeting.
+            if (detecting && insize) {
+                detecting = false;
+                if (*inpos == 0) {
+                    decompressor = new (std::nothrow) decompressor_t;
+                    alloc_assert (decompressor);
+                    if (budget)
+                        budget->charge (decompressor->buffer_size ());
+
+                    unsigned char *buf;
+                    decompressor->get_buffer (&buf, &bufsize);
+                    zmq_assert (insize <= bufsize);
+                    memcpy (buf, inpos, insize);
+                    decompressor->filled (insize);
+                    if (read_compressed (&drained) != 0)
+                        disconnection = true;
+                }
+            }
+        }
 
-        //  Stop polling for input if we got stuck.
-        if (processed < insize) {
+        //  Push the data to the decoder.
+        size_t processed = decoder.process_buffer (inpos, insize);
 
-            //  This may happen if queue limits are in effect.
-            if (plugged)
-                reset_pollin (handle);
+        if (unlikely (processed == (size_t) -1)) {
+            disconnection = true;
+        }
+        else {
+
+            //  Stop polling for input if we got stuck.
+            if (processed < insize || decoder.stuck ()) {
+                stopped = true;
+
+                //  This may happen if queue limits are in effect.
+                if (plugged) {
+                    if (edge_triggered)
+                        input_stopped = true;
+                    else
+                        reset_pollin (handle);
+                }
+            }
+
+            //  Adjust the buffer.
+            inpos += processed;
+            insize -= processed;
         }
 
-        //  Adjust the buffer.
-        inpos += processed;
-        insize -= processed;
+        //  With level-triggered polling the poller reports the rest of the
+        //  data later on. With edge-triggered polling there will be no new
+        //  event till the socket is drained. Complete blocks already read
+        //  by the decompressor are not reported by the poller either way.
+        if ((!edge_triggered && !decompressor) || !plugged ||
+              disconnection || stopped || drained)
+            break;
     }
 
     //  Flush all messages the decoder may have produced.
@@ -208,46 +299,82 @@ void zmq::stream_engine_t::in_event ()
 
 void zmq::stream_engine_t::out_event ()
 {
-    //  If write buffer is empty, try to read new data from the encoder.
-    if (!outsize) {
-
-        outpos = NULL;
-        encoder.get_data (&outpos, &outsize);
+    bool written = false;
+    while (true) {
+
+        //  If write buffer is empty, try to read new data from the encoder.
+        if (!outsize) {
+
+            //  With compression on, the encoder fills in the compressor's
+            //  buffer instead of passing the message data directly.
+            if (compressor)
+                compressor->get_buffer (&outpos, &outsize);
+            else
+                outpos = NULL;
+            encoder.get_data (&outpos, &outsize);
+
+            //  If IO handler has unplugged engine, flush transient IO handler.
+            if (unlikely (!plugged)) {
+                zmq_assert (leftover_session);
+                leftover_session->flush ();
+                return;
+            }
+
+            //  If there is no data to send, stop polling for output.
+            //  In edge-triggered mode there's nothing to stop, the engine
+            //  is activated when there are new messages to send.
+            if (outsize == 0) {
+                if (!edge_triggered)
+                    reset_pollout (handle);
+                return;
+            }
+
+            //  Send the compressed form of the data instead.
+            if (compressor) {
+                size_t raw_size = outsize;
+                compressor->compress (raw_size, &outpos, &outsize);
+                socket->add_compressed (raw_size, outsize);
+            }
+        }
 
-        //  If IO handler has unplugged engine, flush transient IO handler.
-        if (unlikely (!plugged)) {
-            zmq_assert (leftover_session);
-            leftover_session->flush ();
+        //  With level-triggered polling the poller reports when more data
+        //  can be written. The data fetched after the write are written
+        //  once it does so.
+        if (written && !edge_triggered)
             return;
-        }
 
-        //  If there is no data to send, stop polling for output.
-        if (outsize == 0) {
-            reset_pollout (handle);
+        //  If there are any data to write in write buffer, write as much as
+        //  possible to the socket. Note that amount of data to write can be
+        //  arbitratily large. However, we assume that underlying TCP layer has
+        //  limited transmission buffer and thus the actual number of bytes
+        //  written should be reasonably modest.
+        int nbytes = write (outpos, outsize);
+
+        //  Handle problems with the connection.
+        if (nbytes == -1) {
+            error ();
             return;
         }
-    }
 
-    //  If there are any data to write in write buffer, write as much as
-    //  possible to the socket. Note that amount of data to write can be
-    //  arbitratily large. However, we assume that underlying TCP layer has
-    //  limited transmission buffer and thus the actual number of bytes
-    //  written should be reasonably modest.
-    int nbytes = write (outpos, outsize);
+        outpos += nbytes;
+        outsize -= nbytes;
 
-    //  Handle problems with the connection.
-    if (nbytes == -1) {
-        error ();
-        return;
+        //  If the socket is full, wait till it's writable again. Otherwise,
+        //  with edge-triggered polling keep writing till it is full. With
+        //  level-triggered polling, fetch the next data to find out whether
+        //  there are any. If there are none, polling for output is stopped
+        //  in the same loop iteration it was started in by activate_out, so
+        //  the poller doesn't have to update the pollset at all.
+        if (outsize)
+            return;
+        written = true;
     }
-
-    outpos += nbytes;
-    outsize -= nbytes;
 }
 
 void zmq::stream_engine_t::activate_out ()
 {
-    set_pollout (handle);
+    if (!edge_triggered)
+        set_pollout (handle);
 
     //  Speculative write: The assumption is that at the moment new message
     //  was sent by the user the socket is probably available for writing.
@@ -258,12 +385,52 @@ void zmq::stream_engine_t::activate_out ()
 
 void zmq::stream_engine_t::activate_in ()
 {
-    set_pollin (handle);
+    if (edge_triggered)
+        input_stopped = false;
+    else
+        set_pollin (handle);
 
     //  Speculative read.
     in_event ();
 }
 
+size_t zmq::stream_engine_t::buffer_size ()
+{
+    size_t size = in_batch_size + out_batch_size;
+    if (compressor)
+        size += compressor->buffer_size ();
+    if (decompressor)
+        size += decompressor->buffer_size ();
+    return size;
+}
+
+int zmq::stream_engine_t::read_compressed (bool *drained_)
+{
+    *drained_ = false;
+    int rc = decompressor->decompress (&inpos, &insize);
+    if (rc != 0 && errno == EAGAIN) {
+        unsigned char *buf;
+        size_t bufsize;
+        decompressor->get_buffer (&buf, &bufsize);
+        zmq_assert (bufsize);
+        int nbytes = read (buf, bufsize);
+        if (nbytes == -1) {
+            insize = 0;
+            return -1;
+        }
+        decompressor->filled (nbytes);
+        rc = decompressor->decompress (&inpos, &insize);
+        if (rc != 0 && errno == EAGAIN)
+            *drained_ = (size_t) nbytes < bufsize;
+    }
+    if (rc != 0) {
+        insize = 0;
+        if (errno != EAGAIN)
+            return -1;
+    }
+    return 0;
+}
+
 void zmq::stream_engine_t::error ()
 {
     zmq_assert (session);
@@ -298,13 +465,18 @@ int zmq::stream_engine_t::write (const void *data_, size_t size_)
 
 #else
 
-    ssize_t nbytes = send (s, data_, size_, 0);
-
-    //  Several errors are OK. When speculative write is being done we may not
-    //  be able to write a single byte from the socket. Also, SIGSTOP issued
-    //  by a debugging tool can result in EINTR error.
-    if (nbytes == -1 && (errno == EAGAIN || errno == EWOULDBLOCK ||
-          errno == EINTR))
+    //  SIGSTOP issued by a debugging tool can result in EINTR error. The
+    //  call is retried straight away. Returning 0 would make the engine wait
+    //  for the next poller event which, with edge-triggered polling, never
+    //  comes as the socket's state hasn't changed.
+    ssize_t nbytes;
+    do {
+        nbytes = send (s, data_, size_, 0);
+    } while (nbytes == -1 && errno == EINTR);
+
+    //  When speculative write is being done we may not be able to write
+    //  a single byte from the socket.
+    if (nbytes == -1 && (errno == EAGAIN || errno == EWOULDBLOCK))
         return 0;
 
     //  Signalise peer failure.
@@ -349,13 +521,15 @@ int zmq::stream_engine_t::read (void *data_, size_t size_)
 
 #else
 
-    ssize_t nbytes = recv (s, data_, size_, 0);
+    //  Retry on EINTR for the same reason as in write.
+    ssize_t nbytes;
+    do {
+        nbytes = recv (s, data_, size_, 0);
+    } while (nbytes == -1 && errno == EINTR);
 
-    //  Several errors are OK. When speculative read is being done we may not
-    //  be able to read a single byte from the socket. Also, SIGSTOP issued
-    //  by a debugging tool can result in EINTR error.
-    if (nbytes == -1 && (errno == EAGAIN || errno == EWOULDBLOCK ||
-          errno == EINTR))
+    //  When speculative read is being done we may not be able to read
+    //  a single byte from the socket.
+    if (nbytes == -1 && (errno == EAGAIN || errno == EWOULDBLOCK))
         return 0;
 
     //  Signalise peer failure.
@@ -30,12 +30,15 @@
 #include "encoder.hpp"
 #include "decoder.hpp"
 #include "options.hpp"
+#include "memory_budget.hpp"
+#include "compression.hpp"
 
 namespace zmq
 {
 
     class io_thread_t;
     class session_base_t;
+    class socket_base_t;
 
     //  This engine handles any socket with SOCK_STREAM semantics,
     //  e.g. TCP socket or an UNIX domain socket.
@@ -64,6 +67,15 @@ namespace zmq
         //  Function to handle network disconnections.
         void error ();
 
+        //  Returns the size of I/O buffers accounted to the memory budget.
+        size_t buffer_size ();
+
+        //  Stores the next decompressed block to 'inpos' and 'insize',
+        //  reading from the socket if there's no complete block. Sets
+        //  drained_ if there's no complete block and the socket was drained.
+        //  Returns -1 if the connection failed or the data are malformed.
+        int read_compressed (bool *drained_);
+
         //  Writes data to the socket. Returns the number of bytes actually
         //  written (even zero is to be considered to be a success). In case
         //  of error or orderly shutdown by the other peer -1 is returned.
@@ -96,8 +108,34 @@ namespace zmq
 
         options_t options;
 
+        //  Memory budget the I/O buffers are accounted to while the engine
+        //  is plugged, NULL if there's no memory limit.
+        memory_budget_t *budget;
+
         bool plugged;
 
+        //  If true, the socket is polled in edge-triggered mode and the
+        //  engine keeps reading and writing till the socket would block.
+        bool edge_triggered;
+
+        //  In edge-triggered mode, true if the engine doesn't read from
+        //  the socket because the session doesn't accept more messages.
+        bool input_stopped;
+
+        //  Compresses the data sent, NULL if compression is off.
+        compressor_t *compressor;
+
+        //  Decompresses the data received, NULL if the peer doesn't
+        //  compress them.
+        decompressor_t *decompressor;
+
+        //  True till the first byte, telling whether the peer compresses
+        //  the data, is received.
+        bool detecting;
+
+        //  The socket the compressed data are accounted to.
+        zmq::socket_base_t *socket;
+
         stream_engine_t (const stream_engine_t&);
         const stream_engine_t &operator = (const stream_engine_t&);
     };
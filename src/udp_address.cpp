@@ -0,0 +1,97 @@
+/*
+    Copyright (c) 2009-2011 250bpm s.r.o.
+    Copyright (c) 2007-2011 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "udp_address.hpp"
+
+#if defined ZMQ_HAVE_LINUX
+
+#include <string.h>
+#include <string>
+
+#include "err.hpp"
+
+zmq::udp_address_t::udp_address_t ()
+{
+    interface.s_addr = htonl (INADDR_ANY);
+}
+
+zmq::udp_address_t::~udp_address_t ()
+{
+}
+
+int zmq::udp_address_t::resolve (const char *name_, bool bind_,
+    bool ipv4only_)
+{
+    //  The interface, if any, is separated from the rest by semicolon.
+    const char *delimiter = strchr (name_, ';');
+    if (delimiter) {
+        std::string iface_str (name_, delimiter - name_);
+        iface_str += ":0";
+        tcp_address_t iface;
+        int rc = iface.resolve (iface_str.c_str (), true, true);
+        if (rc != 0)
+            return -1;
+        interface = ((sockaddr_in*) iface.addr ())->sin_addr;
+        name_ = delimiter + 1;
+    }
+
+    int rc = address.resolve (name_, bind_, ipv4only_);
+    if (rc != 0)
+        return -1;
+
+    //  Datagrams have to be addressed to a particular port.
+    if (!bind_ && ((family () == AF_INET6 &&
+          ((sockaddr_in6*) addr ())->sin6_port == 0) ||
+          (family () == AF_INET && ((sockaddr_in*) addr ())->sin_port == 0))) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    return 0;
+}
+
+sa_family_t zmq::udp_address_t::family ()
+{
+    return address.family ();
+}
+
+sockaddr *zmq::udp_address_t::addr ()
+{
+    return address.addr ();
+}
+
+socklen_t zmq::udp_address_t::addrlen ()
+{
+    return address.addrlen ();
+}
+
+bool zmq::udp_address_t::is_multicast ()
+{
+    if (family () == AF_INET6)
+        return IN6_IS_ADDR_MULTICAST (&((sockaddr_in6*) addr ())->sin6_addr);
+    return IN_MULTICAST (ntohl (((sockaddr_in*) addr ())->sin_addr.s_addr));
+}
+
+in_addr zmq::udp_address_t::interface_addr ()
+{
+    return interface;
+}
+
+#endif
@@ -0,0 +1,74 @@
+/*
+    Copyright (c) 2009-2011 250bpm s.r.o.
+    Copyright (c) 2007-2011 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __ZMQ_UDP_ADDRESS_HPP_INCLUDED__
+#define __ZMQ_UDP_ADDRESS_HPP_INCLUDED__
+
+#include "platform.hpp"
+
+#if defined ZMQ_HAVE_LINUX
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+
+#include "tcp_address.hpp"
+
+namespace zmq
+{
+
+    class udp_address_t
+    {
+    public:
+
+        udp_address_t ();
+        ~udp_address_t ();
+
+        //  Translates textual address of the form [interface;]host:port
+        //  into an address structure. If 'bind_' is true, the host is
+        //  resolved as a local address to receive on, which may as well be
+        //  a multicast group. Otherwise it is resolved as the hostname to
+        //  send to. The interface is used with IPv4 multicast only.
+        int resolve (const char *name_, bool bind_, bool ipv4only_);
+
+        sa_family_t family ();
+        sockaddr *addr ();
+        socklen_t addrlen ();
+
+        //  True if the address is a multicast group.
+        bool is_multicast ();
+
+        //  The address of the interface to use for multicast. INADDR_ANY
+        //  if no interface was specified.
+        in_addr interface_addr ();
+
+    private:
+
+        tcp_address_t address;
+        in_addr interface;
+
+        udp_address_t (const udp_address_t&);
+        const udp_address_t &operator = (const udp_address_t&);
+    };
+
+}
+
+#endif
+
+#endif
@@ -0,0 +1,300 @@
+/*
+    Copyright (c) 2009-2011 250bpm s.r.o.
+    Copyright (c) 2007-2011 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "udp_receiver.hpp"
+
+#if defined ZMQ_HAVE_LINUX
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <netinet/in.h>
+
+#include "udp_address.hpp"
+#include "session_base.hpp"
+#include "msg.hpp"
+#include "wire.hpp"
+#include "likely.hpp"
+#include "stdint.hpp"
+#include "err.hpp"
+#include "ip.hpp"
+
+zmq::udp_receiver_t::udp_receiver_t (io_thread_t *parent_,
+      const options_t &options_) :
+    io_object_t (parent_),
+    s (retired_fd),
+    session (NULL),
+    options (options_),
+    buffers (NULL),
+    count (0),
+    current (0),
+    pos (0)
+{
+    memset (hdrs, 0, sizeof (hdrs));
+}
+
+zmq::udp_receiver_t::~udp_receiver_t ()
+{
+    if (s != retired_fd) {
+        int rc = close (s);
+        errno_assert (rc == 0);
+    }
+    free (buffers);
+}
+
+int zmq::udp_receiver_t::init (const char *address_)
+{
+    udp_address_t address;
+    int rc = address.resolve (address_, true, options.ipv4only ? true : false);
+    if (rc != 0)
+        return -1;
+
+    s = open_socket (address.family (), SOCK_DGRAM, IPPROTO_UDP);
+    if (s == retired_fd)
+        return -1;
+    unblock_socket (s);
+
+    if (options.rcvbuf) {
+        rc = setsockopt (s, SOL_SOCKET, SO_RCVBUF, &options.rcvbuf,
+            sizeof (int));
+        errno_assert (rc == 0);
+    }
+
+    //  Several subscribers on the same host may receive from the same
+    //  multicast group. Binding to the group address filters out
+    //  the datagrams sent to other groups on the same port.
+    if (address.is_multicast ()) {
+        int flag = 1;
+        rc = setsockopt (s, SOL_SOCKET, SO_REUSEADDR, &flag, sizeof (int));
+        errno_assert (rc == 0);
+    }
+
+    rc = bind (s, address.addr (), address.addrlen ());
+    if (rc != 0)
+        return -1;
+
+    if (address.is_multicast ()) {
+        if (address.family () == AF_INET6) {
+            ipv6_mreq mreq;
+            mreq.ipv6mr_multiaddr =
+                ((sockaddr_in6*) address.addr ())->sin6_addr;
+            mreq.ipv6mr_interface = 0;
+            rc = setsockopt (s, IPPROTO_IPV6, IPV6_JOIN_GROUP, &mreq,
+                sizeof (mreq));
+        }
+        else {
+            ip_mreq mreq;
+            mreq.imr_multiaddr = ((sockaddr_in*) address.addr ())->sin_addr;
+            mreq.imr_interface = address.interface_addr ();
+            rc = setsockopt (s, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq,
+                sizeof (mreq));
+        }
+        if (rc != 0)
+            return -1;
+    }
+
+    buffers = (unsigned char*) malloc (udp_batch_size * buffer_size);
+    alloc_assert (buffers);
+    for (int i = 0; i != udp_batch_size; i++) {
+        iovs [i].iov_base = buffers + i * buffer_size;
+        iovs [i].iov_len = buffer_size;
+        hdrs [i].msg_hdr.msg_iov = &iovs [i];
+        hdrs [i].msg_hdr.msg_iovlen = 1;
+    }
+
+    return 0;
+}
+
+void zmq::udp_receiver_t::plug (io_thread_t *io_thread_,
+    session_base_t *session_)
+{
+    session = session_;
+    handle = add_fd (s);
+    set_pollin (handle);
+    drop_subscriptions ();
+}
+
+void zmq::udp_receiver_t::unplug ()
+{
+    rm_fd (handle);
+    session = NULL;
+}
+
+void zmq::udp_receiver_t::terminate ()
+{
+    unplug ();
+    delete this;
+}
+
+void zmq::udp_receiver_t::activate_out ()
+{
+    drop_subscriptions ();
+}
+
+void zmq::udp_receiver_t::activate_in ()
+{
+    //  Pass on the rest of the messages received before the session
+    //  stopped accepting them. Then resume reading from the socket.
+    int rc = process ();
+    session->flush ();
+    if (rc != 0)
+        return;
+
+    set_pollin (handle);
+    in_event ();
+}
+
+void zmq::udp_receiver_t::in_event ()
+{
+    while (true) {
+        int rc = recvmmsg (s, hdrs, udp_batch_size, MSG_DONTWAIT, NULL);
+        if (rc == -1) {
+            if (errno == EINTR)
+                continue;
+            errno_assert (errno == EAGAIN || errno == EWOULDBLOCK);
+            break;
+        }
+        count = rc;
+        current = 0;
+        pos = 0;
+
+        //  If the session doesn't accept more messages, stop reading till
+        //  it asks for more.
+        if (process () != 0) {
+            reset_pollin (handle);
+            break;
+        }
+
+        //  The socket is drained.
+        if (rc < udp_batch_size)
+            break;
+    }
+
+    session->flush ();
+}
+
+int zmq::udp_receiver_t::process ()
+{
+    for (; current != count; current++, pos = 0) {
+        const unsigned char *data = buffers + current * buffer_size;
+        size_t size = hdrs [current].msg_len;
+
+        //  The datagram didn't fit into the buffer.
+        if (unlikely (hdrs [current].msg_hdr.msg_flags & MSG_TRUNC))
+            continue;
+
+        while (pos != size) {
+
+            //  Make sure the whole message is in the datagram before any
+            //  of its parts is passed on.
+            size_t end = pos;
+            bool more = true;
+            bool too_large = false;
+            size_t body_pos;
+            size_t body_size;
+            while (more) {
+                if (parse_frame (data, size, end, &body_pos, &body_size,
+                      &more) != 0)
+                    break;
+                if (options.maxmsgsize >= 0 &&
+                      (int64_t) body_size > options.maxmsgsize)
+                    too_large = true;
+                end = body_pos + body_size;
+            }
+
+            //  The rest of the datagram is malformed.
+            if (more)
+                break;
+
+            //  Skip the message larger than the limit.
+            if (too_large) {
+                pos = end;
+                continue;
+            }
+
+            //  Pass the parts of the message to the session. Once the first
+            //  part is accepted, so is the rest of the message.
+            bool first = true;
+            while (pos != end) {
+                parse_frame (data, size, pos, &body_pos, &body_size, &more);
+                msg_t msg;
+                int rc = msg.init_size (body_size);
+                errno_assert (rc == 0);
+                memcpy (msg.data (), data + body_pos, body_size);
+                if (more)
+                    msg.set_flags (msg_t::more);
+                if (session->write (&msg) != 0) {
+                    zmq_assert (first);
+                    rc = msg.close ();
+                    errno_assert (rc == 0);
+                    return -1;
+                }
+                first = false;
+                pos = body_pos + body_size;
+            }
+        }
+    }
+    return 0;
+}
+
+int zmq::udp_receiver_t::parse_frame (const unsigned char *data_,
+    size_t size_, size_t pos_, size_t *body_pos_, size_t *body_size_,
+    bool *more_)
+{
+    //  The frame header is the size of the frame including the flags
+    //  (one byte, or 0xff followed by eight bytes) and the flags.
+    uint64_t frame_size;
+    if (pos_ + 2 > size_)
+        return -1;
+    if (data_ [pos_] != 0xff) {
+        frame_size = data_ [pos_];
+        pos_++;
+    }
+    else {
+        if (pos_ + 10 > size_)
+            return -1;
+        frame_size = get_uint64 ((unsigned char*) data_ + pos_ + 1);
+        pos_ += 9;
+    }
+    if (frame_size == 0 || frame_size > size_ - pos_)
+        return -1;
+
+    *more_ = data_ [pos_] & msg_t::more ? true : false;
+    *body_pos_ = pos_ + 1;
+    *body_size_ = (size_t) frame_size - 1;
+    return 0;
+}
+
+void zmq::udp_receiver_t::drop_subscriptions ()
+{
+    msg_t msg;
+    int rc = msg.init ();
+    errno_assert (rc == 0);
+    while (session->read (&msg) == 0) {
+        rc = msg.close ();
+        errno_assert (rc == 0);
+        rc = msg.init ();
+        errno_assert (rc == 0);
+    }
+    rc = msg.close ();
+    errno_assert (rc == 0);
+}
+
+#endif
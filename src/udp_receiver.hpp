@@ -0,0 +1,112 @@
+/*
+    Copyright (c) 2009-2011 250bpm s.r.o.
+    Copyright (c) 2007-2011 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __ZMQ_UDP_RECEIVER_HPP_INCLUDED__
+#define __ZMQ_UDP_RECEIVER_HPP_INCLUDED__
+
+#include "platform.hpp"
+
+#if defined ZMQ_HAVE_LINUX
+
+#include <stddef.h>
+#include <sys/socket.h>
+
+#include "fd.hpp"
+#include "io_object.hpp"
+#include "i_engine.hpp"
+#include "options.hpp"
+#include "config.hpp"
+
+namespace zmq
+{
+
+    class io_thread_t;
+    class session_base_t;
+
+    //  Receives the datagrams sent by udp_sender_t and passes the messages
+    //  in them to the session. The datagrams are received in batches.
+    //  Each datagram is processed on its own; if it is malformed, the rest
+    //  of it is dropped. When the session doesn't accept more messages,
+    //  the receiver stops reading from the socket and the datagrams that
+    //  don't fit into the kernel buffer are lost.
+
+    class udp_receiver_t : public io_object_t, public i_engine
+    {
+    public:
+
+        udp_receiver_t (zmq::io_thread_t *parent_, const options_t &options_);
+        ~udp_receiver_t ();
+
+        int init (const char *address_);
+
+        //  i_engine interface implementation.
+        void plug (zmq::io_thread_t *io_thread_,
+            zmq::session_base_t *session_);
+        void unplug ();
+        void terminate ();
+        void activate_in ();
+        void activate_out ();
+
+        //  i_poll_events interface implementation.
+        void in_event ();
+
+    private:
+
+        //  Size of the buffer for a single datagram. Any UDP datagram fits.
+        enum {buffer_size = 65536};
+
+        //  Passes the messages from the received datagrams to the session.
+        //  Returns -1 if the session doesn't accept more messages.
+        int process ();
+
+        //  Parses the frame header at pos_. Returns -1 if the frame doesn't
+        //  fit into the datagram.
+        int parse_frame (const unsigned char *data_, size_t size_,
+            size_t pos_, size_t *body_pos_, size_t *body_size_, bool *more_);
+
+        //  There's no upstream, so the subscriptions are dropped.
+        void drop_subscriptions ();
+
+        //  UDP socket.
+        fd_t s;
+        handle_t handle;
+
+        zmq::session_base_t *session;
+
+        options_t options;
+
+        //  Received datagrams, the datagram being processed and
+        //  the position of the next message in it.
+        unsigned char *buffers;
+        mmsghdr hdrs [udp_batch_size];
+        iovec iovs [udp_batch_size];
+        int count;
+        int current;
+        size_t pos;
+
+        udp_receiver_t (const udp_receiver_t&);
+        const udp_receiver_t &operator = (const udp_receiver_t&);
+    };
+
+}
+
+#endif
+
+#endif
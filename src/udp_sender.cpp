@@ -0,0 +1,294 @@
+/*
+    Copyright (c) 2009-2011 250bpm s.r.o.
+    Copyright (c) 2007-2011 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "udp_sender.hpp"
+
+#if defined ZMQ_HAVE_LINUX
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <netinet/in.h>
+
+#include "udp_address.hpp"
+#include "session_base.hpp"
+#include "msg.hpp"
+#include "wire.hpp"
+#include "err.hpp"
+#include "ip.hpp"
+
+zmq::udp_sender_t::udp_sender_t (io_thread_t *parent_,
+      const options_t &options_) :
+    io_object_t (parent_),
+    s (retired_fd),
+    session (NULL),
+    options (options_),
+    buffers (NULL),
+    count (0),
+    sent (0),
+    msgbuf (NULL),
+    msgbuf_size (0),
+    staged (0),
+    staged_in_flight (false)
+{
+    memset (hdrs, 0, sizeof (hdrs));
+    for (int i = 0; i != udp_batch_size; i++) {
+        hdrs [i].msg_hdr.msg_iov = &iovs [i];
+        hdrs [i].msg_hdr.msg_iovlen = 1;
+    }
+}
+
+zmq::udp_sender_t::~udp_sender_t ()
+{
+    if (s != retired_fd) {
+        int rc = close (s);
+        errno_assert (rc == 0);
+    }
+    free (buffers);
+    free (msgbuf);
+}
+
+int zmq::udp_sender_t::init (const char *address_)
+{
+    udp_address_t address;
+    int rc = address.resolve (address_, false, options.ipv4only ? true : false);
+    if (rc != 0)
+        return -1;
+
+    s = open_socket (address.family (), SOCK_DGRAM, IPPROTO_UDP);
+    if (s == retired_fd)
+        return -1;
+    unblock_socket (s);
+
+    if (options.sndbuf) {
+        rc = setsockopt (s, SOL_SOCKET, SO_SNDBUF, &options.sndbuf,
+            sizeof (int));
+        errno_assert (rc == 0);
+    }
+
+    //  Multicast datagrams are looped back so that the subscribers on this
+    //  host get them as well.
+    if (address.is_multicast ()) {
+        if (address.family () == AF_INET6)
+            rc = setsockopt (s, IPPROTO_IPV6, IPV6_MULTICAST_HOPS,
+                &options.multicast_hops, sizeof (int));
+        else {
+            rc = setsockopt (s, IPPROTO_IP, IP_MULTICAST_TTL,
+                &options.multicast_hops, sizeof (int));
+            if (rc == 0) {
+                in_addr iface = address.interface_addr ();
+                rc = setsockopt (s, IPPROTO_IP, IP_MULTICAST_IF, &iface,
+                    sizeof (iface));
+            }
+        }
+        if (rc != 0)
+            return -1;
+    }
+
+    //  The socket is connected so that the destination doesn't have to be
+    //  passed with each datagram.
+    rc = connect (s, address.addr (), address.addrlen ());
+    if (rc != 0)
+        return -1;
+
+    buffers = (unsigned char*) malloc (udp_batch_size * udp_datagram_size);
+    alloc_assert (buffers);
+    msgbuf_size = udp_datagram_size;
+    msgbuf = (unsigned char*) malloc (msgbuf_size);
+    alloc_assert (msgbuf);
+
+    return 0;
+}
+
+void zmq::udp_sender_t::plug (io_thread_t *io_thread_,
+    session_base_t *session_)
+{
+    session = session_;
+    handle = add_fd (s);
+    set_pollout (handle);
+}
+
+void zmq::udp_sender_t::unplug ()
+{
+    rm_fd (handle);
+    session = NULL;
+}
+
+void zmq::udp_sender_t::terminate ()
+{
+    unplug ();
+    delete this;
+}
+
+void zmq::udp_sender_t::activate_out ()
+{
+    set_pollout (handle);
+    out_event ();
+}
+
+void zmq::udp_sender_t::activate_in ()
+{
+    zmq_assert (false);
+}
+
+void zmq::udp_sender_t::out_event ()
+{
+    //  If the whole batch was sent, pack the next one. If there are no
+    //  messages to send, stop polling for output.
+    if (sent == count) {
+        pack ();
+        if (!count) {
+            reset_pollout (handle);
+            return;
+        }
+    }
+
+    //  A single batch is sent per event so that the engines sharing
+    //  the I/O thread, possibly the receiving end, get their turn.
+    int rc = sendmmsg (s, hdrs + sent, count - sent, 0);
+    if (rc == -1) {
+
+        //  The kernel buffer is full. Wait till there's space in it.
+        if (errno == EAGAIN || errno == EWOULDBLOCK || errno == ENOBUFS ||
+              errno == EINTR)
+            return;
+
+        //  The datagram can't be delivered. There's no one to tell, the
+        //  datagram is simply lost.
+        errno_assert (errno == ECONNREFUSED || errno == EHOSTUNREACH ||
+            errno == ENETUNREACH || errno == ENETDOWN ||
+            errno == EMSGSIZE || errno == EPERM);
+        rc = 1;
+    }
+    sent += rc;
+
+    if (sent == count && staged_in_flight) {
+        staged = 0;
+        staged_in_flight = false;
+    }
+}
+
+void zmq::udp_sender_t::pack ()
+{
+    count = 0;
+    sent = 0;
+    size_t used = 0;
+
+    while (count != udp_batch_size) {
+        if (!staged && stage () != 0)
+            break;
+        unsigned char *buffer = buffers + count * udp_datagram_size;
+
+        //  Large message goes to a datagram of its own.
+        if (staged > udp_datagram_size) {
+            if (used) {
+                iovs [count].iov_base = buffer;
+                iovs [count].iov_len = used;
+                count++;
+                used = 0;
+                continue;
+            }
+            iovs [count].iov_base = msgbuf;
+            iovs [count].iov_len = staged;
+            count++;
+            staged_in_flight = true;
+            return;
+        }
+
+        //  If the message doesn't fit into the datagram, start a new one.
+        if (used + staged > udp_datagram_size) {
+            iovs [count].iov_base = buffer;
+            iovs [count].iov_len = used;
+            count++;
+            used = 0;
+            continue;
+        }
+
+        memcpy (buffer + used, msgbuf, staged);
+        used += staged;
+        staged = 0;
+    }
+
+    if (used) {
+        iovs [count].iov_base = buffers + count * udp_datagram_size;
+        iovs [count].iov_len = used;
+        count++;
+    }
+}
+
+int zmq::udp_sender_t::stage ()
+{
+    msg_t msg;
+    int rc = msg.init ();
+    errno_assert (rc == 0);
+
+    while (true) {
+
+        //  Encode all the parts of the message. If the message doesn't fit
+        //  into a datagram, the rest of it is read and dropped.
+        size_t size = 0;
+        bool dropped = false;
+        bool more = true;
+        while (more) {
+            if (session->read (&msg) != 0) {
+                zmq_assert (errno == EAGAIN);
+                rc = msg.close ();
+                errno_assert (rc == 0);
+                return -1;
+            }
+            size_t body_size = msg.size ();
+            size_t frame_size = body_size + (body_size + 1 < 255 ? 2 : 10);
+            more = msg.flags () & msg_t::more ? true : false;
+            if (size + frame_size > max_datagram_size)
+                dropped = true;
+            if (!dropped) {
+                if (size + frame_size > msgbuf_size) {
+                    msgbuf_size = max_datagram_size;
+                    msgbuf = (unsigned char*) realloc (msgbuf, msgbuf_size);
+                    alloc_assert (msgbuf);
+                }
+                unsigned char *pos = msgbuf + size;
+                if (body_size + 1 < 255)
+                    *pos++ = (unsigned char) (body_size + 1);
+                else {
+                    *pos++ = 0xff;
+                    put_uint64 (pos, body_size + 1);
+                    pos += 8;
+                }
+                *pos++ = more ? msg_t::more : 0;
+                memcpy (pos, msg.data (), body_size);
+                size += frame_size;
+            }
+            rc = msg.close ();
+            errno_assert (rc == 0);
+            rc = msg.init ();
+            errno_assert (rc == 0);
+        }
+
+        if (!dropped) {
+            rc = msg.close ();
+            errno_assert (rc == 0);
+            staged = size;
+            return 0;
+        }
+    }
+}
+
+#endif
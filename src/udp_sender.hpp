@@ -0,0 +1,113 @@
+/*
+    Copyright (c) 2009-2011 250bpm s.r.o.
+    Copyright (c) 2007-2011 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __ZMQ_UDP_SENDER_HPP_INCLUDED__
+#define __ZMQ_UDP_SENDER_HPP_INCLUDED__
+
+#include "platform.hpp"
+
+#if defined ZMQ_HAVE_LINUX
+
+#include <stddef.h>
+#include <sys/socket.h>
+
+#include "fd.hpp"
+#include "io_object.hpp"
+#include "i_engine.hpp"
+#include "options.hpp"
+#include "config.hpp"
+
+namespace zmq
+{
+
+    class io_thread_t;
+    class session_base_t;
+
+    //  Sends the messages from the session as UDP datagrams. As many
+    //  complete messages as fit are packed into each datagram, using
+    //  the same framing as TCP connections do. The datagrams are passed to
+    //  the kernel in batches.
+
+    class udp_sender_t : public io_object_t, public i_engine
+    {
+    public:
+
+        udp_sender_t (zmq::io_thread_t *parent_, const options_t &options_);
+        ~udp_sender_t ();
+
+        int init (const char *address_);
+
+        //  i_engine interface implementation.
+        void plug (zmq::io_thread_t *io_thread_,
+            zmq::session_base_t *session_);
+        void unplug ();
+        void terminate ();
+        void activate_in ();
+        void activate_out ();
+
+        //  i_poll_events interface implementation.
+        void out_event ();
+
+    private:
+
+        //  The largest payload of a UDP datagram.
+        enum {max_datagram_size = 65507};
+
+        //  Reads the next message from the session and encodes it into
+        //  the staging buffer. Messages that don't fit into a datagram are
+        //  dropped. Returns -1 if there are no messages to send.
+        int stage ();
+
+        //  Packs the messages into the next batch of datagrams.
+        void pack ();
+
+        //  UDP socket.
+        fd_t s;
+        handle_t handle;
+
+        zmq::session_base_t *session;
+
+        options_t options;
+
+        //  Batch of datagrams to send and the number of datagrams in it
+        //  that were sent already.
+        unsigned char *buffers;
+        mmsghdr hdrs [udp_batch_size];
+        iovec iovs [udp_batch_size];
+        int count;
+        int sent;
+
+        //  The message read from the session but not yet packed into
+        //  a datagram. A message larger than udp_datagram_size is sent
+        //  right from the staging buffer, as the last one in the batch.
+        unsigned char *msgbuf;
+        size_t msgbuf_size;
+        size_t staged;
+        bool staged_in_flight;
+
+        udp_sender_t (const udp_sender_t&);
+        const udp_sender_t &operator = (const udp_sender_t&);
+    };
+
+}
+
+#endif
+
+#endif
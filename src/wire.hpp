@@ -21,6 +21,9 @@
 #ifndef __ZMQ_WIRE_HPP_INCLUDED__
 #define __ZMQ_WIRE_HPP_INCLUDED__
 
+#include <stddef.h>
+#include <string.h>
+
 #include "stdint.hpp"
 
 namespace zmq
@@ -94,6 +97,38 @@ namespace zmq
             ((uint64_t) buffer_ [7]);
     }
 
+    //  Copies the body of a small frame. Fixed-size moves, possibly
+    //  overlapping, compile into plain vector loads and stores, which is
+    //  much faster for short bodies than a call to memcpy or a string
+    //  instruction. Nothing outside of the destination range is written.
+    inline void copy_body (unsigned char *dst_, const unsigned char *src_,
+        size_t size_)
+    {
+        if (size_ >= 16) {
+            for (size_t i = 0; i + 16 < size_; i += 16)
+                memcpy (dst_ + i, src_ + i, 16);
+            memcpy (dst_ + size_ - 16, src_ + size_ - 16, 16);
+        }
+        else if (size_ >= 8) {
+            memcpy (dst_, src_, 8);
+            memcpy (dst_ + size_ - 8, src_ + size_ - 8, 8);
+        }
+        else if (size_ >= 4) {
+            memcpy (dst_, src_, 4);
+            memcpy (dst_ + size_ - 4, src_ + size_ - 4, 4);
+        }
+        else
+            for (size_t i = 0; i != size_; i++)
+                dst_ [i] = src_ [i];
+    }
+
+    //  Subscription message consists of a single byte (1 for subscription,
+    //  0 for unsubscription) followed by the topic. Batch of subscriptions
+    //  starts with 'subscription_batch' byte followed by any number of
+    //  entries, each consisting of the subscribe/unsubscribe byte, 4-byte
+    //  topic length in network byte order and the topic itself.
+    enum {subscription_batch = 2};
+
 }
 
 #endif
@@ -20,11 +20,14 @@
 */
 
 #include <string.h>
+#include <algorithm>
 
 #include "xpub.hpp"
 #include "pipe.hpp"
+#include "wire.hpp"
 #include "err.hpp"
 #include "msg.hpp"
+#include "likely.hpp"
 
 zmq::xpub_t::xpub_t (class ctx_t *parent_, uint32_t tid_) :
     socket_base_t (parent_, tid_),
@@ -35,6 +38,12 @@ zmq::xpub_t::xpub_t (class ctx_t *parent_, uint32_t tid_) :
 
 zmq::xpub_t::~xpub_t ()
 {
+    for (lvc_t::iterator it = lvc.begin (); it != lvc.end (); ++it) {
+        for (parts_t::size_type i = 0; i != it->second.size (); i++) {
+            int rc = it->second [i].close ();
+            errno_assert (rc == 0);
+        }
+    }
 }
 
 void zmq::xpub_t::xattach_pipe (pipe_t *pipe_, bool icanhasall_)
@@ -66,23 +75,70 @@ void zmq::xpub_t::xread_activated (pipe_t *pipe_)
         unsigned char *data = (unsigned char*) sub.data ();
         size_t size = sub.size ();
         if (size > 0 && (*data == 0 || *data == 1)) {
-            bool unique;
-            if (*data == 0)
-                unique = subscriptions.rm (data + 1, size - 1, pipe_);
-            else
-                unique = subscriptions.add (data + 1, size - 1, pipe_);
 
             //  If the subscription is not a duplicate store it so that it can be
             //  passed to used on next recv call.
-            if (unique && options.type != ZMQ_PUB)
+            if (apply (data + 1, size - 1, *data == 1, pipe_) &&
+                  options.type != ZMQ_PUB)
                 pending.push_back (blob_t ((unsigned char*) sub.data (),
                     sub.size ()));
         }
+        else if (size > 0 && *data == subscription_batch) {
+
+            //  Apply the whole batch in a single pass. Unique subscriptions
+            //  are passed to the user as a batch as well. Malformed
+            //  remainder of the batch is ignored.
+            blob_t changes (1, (unsigned char) subscription_batch);
+            int count = 0;
+            size_t pos = 1;
+            while (size - pos >= 5 &&
+                  size - pos - 5 >= get_uint32 (data + pos + 1)) {
+                size_t topic_size = get_uint32 (data + pos + 1);
+                if ((data [pos] == 0 || data [pos] == 1) &&
+                      apply (data + pos + 5, topic_size, data [pos] == 1,
+                      pipe_)) {
+                    changes.append (data + pos, 5 + topic_size);
+                    count++;
+                }
+                pos += 5 + topic_size;
+            }
+
+            //  Single change is passed as a plain (un)subscription.
+            if (count == 1 && options.type != ZMQ_PUB) {
+                blob_t change (1, changes [1]);
+                change.append (changes, 6, blob_t::npos);
+                pending.push_back (change);
+            }
+            else if (count > 1 && options.type != ZMQ_PUB)
+                pending.push_back (changes);
+        }
 
         sub.close();
     }
 }
 
+bool zmq::xpub_t::apply (unsigned char *data_, size_t size_, bool subscribe_,
+    pipe_t *pipe_)
+{
+    if (!subscribe_)
+        return subscriptions.rm (data_, size_, pipe_);
+
+    bool unique = subscriptions.add (data_, size_, pipe_);
+
+    //  Send the cached values for the new subscription. If we are
+    //  in the middle of a multi-part message, postpone it till the
+    //  message is complete.
+    if (options.lvc >= 0) {
+        if (more)
+            lvc_pending.push_back (std::make_pair (pipe_,
+                blob_t (data_, size_)));
+        else
+            send_cached (pipe_, data_, size_);
+    }
+
+    return unique;
+}
+
 void zmq::xpub_t::xwrite_activated (pipe_t *pipe_)
 {
     dist.activated (pipe_);
@@ -95,6 +151,13 @@ void zmq::xpub_t::xterminated (pipe_t *pipe_)
     //  upstream.
     subscriptions.rm (pipe_, send_unsubscription, this);
 
+    //  Forget about postponed cached values for the pipe.
+    for (lvc_pending_t::size_type i = 0; i != lvc_pending.size ();)
+        if (lvc_pending [i].first == pipe_)
+            lvc_pending.erase (lvc_pending.begin () + i);
+        else
+            i++;
+
     dist.terminated (pipe_);
 }
 
@@ -108,6 +171,10 @@ int zmq::xpub_t::xsend (msg_t *msg_, int flags_)
 {
     bool msg_more = msg_->flags () & msg_t::more ? true : false;
 
+    //  Remember the message for the future subscribers.
+    if (options.lvc >= 0)
+        cache (msg_);
+
     //  For the first part of multi-part message, find the matching pipes.
     if (!more)
         subscriptions.match ((unsigned char*) msg_->data (), msg_->size (),
@@ -126,9 +193,81 @@ int zmq::xpub_t::xsend (msg_t *msg_, int flags_)
 
     more = msg_more;
 
+    //  Now that the message is complete we can send cached values to
+    //  the subscribers that have subscribed in the meantime.
+    if (!more && unlikely (!lvc_pending.empty ())) {
+        for (lvc_pending_t::size_type i = 0; i != lvc_pending.size (); i++)
+            send_cached (lvc_pending [i].first,
+                (unsigned char*) lvc_pending [i].second.data (),
+                lvc_pending [i].second.size ());
+        lvc_pending.clear ();
+    }
+
     return 0;
 }
 
+void zmq::xpub_t::cache (msg_t *msg_)
+{
+    //  First part of the message determines the topic. The older message
+    //  with the same topic is dropped.
+    if (!more) {
+        size_t size = std::min (msg_->size (), (size_t) options.lvc);
+        blob_t topic ((unsigned char*) msg_->data (), size);
+        lvc_t::iterator it = lvc.find (topic);
+        if (it == lvc.end ())
+            it = lvc.insert (lvc_t::value_type (topic, parts_t ())).first;
+        else {
+            for (parts_t::size_type i = 0; i != it->second.size (); i++) {
+                int rc = it->second [i].close ();
+                errno_assert (rc == 0);
+            }
+            it->second.clear ();
+        }
+        lvc_current = it;
+    }
+
+    msg_t copy;
+    int rc = copy.init ();
+    errno_assert (rc == 0);
+    rc = copy.copy (*msg_);
+    errno_assert (rc == 0);
+    lvc_current->second.push_back (copy);
+}
+
+void zmq::xpub_t::send_cached (pipe_t *pipe_, unsigned char *prefix_,
+    size_t size_)
+{
+    //  Topics matching the subscription form a continuous range in the cache.
+    //  If the subscription is longer than the topic, the message itself
+    //  has to be checked.
+    size_t topic_size = std::min (size_, (size_t) options.lvc);
+    blob_t topic (prefix_, topic_size);
+    for (lvc_t::iterator it = lvc.lower_bound (topic);
+          it != lvc.end () && it->first.compare (0, topic_size, topic) == 0;
+          ++it) {
+        parts_t &parts = it->second;
+        if (parts [0].size () < size_ ||
+              memcmp (parts [0].data (), prefix_, size_) != 0)
+            continue;
+
+        //  Send the message to the single pipe. If the pipe is full,
+        //  distributor drops the message.
+        dist.match (pipe_);
+        for (parts_t::size_type i = 0; i != parts.size (); i++) {
+            msg_t msg;
+            int rc = msg.init ();
+            errno_assert (rc == 0);
+            rc = msg.copy (parts [i]);
+            errno_assert (rc == 0);
+            rc = dist.send_to_matching (&msg, 0);
+            errno_assert (rc == 0);
+            rc = msg.close ();
+            errno_assert (rc == 0);
+        }
+        dist.unmatch ();
+    }
+}
+
 bool zmq::xpub_t::xhas_out ()
 {
     return dist.has_out ();
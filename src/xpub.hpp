@@ -23,6 +23,8 @@
 
 #include <deque>
 #include <string>
+#include <map>
+#include <vector>
 
 #include "socket_base.hpp"
 #include "session_base.hpp"
@@ -63,9 +65,22 @@ namespace zmq
         static void send_unsubscription (unsigned char *data_, size_t size_,
             void *arg_);
 
+        //  Applies the (un)subscription received from the pipe. Returns true
+        //  if the subscription is not a duplicate.
+        bool apply (unsigned char *data_, size_t size_, bool subscribe_,
+            zmq::pipe_t *pipe_);
+
         //  Function to be applied to each matching pipes.
         static void mark_as_matching (zmq::pipe_t *pipe_, void *arg_);
 
+        //  Stores the message part into the last value cache.
+        void cache (zmq::msg_t *msg_);
+
+        //  Sends all the cached messages matching the subscription
+        //  to the specified pipe.
+        void send_cached (zmq::pipe_t *pipe_, unsigned char *prefix_,
+            size_t size_);
+
         //  List of all subscriptions mapped to corresponding pipes.
         mtrie_t subscriptions;
 
@@ -81,6 +96,22 @@ namespace zmq
         typedef std::deque <blob_t> pending_t;
         pending_t pending;
 
+        //  Last value cache. Holds the latest message for each topic, topic
+        //  being the first options.lvc bytes of the message.
+        typedef std::vector <msg_t> parts_t;
+        typedef std::map <blob_t, parts_t> lvc_t;
+        lvc_t lvc;
+
+        //  Cache entry the message being sent is stored to.
+        lvc_t::iterator lvc_current;
+
+        //  Subscriptions that have arrived in the middle of a multi-part
+        //  message. Cached values for these are sent once the message is
+        //  complete.
+        typedef std::vector <std::pair <zmq::pipe_t*, blob_t> >
+            lvc_pending_t;
+        lvc_pending_t lvc_pending;
+
         xpub_t (const xpub_t&);
         const xpub_t &operator = (const xpub_t&);
     };
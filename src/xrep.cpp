@@ -46,12 +46,14 @@ zmq::xrep_t::xrep_t (class ctx_t *parent_, uint32_t tid_) :
     options.send_identity = true;
     options.recv_identity = true;
 
+    prefetched_id.init ();
     prefetched_msg.init ();
 }
 
 zmq::xrep_t::~xrep_t ()
 {
     zmq_assert (outpipes.empty ());
+    prefetched_id.close ();
     prefetched_msg.close ();
 }
 
@@ -63,17 +65,15 @@ void zmq::xrep_t::xattach_pipe (pipe_t *pipe_, bool icanhasall_)
     unsigned char buf [5];
     buf [0] = 0;
     put_uint32 (buf + 1, next_peer_id);
-    blob_t identity (buf, 5);
     ++next_peer_id;
 
     //  Add the pipe to the map out outbound pipes.
     outpipe_t outpipe = {pipe_, true};
-    bool ok = outpipes.insert (outpipes_t::value_type (
-        identity, outpipe)).second;
+    bool ok = outpipes.insert (buf, sizeof buf, outpipe);
     zmq_assert (ok);
 
     //  Add the pipe to the list of inbound pipes.
-    pipe_->set_identity (identity);
+    pipe_->set_identity (buf, sizeof buf);
     fq.attach (pipe_);    
 }
 
@@ -81,16 +81,10 @@ void zmq::xrep_t::xterminated (pipe_t *pipe_)
 {
     fq.terminated (pipe_);
 
-    for (outpipes_t::iterator it = outpipes.begin ();
-          it != outpipes.end (); ++it) {
-        if (it->second.pipe == pipe_) {
-            outpipes.erase (it);
-            if (pipe_ == current_out)
-                current_out = NULL;
-            return;
-        }
-    }
-    zmq_assert (false);
+    zmq_assert (lookup (pipe_));
+    outpipes.erase (pipe_->get_identity (), pipe_->get_identity_size ());
+    if (pipe_ == current_out)
+        current_out = NULL;
 }
 
 void zmq::xrep_t::xread_activated (pipe_t *pipe_)
@@ -100,15 +94,19 @@ void zmq::xrep_t::xread_activated (pipe_t *pipe_)
 
 void zmq::xrep_t::xwrite_activated (pipe_t *pipe_)
 {
-    for (outpipes_t::iterator it = outpipes.begin ();
-          it != outpipes.end (); ++it) {
-        if (it->second.pipe == pipe_) {
-            zmq_assert (!it->second.active);
-            it->second.active = true;
-            return;
-        }
-    }
-    zmq_assert (false);
+    outpipe_t *outpipe = lookup (pipe_);
+    zmq_assert (outpipe);
+    zmq_assert (!outpipe->active);
+    outpipe->active = true;
+}
+
+zmq::xrep_t::outpipe_t *zmq::xrep_t::lookup (pipe_t *pipe_)
+{
+    outpipe_t *outpipe = outpipes.find (pipe_->get_identity (),
+        pipe_->get_identity_size ());
+    if (outpipe && outpipe->pipe != pipe_)
+        return NULL;
+    return outpipe;
 }
 
 int zmq::xrep_t::xsend (msg_t *msg_, int flags_)
@@ -127,22 +125,12 @@ int zmq::xrep_t::xsend (msg_t *msg_, int flags_)
 
             //  Find the pipe associated with the identity stored in the prefix.
             //  If there's no such pipe just silently ignore the message.
-            blob_t identity ((unsigned char*) msg_->data (), msg_->size ());
-            outpipes_t::iterator it = outpipes.find (identity);
-
-            if (it != outpipes.end ()) {
-                current_out = it->second.pipe;
-                msg_t empty;
-                int rc = empty.init ();
-                errno_assert (rc == 0);
-                if (!current_out->check_write (&empty)) {
-                    it->second.active = false;
-                    more_out = false;
-                    current_out = NULL;
-                }
-                rc = empty.close ();
-                errno_assert (rc == 0);
-            }
+            //  Whether the pipe can take the message is checked once the next
+            //  part arrives, as that one tells whether the message is urgent.
+            outpipe_t *outpipe = outpipes.find (
+                (unsigned char*) msg_->data (), msg_->size ());
+            if (outpipe)
+                current_out = outpipe->pipe;
 
         }
 
@@ -156,11 +144,18 @@ int zmq::xrep_t::xsend (msg_t *msg_, int flags_)
     //  Check whether this is the last part of the message.
     more_out = msg_->flags () & msg_t::more ? true : false;
 
-    //  Push the message into the pipe. If there's no out pipe, just drop it.
+    //  Push the message into the pipe. If there's no out pipe, or if
+    //  the pipe is full, just drop it.
     if (current_out) {
         bool ok = current_out->write (msg_);
-        if (unlikely (!ok))
+        if (unlikely (!ok)) {
+            outpipe_t *outpipe = lookup (current_out);
+            if (outpipe)
+                outpipe->active = false;
             current_out = NULL;
+            int rc = msg_->close ();
+            errno_assert (rc == 0);
+        }
         else if (!more_out) {
             current_out->flush ();
             current_out = NULL;
@@ -183,10 +178,8 @@ int zmq::xrep_t::xrecv (msg_t *msg_, int flags_)
     //  if there is a prefetched identity, return it.
     if (prefetched == 2)
     {
-        int rc = msg_->init_size (prefetched_id.size ());
+        int rc = msg_->move (prefetched_id);
         errno_assert (rc == 0);
-        memcpy (msg_->data (), prefetched_id.data (), prefetched_id.size ());
-        msg_->set_flags (msg_t::more);
         prefetched = 1;
         return 0;
     }
@@ -215,24 +208,21 @@ int zmq::xrep_t::xrecv (msg_t *msg_, int flags_)
         zmq_assert (!more_in);
 
         //  Empty identity means we can preserve the auto-generated identity.
-        if (msg_->size () != 0) {
-
-            //  Actual change of the identity.
-            outpipes_t::iterator it = outpipes.begin ();
-            while (it != outpipes.end ()) {
-                if (it->second.pipe == pipe) {
-                    blob_t identity ((unsigned char*) msg_->data (),
-                        msg_->size ());
-                    pipe->set_identity (identity);
-                    outpipes.erase (it);
-                    outpipe_t outpipe = {pipe, true};
-                    outpipes.insert (outpipes_t::value_type (identity,
-                        outpipe));
-                    break;
-                }
-                ++it;
+        //  Identities that don't fit into the pipe are ignored as well.
+        if (msg_->size () != 0 && msg_->size () <= 255) {
+
+            //  Actual change of the identity. If the identity is already
+            //  used by a different peer, keep the auto-generated one.
+            outpipe_t *old = lookup (pipe);
+            zmq_assert (old);
+            outpipe_t outpipe = *old;
+            if (outpipes.insert ((unsigned char*) msg_->data (),
+                  msg_->size (), outpipe)) {
+                outpipes.erase (pipe->get_identity (),
+                    pipe->get_identity_size ());
+                pipe->set_identity ((unsigned char*) msg_->data (),
+                    msg_->size ());
             }
-            zmq_assert (it != outpipes.end ());
         }
     }
 
@@ -250,10 +240,11 @@ int zmq::xrep_t::xrecv (msg_t *msg_, int flags_)
     rc = msg_->close ();
     errno_assert (rc == 0);
 
-    blob_t identity = pipe->get_identity ();
-    rc = msg_->init_size (identity.size ());
+    //  Identities of up to max_vsm_size bytes, including all the
+    //  auto-generated ones, are stored in VSMs, so no allocation is needed.
+    rc = msg_->init_size (pipe->get_identity_size ());
     errno_assert (rc == 0);
-    memcpy (msg_->data (), identity.data (), identity.size ());
+    memcpy (msg_->data (), pipe->get_identity (), pipe->get_identity_size ());
     msg_->set_flags (msg_t::more);
     return 0;
 }
@@ -281,19 +272,13 @@ bool zmq::xrep_t::xhas_in ()
 
     //  Try to read the next message to the pre-fetch buffer. If anything,
     //  it will be identity of the peer sending the message.
-    msg_t id;
-    id.init ();
-    int rc = xrep_t::xrecv (&id, ZMQ_DONTWAIT);
-    if (rc != 0 && errno == EAGAIN) {
-        id.close ();
+    int rc = xrep_t::xrecv (&prefetched_id, ZMQ_DONTWAIT);
+    if (rc != 0 && errno == EAGAIN)
         return false;
-    }
     zmq_assert (rc == 0);
 
     //  We have first part of the message prefetched now. We will store the
     //  prefetched identity as well.
-    prefetched_id.assign ((unsigned char*) id.data (), id.size ());
-    id.close ();
     prefetched = 2;
 
     return true;
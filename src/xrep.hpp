@@ -23,14 +23,12 @@
 #ifndef __ZMQ_XREP_HPP_INCLUDED__
 #define __ZMQ_XREP_HPP_INCLUDED__
 
-#include <map>
-
 #include "socket_base.hpp"
 #include "session_base.hpp"
 #include "stdint.hpp"
-#include "blob.hpp"
 #include "msg.hpp"
 #include "fq.hpp"
+#include "idmap.hpp"
 
 namespace zmq
 {
@@ -38,7 +36,6 @@ namespace zmq
     class ctx_t;
     class pipe_t;
 
-    //  TODO: This class uses O(n) scheduling. Rewrite it to use O(1) algorithm.
     class xrep_t :
         public socket_base_t
     {
@@ -72,7 +69,7 @@ namespace zmq
         int prefetched;
 
         //  Holds the prefetched identity.
-        blob_t prefetched_id;
+        msg_t prefetched_id;
 
         //  Holds the prefetched message.
         msg_t prefetched_msg;
@@ -87,9 +84,13 @@ namespace zmq
         };
 
         //  Outbound pipes indexed by the peer IDs.
-        typedef std::map <blob_t, outpipe_t> outpipes_t;
+        typedef idmap_t <outpipe_t> outpipes_t;
         outpipes_t outpipes;
 
+        //  Returns the outbound pipe entry for the pipe. The entry is
+        //  looked up using the identity stored in the pipe itself.
+        outpipe_t *lookup (zmq::pipe_t *pipe_);
+
         //  The pipe we are currently writing to.
         zmq::pipe_t *current_out;
 
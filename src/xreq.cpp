@@ -53,6 +53,22 @@ void zmq::xreq_t::xattach_pipe (pipe_t *pipe_, bool icanhasall_)
     lb.attach (pipe_);
 }
 
+int zmq::xreq_t::xsetsockopt (int option_, const void *optval_,
+    size_t optvallen_)
+{
+    if (option_ != ZMQ_LB_STRATEGY && option_ != ZMQ_LB_KEY_SIZE) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    //  Let the generic option parser check the value, then pass it on
+    //  to the load balancer.
+    int rc = options.setsockopt (option_, optval_, optvallen_);
+    if (rc == 0)
+        lb.set_strategy (options.lb_strategy, options.lb_key_size);
+    return rc;
+}
+
 int zmq::xreq_t::xsend (msg_t *msg_, int flags_)
 {
     return lb.send (msg_, flags_);
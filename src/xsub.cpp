@@ -22,10 +22,13 @@
 #include <string.h>
 
 #include "xsub.hpp"
+#include "config.hpp"
+#include "wire.hpp"
 #include "err.hpp"
 
 zmq::xsub_t::xsub_t (class ctx_t *parent_, uint32_t tid_) :
     socket_base_t (parent_, tid_),
+    batch_pipe (NULL),
     has_message (false),
     more (false)
 {
@@ -52,8 +55,7 @@ void zmq::xsub_t::xattach_pipe (pipe_t *pipe_, bool icanhasall_)
     dist.attach (pipe_);
 
     //  Send all the cached subscriptions to the new upstream peer.
-    subscriptions.apply (send_subscription, pipe_);
-    pipe_->flush ();
+    send_subscriptions (pipe_);
 }
 
 void zmq::xsub_t::xread_activated (pipe_t *pipe_)
@@ -75,8 +77,7 @@ void zmq::xsub_t::xterminated (pipe_t *pipe_)
 void zmq::xsub_t::xhiccuped (pipe_t *pipe_)
 {
     //  Send all the cached subscriptions to the hiccuped pipe.
-    subscriptions.apply (send_subscription, pipe_);
-    pipe_->flush ();
+    send_subscriptions (pipe_);
 }
 
 int zmq::xsub_t::xsend (msg_t *msg_, int flags_)
@@ -85,11 +86,15 @@ int zmq::xsub_t::xsend (msg_t *msg_, int flags_)
     unsigned char *data = (unsigned char*) msg_->data ();
 
     // Malformed subscriptions.
-    if (size < 1 || (*data != 0 && *data != 1)) {
+    if (size < 1 || (*data != 0 && *data != 1 &&
+          *data != subscription_batch)) {
         errno = EINVAL;
         return -1;
     }
 
+    if (*data == subscription_batch)
+        return send_batch (msg_, flags_);
+
     // Process the subscription.
     if (*data == 1) {
         if (subscriptions.add (data + 1, size - 1))
@@ -200,22 +205,124 @@ bool zmq::xsub_t::match (msg_t *msg_)
     return subscriptions.check ((unsigned char*) msg_->data (), msg_->size ());
 }
 
+int zmq::xsub_t::send_batch (msg_t *msg_, int flags_)
+{
+    size_t size = msg_->size ();
+    unsigned char *data = (unsigned char*) msg_->data ();
+
+    //  Check the batch is well-formed before applying any of it.
+    size_t pos = 1;
+    while (pos != size) {
+        if (size - pos < 5 || (data [pos] != 0 && data [pos] != 1) ||
+              size - pos - 5 < get_uint32 (data + pos + 1)) {
+            errno = EINVAL;
+            return -1;
+        }
+        pos += 5 + get_uint32 (data + pos + 1);
+    }
+
+    //  Apply the subscriptions in a single pass. Only those that actually
+    //  change the set of subscriptions are passed upstream.
+    blob_t changes (1, (unsigned char) subscription_batch);
+    for (pos = 1; pos != size; pos += 5 + get_uint32 (data + pos + 1)) {
+        unsigned char *topic = data + pos + 5;
+        size_t topic_size = get_uint32 (data + pos + 1);
+        bool changed = data [pos] == 1 ?
+            subscriptions.add (topic, topic_size) :
+            subscriptions.rm (topic, topic_size);
+        if (changed)
+            changes.append (data + pos, 5 + topic_size);
+    }
+
+    int rc = msg_->close ();
+    errno_assert (rc == 0);
+    rc = msg_->init ();
+    errno_assert (rc == 0);
+
+    if (changes.size () == 1)
+        return 0;
+
+    //  Unless batching is switched on, the changes are passed upstream
+    //  one by one.
+    if (!options.subscription_batch) {
+        for (pos = 1; pos != changes.size ();) {
+            unsigned char *entry = (unsigned char*) changes.data () + pos;
+            size_t topic_size = get_uint32 (entry + 1);
+            msg_t msg;
+            rc = msg.init_size (topic_size + 1);
+            errno_assert (rc == 0);
+            unsigned char *msg_data = (unsigned char*) msg.data ();
+            msg_data [0] = entry [0];
+            memcpy (msg_data + 1, entry + 5, topic_size);
+            rc = dist.send_to_all (&msg, flags_);
+            if (rc != 0)
+                return rc;
+            pos += 5 + topic_size;
+        }
+        return 0;
+    }
+
+    msg_t msg;
+    rc = msg.init_size (changes.size ());
+    errno_assert (rc == 0);
+    memcpy (msg.data (), changes.data (), changes.size ());
+    return dist.send_to_all (&msg, flags_);
+}
+
+void zmq::xsub_t::send_subscriptions (pipe_t *pipe_)
+{
+    batch_pipe = pipe_;
+    batch.assign (1, (unsigned char) subscription_batch);
+    subscriptions.apply (send_subscription, this);
+    if (batch.size () > 1)
+        write_message (pipe_, batch);
+    batch.clear ();
+    batch_pipe = NULL;
+    pipe_->flush ();
+}
+
 void zmq::xsub_t::send_subscription (unsigned char *data_, size_t size_,
     void *arg_)
 {
-    pipe_t *pipe = (pipe_t*) arg_;
+    xsub_t *self = (xsub_t*) arg_;
+
+    //  Unless batching is switched on, each subscription is sent as
+    //  a separate message.
+    if (!self->options.subscription_batch) {
+        blob_t sub (1, 1);
+        sub.append (data_, size_);
+        write_message (self->batch_pipe, sub);
+        return;
+    }
 
-    //  Create the subsctription message.
+    //  Add the subscription to the batch.
+    unsigned char header [5];
+    header [0] = 1;
+    put_uint32 (header + 1, (uint32_t) size_);
+    self->batch.append (header, sizeof (header));
+    self->batch.append (data_, size_);
+
+    //  If the batch is large enough, send it to the pipe.
+    if (self->batch.size () >= subscription_batch_size) {
+        write_message (self->batch_pipe, self->batch);
+        self->batch.assign (1, (unsigned char) subscription_batch);
+    }
+}
+
+void zmq::xsub_t::write_message (pipe_t *pipe_, const blob_t &data_)
+{
     msg_t msg;
-    int rc = msg.init_size (size_ + 1);
-    zmq_assert (rc == 0);
-    unsigned char *data = (unsigned char*) msg.data ();
-    data [0] = 1;
-    memcpy (data + 1, data_, size_);
-
-    //  Send it to the pipe.
-    bool sent = pipe->write (&msg);
-    zmq_assert (sent);
+    int rc = msg.init_size (data_.size ());
+    errno_assert (rc == 0);
+    memcpy (msg.data (), data_.data (), data_.size ());
+
+    //  Send it to the pipe. The subscriptions are not subject to the limits
+    //  on the messages sent by the user. If the pipe is going away,
+    //  the batch is dropped.
+    if (!pipe_->write_control (&msg)) {
+        rc = msg.close ();
+        errno_assert (rc == 0);
+    }
 }
 
 zmq::xsub_session_t::xsub_session_t (io_thread_t *io_thread_, bool connect_,
@@ -23,6 +23,7 @@
 
 #include "socket_base.hpp"
 #include "session_base.hpp"
+#include "blob.hpp"
 #include "dist.hpp"
 #include "fq.hpp"
 #include "trie.hpp"
@@ -60,11 +61,22 @@ namespace zmq
         //  Check whether the message matches at least one subscription.
         bool match (zmq::msg_t *msg_);
 
-        //  Function to be applied to the trie to send all the subsciptions
-        //  upstream.
+        //  Sends all the subscriptions to the pipe, in as few batches as
+        //  possible if batching is switched on.
+        void send_subscriptions (zmq::pipe_t *pipe_);
+
+        //  Applies the batch of (un)subscriptions supplied by the user and
+        //  sends the changes upstream.
+        int send_batch (zmq::msg_t *msg_, int flags_);
+
+        //  Function to be applied to the trie to send each subscription
+        //  upstream, or to add it to the batch being sent upstream.
         static void send_subscription (unsigned char *data_, size_t size_,
             void *arg_);
 
+        //  Writes the subscription or the batch of subscriptions to the pipe.
+        static void write_message (zmq::pipe_t *pipe_, const blob_t &data_);
+
         //  Fair queueing object for inbound pipes.
         fq_t fq;
 
@@ -74,6 +86,11 @@ namespace zmq
         //  The repository of subscriptions.
         trie_t subscriptions;
 
+        //  Pipe the subscriptions are being sent to and the batch of
+        //  subscriptions that haven't been written to it yet.
+        zmq::pipe_t *batch_pipe;
+        blob_t batch;
+
         //  If true, 'message' contains a matching message to return on the
         //  next recv call.
         bool has_message;
@@ -40,8 +40,10 @@ namespace zmq
     {
     public:
 
-        //  Initialises the pipe.
-        inline ypipe_t ()
+        //  Initialises the pipe. If the pool is specified, the memory chunks
+        //  are borrowed from it.
+        inline ypipe_t (chunk_pool_t *pool_ = NULL) :
+            queue (pool_)
         {
             //  Insert terminator element into the queue.
             queue.push ();
@@ -149,6 +151,14 @@ namespace zmq
             return true;
         }
 
+        //  Returns true if there's a value already prefetched by the reader.
+        //  Unlike check_read it never touches the shared pointer and thus
+        //  never marks the reader as asleep.
+        inline bool prefetched ()
+        {
+            return &queue.front () != r && r;
+        }
+
         //  Reads an item from the pipe. Returns false if there is no value.
         //  available.
         inline bool read (T *value_)
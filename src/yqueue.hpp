@@ -27,6 +27,7 @@
 
 #include "err.hpp"
 #include "atomic_ptr.hpp"
+#include "chunk_pool.hpp"
 
 namespace zmq
 {
@@ -43,16 +44,19 @@ namespace zmq
     //  T is the type of the object in the queue.
     //  N is granularity of the queue (how many pushes have to be done till
     //  actual memory allocation is required).
+    //
+    //  Optionally, chunks can be borrowed from and returned to a pool shared
+    //  with other queues.
 
     template <typename T, int N> class yqueue_t
     {
     public:
 
         //  Create the queue.
-        inline yqueue_t ()
+        inline yqueue_t (chunk_pool_t *pool_ = NULL) :
+            pool (pool_)
         {
-             begin_chunk = (chunk_t*) malloc (sizeof (chunk_t));
-             alloc_assert (begin_chunk);
+             begin_chunk = alloc_chunk ();
              begin_pos = 0;
              back_chunk = NULL;
              back_pos = 0;
@@ -65,17 +69,17 @@ namespace zmq
         {
             while (true) {
                 if (begin_chunk == end_chunk) {
-                    free (begin_chunk);
+                    free_chunk (begin_chunk);
                     break;
                 } 
                 chunk_t *o = begin_chunk;
                 begin_chunk = begin_chunk->next;
-                free (o);
+                free_chunk (o);
             }
 
             chunk_t *sc = spare_chunk.xchg (NULL);
             if (sc)
-                free (sc);
+                free_chunk (sc);
         }
 
         //  Returns reference to the front element of the queue.
@@ -106,8 +110,7 @@ namespace zmq
                 end_chunk->next = sc;
                 sc->prev = end_chunk;
             } else {
-                end_chunk->next = (chunk_t*) malloc (sizeof (chunk_t));
-                alloc_assert (end_chunk->next);
+                end_chunk->next = alloc_chunk ();
                 end_chunk->next->prev = end_chunk;
             }
             end_chunk = end_chunk->next;
@@ -140,7 +143,7 @@ namespace zmq
             else {
                 end_pos = N - 1;
                 end_chunk = end_chunk->prev;
-                free (end_chunk->next);
+                free_chunk (end_chunk->next);
                 end_chunk->next = NULL;
             }
         }
@@ -159,7 +162,7 @@ namespace zmq
                 //  use 'o' as the spare.
                 chunk_t *cs = spare_chunk.xchg (o);
                 if (cs)
-                    free (cs);
+                    free_chunk (cs);
             }
         }
 
@@ -173,6 +176,23 @@ namespace zmq
              chunk_t *next;
         };
 
+        inline chunk_t *alloc_chunk ()
+        {
+            if (pool)
+                return (chunk_t*) pool->alloc (sizeof (chunk_t));
+            chunk_t *chunk = (chunk_t*) malloc (sizeof (chunk_t));
+            alloc_assert (chunk);
+            return chunk;
+        }
+
+        inline void free_chunk (chunk_t *chunk_)
+        {
+            if (pool)
+                pool->release (chunk_, sizeof (chunk_t));
+            else
+                free (chunk_);
+        }
+
         //  Back position may point to invalid memory if the queue is empty,
         //  while begin & end positions are always valid. Begin position is
         //  accessed exclusively be queue reader (front/pop), while back and
@@ -189,6 +209,10 @@ namespace zmq
         //  us from having to call malloc/free.
         atomic_ptr_t<chunk_t> spare_chunk;
 
+        //  Pool to borrow the chunks from, NULL if they are allocated
+        //  directly.
+        chunk_pool_t *pool;
+
         //  Disable copying of yqueue.
         yqueue_t (const yqueue_t&);
         const yqueue_t &operator = (const yqueue_t&);
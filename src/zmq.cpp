@@ -79,6 +79,8 @@ struct iovec
 #include "err.hpp"
 #include "msg.hpp"
 #include "fd.hpp"
+#include "proxy.hpp"
+#include "io_thread.hpp"
 
 #if !defined ZMQ_HAVE_WINDOWS
 #include <unistd.h>
@@ -180,6 +182,25 @@ void *zmq_init_thread_safe (int io_threads_)
   return (void*) ctx;
 }
 
+int zmq_ctx_set (void *ctx_, int option_, const void *optval_,
+    size_t optvallen_)
+{
+    if (!ctx_ || !((zmq::ctx_t*) ctx_)->check_tag ()) {
+        errno = EFAULT;
+        return -1;
+    }
+    return ((zmq::ctx_t*) ctx_)->set (option_, optval_, optvallen_);
+}
+
+int zmq_ctx_get (void *ctx_, int option_, void *optval_, size_t *optvallen_)
+{
+    if (!ctx_ || !((zmq::ctx_t*) ctx_)->check_tag ()) {
+        errno = EFAULT;
+        return -1;
+    }
+    return ((zmq::ctx_t*) ctx_)->get (option_, optval_, optvallen_);
+}
+
 int zmq_term (void *ctx_)
 {
     if (!ctx_ || !((zmq::ctx_t*) ctx_)->check_tag ()) {
@@ -560,6 +581,60 @@ int zmq_getmsgopt (zmq_msg_t *msg_, int option_, void *optval_,
     }
 }
 
+// Built-in proxy.
+
+void *zmq_proxy_start (void *frontend_, void *backend_, void *capture_)
+{
+    if (!frontend_ || !((zmq::socket_base_t*) frontend_)->check_tag () ||
+          !backend_ || !((zmq::socket_base_t*) backend_)->check_tag () ||
+          (capture_ && !((zmq::socket_base_t*) capture_)->check_tag ())) {
+        errno = ENOTSOCK;
+        return NULL;
+    }
+    if (frontend_ == backend_ || frontend_ == capture_ ||
+          backend_ == capture_) {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    //  The proxy runs in one of the I/O threads of the context.
+    zmq::socket_base_t *frontend = (zmq::socket_base_t*) frontend_;
+    zmq::io_thread_t *io_thread = frontend->get_ctx ()->choose_io_thread (0);
+    if (!io_thread) {
+        errno = EMTHREAD;
+        return NULL;
+    }
+
+    zmq::proxy_t *proxy = new (std::nothrow) zmq::proxy_t (io_thread,
+        frontend, (zmq::socket_base_t*) backend_,
+        (zmq::socket_base_t*) capture_);
+    alloc_assert (proxy);
+    proxy->start ();
+    return (void*) proxy;
+}
+
+int zmq_proxy_getstat (void *proxy_, int stat_, void *value_,
+    size_t *valuelen_)
+{
+    if (!proxy_) {
+        errno = EFAULT;
+        return -1;
+    }
+    return ((zmq::proxy_t*) proxy_)->getstat (stat_, value_, valuelen_);
+}
+
+int zmq_proxy_stop (void *proxy_)
+{
+    if (!proxy_) {
+        errno = EFAULT;
+        return -1;
+    }
+    zmq::proxy_t *proxy = (zmq::proxy_t*) proxy_;
+    proxy->stop ();
+    delete proxy;
+    return 0;
+}
+
 // Polling.
 
 int zmq_poll (zmq_pollitem_t *items_, int nitems_, long timeout_)
@@ -0,0 +1,112 @@
+/*
+    Copyright (c) 2009-2011 250bpm s.r.o.
+    Copyright (c) 2007-2011 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "testutil.hpp"
+#include "../src/stdint.hpp"
+
+static int64_t cached (void *ctx)
+{
+    int64_t value;
+    size_t value_size = sizeof (value);
+    int rc = zmq_ctx_get (ctx, ZMQ_CTX_CHUNK_CACHED, &value, &value_size);
+    assert (rc == 0);
+    return value;
+}
+
+int main (int argc, char *argv [])
+{
+    fprintf (stderr, "test_chunk_cache running...\n");
+
+    void *ctx = zmq_init (1);
+    assert (ctx);
+
+    int64_t limit = -1;
+    int rc = zmq_ctx_set (ctx, ZMQ_CTX_CHUNK_CACHE, &limit, sizeof (limit));
+    assert (rc == -1 && errno == EINVAL);
+    size_t limit_size = sizeof (limit);
+    rc = zmq_ctx_get (ctx, ZMQ_CTX_CHUNK_CACHE, &limit, &limit_size);
+    assert (rc == 0);
+    assert (limit == 0);
+    assert (cached (ctx) == 0);
+
+    //  The cache is off by default. It has to be switched on before
+    //  the message queues are created.
+    limit = 4 * 1024 * 1024;
+    rc = zmq_ctx_set (ctx, ZMQ_CTX_CHUNK_CACHE, &limit, sizeof (limit));
+    assert (rc == 0);
+
+    void *sb = zmq_socket (ctx, ZMQ_PULL);
+    assert (sb);
+    int hwm = 0;
+    rc = zmq_setsockopt (sb, ZMQ_RCVHWM, &hwm, sizeof (hwm));
+    assert (rc == 0);
+    rc = zmq_bind (sb, "inproc://a");
+    assert (rc == 0);
+    void *sc = zmq_socket (ctx, ZMQ_PUSH);
+    assert (sc);
+    rc = zmq_setsockopt (sc, ZMQ_SNDHWM, &hwm, sizeof (hwm));
+    assert (rc == 0);
+    rc = zmq_connect (sc, "inproc://a");
+    assert (rc == 0);
+
+    //  A burst of messages grows the queue by several chunks. Once the
+    //  queue is drained, the chunks end up in the cache.
+    for (int i = 0; i != 10000; i++) {
+        rc = zmq_send (sc, "x", 1, 0);
+        assert (rc == 1);
+    }
+    char buf [1];
+    for (int i = 0; i != 10000; i++) {
+        rc = zmq_recv (sb, buf, sizeof (buf), 0);
+        assert (rc == 1);
+    }
+    int64_t after_burst = cached (ctx);
+    assert (after_burst > 0);
+
+    //  Next burst is served from the cache.
+    for (int i = 0; i != 1000; i++) {
+        rc = zmq_send (sc, "x", 1, 0);
+        assert (rc == 1);
+    }
+    assert (cached (ctx) < after_burst);
+    for (int i = 0; i != 1000; i++) {
+        rc = zmq_recv (sb, buf, sizeof (buf), 0);
+        assert (rc == 1);
+    }
+
+    //  Lowering the limit releases the cached memory.
+    limit = 0;
+    rc = zmq_ctx_set (ctx, ZMQ_CTX_CHUNK_CACHE, &limit, sizeof (limit));
+    assert (rc == 0);
+    assert (cached (ctx) == 0);
+
+    rc = zmq_close (sc);
+    assert (rc == 0);
+    rc = zmq_close (sb);
+    assert (rc == 0);
+    rc = zmq_term (ctx);
+    assert (rc == 0);
+
+    return 0 ;
+}
@@ -0,0 +1,93 @@
+/*
+    Copyright (c) 2009-2011 250bpm s.r.o.
+    Copyright (c) 2007-2011 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "testutil.hpp"
+#include "../src/stdint.hpp"
+
+static int64_t ctx_stat (void *ctx, int option)
+{
+    int64_t value;
+    size_t value_size = sizeof (value);
+    int rc = zmq_ctx_get (ctx, option, &value, &value_size);
+    assert (rc == 0);
+    return value;
+}
+
+int main (int argc, char *argv [])
+{
+    fprintf (stderr, "test_command_batch running...\n");
+
+    void *ctx = zmq_init (1);
+    assert (ctx);
+    assert (ctx_stat (ctx, ZMQ_CTX_COMMANDS_SAVED) == 0);
+    assert (ctx_stat (ctx, ZMQ_CTX_SIGNALS_SAVED) == 0);
+
+    //  Statistics are read-only.
+    int64_t value = 0;
+    int rc = zmq_ctx_set (ctx, ZMQ_CTX_COMMANDS_SAVED, &value, sizeof (value));
+    assert (rc == -1 && errno == EINVAL);
+
+    //  With memory budget in place, the pipe is acknowledged each time
+    //  the reader drains it, in addition to the regular acknowledgements.
+    int64_t limit = 100000000;
+    rc = zmq_ctx_set (ctx, ZMQ_CTX_MEMORY_LIMIT, &limit, sizeof (limit));
+    assert (rc == 0);
+
+    void *sb = zmq_socket (ctx, ZMQ_PULL);
+    assert (sb);
+    rc = zmq_bind (sb, "tcp://127.0.0.1:5581");
+    assert (rc == 0);
+
+    //  The session reading more messages from the pipe than the low
+    //  watermark per batch it passes to the network acknowledges them
+    //  several times. The acknowledgements are coalesced.
+    void *sc = zmq_socket (ctx, ZMQ_PUSH);
+    assert (sc);
+    int hwm = 100;
+    rc = zmq_setsockopt (sc, ZMQ_SNDHWM, &hwm, sizeof (hwm));
+    assert (rc == 0);
+    rc = zmq_connect (sc, "tcp://127.0.0.1:5581");
+    assert (rc == 0);
+
+    for (int i = 0; i != 10000; i++) {
+        rc = zmq_send (sc, "x", 1, 0);
+        assert (rc == 1);
+    }
+    char buf [1];
+    for (int i = 0; i != 10000; i++) {
+        rc = zmq_recv (sb, buf, sizeof (buf), 0);
+        assert (rc == 1);
+    }
+    assert (ctx_stat (ctx, ZMQ_CTX_COMMANDS_SAVED) > 0);
+    assert (ctx_stat (ctx, ZMQ_CTX_SIGNALS_SAVED) >= 0);
+
+    rc = zmq_close (sc);
+    assert (rc == 0);
+    rc = zmq_close (sb);
+    assert (rc == 0);
+    rc = zmq_term (ctx);
+    assert (rc == 0);
+
+    return 0 ;
+}
@@ -0,0 +1,124 @@
+/*
+    Copyright (c) 2009-2011 250bpm s.r.o.
+    Copyright (c) 2007-2011 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include "testutil.hpp"
+#include "../src/stdint.hpp"
+
+static uint64_t sock_stat (void *s, int option)
+{
+    uint64_t value;
+    size_t value_size = sizeof (value);
+    int rc = zmq_getsockopt (s, option, &value, &value_size);
+    assert (rc == 0);
+    return value;
+}
+
+//  Fills the buffer with text that compresses well if compressible is set,
+//  with pseudo-random data otherwise.
+static void fill (char *buf, size_t size, int seed, bool compressible)
+{
+    static const char text [] = "The quick brown fox jumps over the lazy dog";
+    uint32_t x = seed * 2654435761U + 1;
+    for (size_t i = 0; i != size; i++) {
+        if (compressible)
+            buf [i] = text [(i + seed) % (sizeof (text) - 1)];
+        else {
+            x = x * 1103515245 + 12345;
+            buf [i] = (char) (x >> 16);
+        }
+    }
+}
+
+int main (int argc, char *argv [])
+{
+    fprintf (stderr, "test_compression running...\n");
+
+    void *ctx = zmq_init (1);
+    assert (ctx);
+
+    void *sb = zmq_socket (ctx, ZMQ_PAIR);
+    assert (sb);
+    int codec = 2;
+    int rc = zmq_setsockopt (sb, ZMQ_COMPRESSION, &codec, sizeof (codec));
+    assert (rc == -1 && errno == EINVAL);
+    rc = zmq_bind (sb, "tcp://127.0.0.1:5582");
+    assert (rc == 0);
+
+    //  Only the connecting peer compresses the data it sends. The data
+    //  it receives are not compressed.
+    void *sc = zmq_socket (ctx, ZMQ_PAIR);
+    assert (sc);
+    codec = ZMQ_COMPRESSION_LZ;
+    rc = zmq_setsockopt (sc, ZMQ_COMPRESSION, &codec, sizeof (codec));
+    assert (rc == 0);
+    codec = 0;
+    size_t codec_size = sizeof (codec);
+    rc = zmq_getsockopt (sc, ZMQ_COMPRESSION, &codec, &codec_size);
+    assert (rc == 0 && codec == ZMQ_COMPRESSION_LZ);
+    rc = zmq_connect (sc, "tcp://127.0.0.1:5582");
+    assert (rc == 0);
+
+    bounce (sb, sc);
+
+    //  Pass messages of various sizes, both compressible and not, in both
+    //  directions. Some of them span several compressed blocks.
+    static char buf [100000];
+    static char expected [100000];
+    for (int round = 0; round != 10; round++) {
+        void *from = round % 2 ? sb : sc;
+        void *to = round % 2 ? sc : sb;
+        for (int i = 0; i != 500; i++) {
+            size_t size = (i * 7919) % (round < 8 ? 2000 : sizeof (buf));
+            fill (buf, size, i, i % 3 != 0);
+            rc = zmq_send (from, buf, size, 0);
+            assert (rc == (int) size);
+        }
+        for (int i = 0; i != 500; i++) {
+            size_t size = (i * 7919) % (round < 8 ? 2000 : sizeof (buf));
+            fill (expected, size, i, i % 3 != 0);
+            rc = zmq_recv (to, buf, sizeof (buf), 0);
+            assert (rc == (int) size);
+            assert (memcmp (buf, expected, size) == 0);
+        }
+    }
+
+    bounce (sc, sb);
+
+    //  The compressing peer accounts the data it compressed.
+    uint64_t raw = sock_stat (sc, ZMQ_COMPRESSION_RAW_BYTES);
+    uint64_t wire = sock_stat (sc, ZMQ_COMPRESSION_WIRE_BYTES);
+    assert (raw > 0 && wire > 0 && wire < raw);
+    assert (sock_stat (sb, ZMQ_COMPRESSION_RAW_BYTES) == 0);
+    assert (sock_stat (sb, ZMQ_COMPRESSION_WIRE_BYTES) == 0);
+
+    rc = zmq_close (sc);
+    assert (rc == 0);
+
+    rc = zmq_close (sb);
+    assert (rc == 0);
+
+    rc = zmq_term (ctx);
+    assert (rc == 0);
+
+    return 0 ;
+}
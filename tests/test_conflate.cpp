@@ -0,0 +1,173 @@
+/*
+    Copyright (c) 2010-2011 250bpm s.r.o.
+    Copyright (c) 2010-2011 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "testutil.hpp"
+#include "../include/zmq_utils.h"
+
+static void expect (void *s, const char *content)
+{
+    char buf [32];
+    int rc = zmq_recv (s, buf, sizeof (buf), 0);
+    assert (rc == (int) strlen (content));
+    assert (memcmp (buf, content, rc) == 0);
+}
+
+int main (int argc, char *argv [])
+{
+    fprintf (stderr, "test_conflate running...\n");
+
+    void *ctx = zmq_init (1);
+    assert (ctx);
+
+    //  Create publisher and subscriber, each with high watermark of 1. Thus
+    //  the pipe between them can hold 2 messages.
+    void *pub = zmq_socket (ctx, ZMQ_PUB);
+    assert (pub);
+    int hwm = 1;
+    int rc = zmq_setsockopt (pub, ZMQ_SNDHWM, &hwm, sizeof (hwm));
+    assert (rc == 0);
+    rc = zmq_bind (pub, "inproc://a");
+    assert (rc == 0);
+
+    //  Conflate the messages using the first byte as a topic.
+    void *sub = zmq_socket (ctx, ZMQ_SUB);
+    assert (sub);
+    rc = zmq_setsockopt (sub, ZMQ_RCVHWM, &hwm, sizeof (hwm));
+    assert (rc == 0);
+    int conflate = 1;
+    rc = zmq_setsockopt (sub, ZMQ_CONFLATE, &conflate, sizeof (conflate));
+    assert (rc == 0);
+    rc = zmq_setsockopt (sub, ZMQ_SUBSCRIBE, "", 0);
+    assert (rc == 0);
+    rc = zmq_connect (sub, "inproc://a");
+    assert (rc == 0);
+
+    //  Conflation is not available for other socket types.
+    void *push = zmq_socket (ctx, ZMQ_PUSH);
+    assert (push);
+    rc = zmq_setsockopt (push, ZMQ_CONFLATE, &conflate, sizeof (conflate));
+    assert (rc == -1 && errno == EINVAL);
+    rc = zmq_close (push);
+    assert (rc == 0);
+
+    //  First two messages fit into the pipe. Subsequent messages are
+    //  conflated, only the latest message for each topic being kept.
+    const char *msgs [] = {"A1", "B1", "A2", "B2", "A3", "C1"};
+    for (int i = 0; i != 6; i++) {
+        rc = zmq_send (pub, msgs [i], 2, ZMQ_DONTWAIT);
+        assert (rc == 2);
+    }
+
+    //  The conflated messages are passed on as the subscriber reads,
+    //  without the publisher having to do anything.
+    expect (sub, "A1");
+    expect (sub, "B1");
+    expect (sub, "A3");
+    expect (sub, "B2");
+    expect (sub, "C1");
+
+    //  There's nothing more to receive.
+    char buf [32];
+    rc = zmq_recv (sub, buf, sizeof (buf), ZMQ_DONTWAIT);
+    assert (rc == -1 && errno == EAGAIN);
+
+    //  Unfinished message doesn't replace the latest value of its topic.
+    //  The pipe holds two messages at most, so "A1" is conflated.
+    rc = zmq_send (pub, "X1", 2, 0);
+    assert (rc == 2);
+    rc = zmq_send (pub, "Y1", 2, 0);
+    assert (rc == 2);
+    rc = zmq_send (pub, "A1", 2, 0);
+    assert (rc == 2);
+    rc = zmq_send (pub, "A2", 2, ZMQ_SNDMORE);
+    assert (rc == 2);
+
+    //  Messages are delivered even though the publisher is closed.
+    rc = zmq_close (pub);
+    assert (rc == 0);
+
+    expect (sub, "X1");
+    expect (sub, "Y1");
+    expect (sub, "A1");
+
+    rc = zmq_close (sub);
+    assert (rc == 0);
+
+    //  Publisher that goes idle after conflating the messages over TCP.
+    pub = zmq_socket (ctx, ZMQ_PUB);
+    assert (pub);
+    hwm = 2;
+    rc = zmq_setsockopt (pub, ZMQ_SNDHWM, &hwm, sizeof (hwm));
+    assert (rc == 0);
+    rc = zmq_setsockopt (pub, ZMQ_CONFLATE, &conflate, sizeof (conflate));
+    assert (rc == 0);
+    rc = zmq_bind (pub, "tcp://127.0.0.1:5583");
+    assert (rc == 0);
+
+    sub = zmq_socket (ctx, ZMQ_SUB);
+    assert (sub);
+    rc = zmq_setsockopt (sub, ZMQ_RCVHWM, &hwm, sizeof (hwm));
+    assert (rc == 0);
+    rc = zmq_setsockopt (sub, ZMQ_SUBSCRIBE, "", 0);
+    assert (rc == 0);
+    rc = zmq_connect (sub, "tcp://127.0.0.1:5583");
+    assert (rc == 0);
+    zmq_sleep (1);
+
+    //  Publish two values for each of 20 topics.
+    for (int i = 0; i != 40; i++) {
+        char msg [2] = {(char) ('a' + i % 20), (char) ('1' + i / 20)};
+        rc = zmq_send (pub, msg, 2, 0);
+        assert (rc == 2);
+    }
+
+    //  Each topic is received, the latest value at the end.
+    bool seen [20];
+    memset (seen, 0, sizeof (seen));
+    int timeout = 1000;
+    rc = zmq_setsockopt (sub, ZMQ_RCVTIMEO, &timeout, sizeof (timeout));
+    assert (rc == 0);
+    while (true) {
+        rc = zmq_recv (sub, buf, sizeof (buf), 0);
+        if (rc == -1) {
+            assert (errno == EAGAIN);
+            break;
+        }
+        assert (rc == 2 && buf [0] >= 'a' && buf [0] < 'a' + 20);
+        seen [buf [0] - 'a'] = buf [1] == '2';
+    }
+    for (int i = 0; i != 20; i++)
+        assert (seen [i]);
+
+    rc = zmq_close (sub);
+    assert (rc == 0);
+
+    rc = zmq_close (pub);
+    assert (rc == 0);
+
+    rc = zmq_term (ctx);
+    assert (rc == 0);
+
+    return 0;
+}
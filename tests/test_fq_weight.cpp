@@ -0,0 +1,103 @@
+/*
+    Copyright (c) 2010-2011 250bpm s.r.o.
+    Copyright (c) 2010-2011 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <assert.h>
+#include <stdio.h>
+
+#include "testutil.hpp"
+
+int main (int argc, char *argv [])
+{
+    fprintf (stderr, "test_fq_weight running...\n");
+
+    void *ctx = zmq_init (1);
+    assert (ctx);
+
+    void *heavy = zmq_socket (ctx, ZMQ_PUSH);
+    assert (heavy);
+    int rc = zmq_bind (heavy, "inproc://heavy");
+    assert (rc == 0);
+
+    void *light = zmq_socket (ctx, ZMQ_PUSH);
+    assert (light);
+    rc = zmq_bind (light, "inproc://light");
+    assert (rc == 0);
+
+    //  Zero weight is invalid.
+    void *pull = zmq_socket (ctx, ZMQ_PULL);
+    assert (pull);
+    int weight = 0;
+    rc = zmq_setsockopt (pull, ZMQ_FQ_WEIGHT, &weight, sizeof (weight));
+    assert (rc == -1 && errno == EINVAL);
+
+    //  The weight applies to the connections created afterwards.
+    weight = 3;
+    rc = zmq_setsockopt (pull, ZMQ_FQ_WEIGHT, &weight, sizeof (weight));
+    assert (rc == 0);
+    rc = zmq_connect (pull, "inproc://heavy");
+    assert (rc == 0);
+    weight = 1;
+    rc = zmq_setsockopt (pull, ZMQ_FQ_WEIGHT, &weight, sizeof (weight));
+    assert (rc == 0);
+    weight = 0;
+    size_t weight_size = sizeof (weight);
+    rc = zmq_getsockopt (pull, ZMQ_FQ_WEIGHT, &weight, &weight_size);
+    assert (rc == 0);
+    assert (weight == 1);
+    rc = zmq_connect (pull, "inproc://light");
+    assert (rc == 0);
+
+    for (int i = 0; i != 40; i++) {
+        rc = zmq_send (heavy, "H", 1, 0);
+        assert (rc == 1);
+        rc = zmq_send (light, "L", 1, 0);
+        assert (rc == 1);
+    }
+
+    //  While both peers have messages available, the heavy one gets three
+    //  times as many turns as the light one.
+    int heavy_count = 0;
+    for (int i = 0; i != 40; i++) {
+        char buf [1];
+        rc = zmq_recv (pull, buf, sizeof (buf), 0);
+        assert (rc == 1);
+        if (buf [0] == 'H')
+            heavy_count++;
+    }
+    assert (heavy_count == 30);
+
+    //  The rest of the messages is still delivered.
+    int count = 40;
+    while (zmq_recv (pull, NULL, 0, ZMQ_DONTWAIT) == 1)
+        count++;
+    assert (count == 80);
+
+    rc = zmq_close (pull);
+    assert (rc == 0);
+    rc = zmq_close (light);
+    assert (rc == 0);
+    rc = zmq_close (heavy);
+    assert (rc == 0);
+
+    rc = zmq_term (ctx);
+    assert (rc == 0);
+
+    return 0 ;
+}
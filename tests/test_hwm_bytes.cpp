@@ -0,0 +1,184 @@
+/*
+    Copyright (c) 2010-2011 250bpm s.r.o.
+    Copyright (c) 2010-2011 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "testutil.hpp"
+#include "../src/stdint.hpp"
+
+//  Returns the number of subscriptions in the message received from XPUB,
+//  which is either a single subscription or a batch of them.
+static int count_subscriptions (const unsigned char *data_, size_t size_)
+{
+    if (size_ == 0 || data_ [0] != 2)
+        return 1;
+    int count = 0;
+    size_t pos = 1;
+    while (pos != size_) {
+        assert (size_ - pos >= 5);
+        size_t topic_size = ((size_t) data_ [pos + 1] << 24) |
+            ((size_t) data_ [pos + 2] << 16) |
+            ((size_t) data_ [pos + 3] << 8) | data_ [pos + 4];
+        assert (size_ - pos - 5 >= topic_size);
+        pos += 5 + topic_size;
+        count++;
+    }
+    return count;
+}
+
+int main (int argc, char *argv [])
+{
+    fprintf (stderr, "test_hwm_bytes running...\n");
+
+    void *ctx = zmq_init (1);
+    assert (ctx);
+
+    //  Create pair of sockets, each with high watermark of 1000 bytes and
+    //  no limit on number of messages. Thus the total buffer space should
+    //  be 2000 bytes.
+    void *sb = zmq_socket (ctx, ZMQ_PULL);
+    assert (sb);
+    int hwm = 0;
+    int rc = zmq_setsockopt (sb, ZMQ_RCVHWM, &hwm, sizeof (hwm));
+    assert (rc == 0);
+    int64_t hwm_bytes = -1;
+    rc = zmq_setsockopt (sb, ZMQ_RCVHWM_BYTES, &hwm_bytes, sizeof (hwm_bytes));
+    assert (rc == -1 && errno == EINVAL);
+    hwm_bytes = 1000;
+    rc = zmq_setsockopt (sb, ZMQ_RCVHWM_BYTES, &hwm_bytes, sizeof (hwm_bytes));
+    assert (rc == 0);
+    rc = zmq_bind (sb, "inproc://a");
+    assert (rc == 0);
+
+    void *sc = zmq_socket (ctx, ZMQ_PUSH);
+    assert (sc);
+    rc = zmq_setsockopt (sc, ZMQ_SNDHWM, &hwm, sizeof (hwm));
+    assert (rc == 0);
+    rc = zmq_setsockopt (sc, ZMQ_SNDHWM_BYTES, &hwm_bytes, sizeof (hwm_bytes));
+    assert (rc == 0);
+    hwm_bytes = 0;
+    size_t hwm_bytes_size = sizeof (hwm_bytes);
+    rc = zmq_getsockopt (sc, ZMQ_SNDHWM_BYTES, &hwm_bytes, &hwm_bytes_size);
+    assert (rc == 0);
+    assert (hwm_bytes == 1000);
+    rc = zmq_connect (sc, "inproc://a");
+    assert (rc == 0);
+
+    //  Try to send 30 messages of 100 bytes. Only 20 should succeed.
+    char buf [5000];
+    memset (buf, 0, sizeof (buf));
+    for (int i = 0; i < 30; i++)
+    {
+        int rc = zmq_send (sc, buf, 100, ZMQ_DONTWAIT);
+        if (i < 20)
+            assert (rc == 100);
+        else
+            assert (rc < 0 && errno == EAGAIN);
+    }
+
+    //  Consume the pending messages.
+    for (int i = 0; i != 20; i++) {
+        rc = zmq_recv (sb, buf, sizeof (buf), 0);
+        assert (rc == 100);
+    }
+
+    //  Once the space is freed, a message larger than the limit still gets
+    //  through, but nothing can follow it.
+    rc = zmq_send (sc, buf, 5000, 0);
+    assert (rc == 5000);
+    rc = zmq_send (sc, buf, 1, ZMQ_DONTWAIT);
+    assert (rc < 0 && errno == EAGAIN);
+    rc = zmq_recv (sb, buf, sizeof (buf), 0);
+    assert (rc == 5000);
+
+    //  Multi-part message is accounted as a whole. If the first part fits,
+    //  the rest of the message can be written even beyond the limit.
+    for (int i = 0; i != 19; i++) {
+        rc = zmq_send (sc, buf, 100, 0);
+        assert (rc == 100);
+    }
+    for (int i = 0; i != 3; i++) {
+        rc = zmq_send (sc, buf, 100, ZMQ_DONTWAIT | (i < 2 ? ZMQ_SNDMORE : 0));
+        assert (rc == 100);
+    }
+    rc = zmq_send (sc, buf, 100, ZMQ_DONTWAIT);
+    assert (rc < 0 && errno == EAGAIN);
+
+    for (int i = 0; i != 22; i++) {
+        rc = zmq_recv (sb, buf, sizeof (buf), 0);
+        assert (rc == 100);
+    }
+
+    //  Now it should be possible to send one more.
+    rc = zmq_send (sc, buf, 100, 0);
+    assert (rc == 100);
+    rc = zmq_recv (sb, buf, sizeof (buf), 0);
+    assert (rc == 100);
+
+    rc = zmq_close (sc);
+    assert (rc == 0);
+
+    rc = zmq_close (sb);
+    assert (rc == 0);
+
+    //  Subscriptions replayed to a new peer are not limited by the byte
+    //  limit, even though they take several times the limit.
+    void *xsub = zmq_socket (ctx, ZMQ_XSUB);
+    assert (xsub);
+    hwm_bytes = 1000;
+    rc = zmq_setsockopt (xsub, ZMQ_SNDHWM_BYTES, &hwm_bytes,
+        sizeof (hwm_bytes));
+    assert (rc == 0);
+    for (int i = 0; i != 3000; i++) {
+        buf [0] = 1;
+        int size = sprintf (buf + 1, "topic%d", i);
+        rc = zmq_send (xsub, buf, size + 1, 0);
+        assert (rc == size + 1);
+    }
+
+    void *xpub = zmq_socket (ctx, ZMQ_XPUB);
+    assert (xpub);
+    rc = zmq_bind (xpub, "inproc://b");
+    assert (rc == 0);
+    rc = zmq_connect (xsub, "inproc://b");
+    assert (rc == 0);
+
+    int subscriptions = 0;
+    unsigned char subs [16384];
+    while (subscriptions < 3000) {
+        rc = zmq_recv (xpub, subs, sizeof (subs), 0);
+        assert (rc > 0 && rc <= (int) sizeof (subs));
+        subscriptions += count_subscriptions (subs, rc);
+    }
+    assert (subscriptions == 3000);
+
+    rc = zmq_close (xpub);
+    assert (rc == 0);
+
+    rc = zmq_close (xsub);
+    assert (rc == 0);
+
+    rc = zmq_term (ctx);
+    assert (rc == 0);
+
+	return 0;
+}
@@ -0,0 +1,115 @@
+/*
+    Copyright (c) 2010-2011 250bpm s.r.o.
+    Copyright (c) 2010-2011 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "testutil.hpp"
+
+static void expect (void *s, const char *content, bool more_)
+{
+    char buf [32];
+    int rc = zmq_recv (s, buf, sizeof (buf), 0);
+    assert (rc == (int) strlen (content));
+    assert (memcmp (buf, content, rc) == 0);
+    int more;
+    size_t more_size = sizeof (more);
+    rc = zmq_getsockopt (s, ZMQ_RCVMORE, &more, &more_size);
+    assert (rc == 0);
+    assert (more_ == (more != 0));
+}
+
+static void process_commands (void *s)
+{
+    int events;
+    size_t events_size = sizeof (events);
+    int rc = zmq_getsockopt (s, ZMQ_EVENTS, &events, &events_size);
+    assert (rc == 0);
+}
+
+int main (int argc, char *argv [])
+{
+    fprintf (stderr, "test_last_value_cache running...\n");
+
+    void *ctx = zmq_init (1);
+    assert (ctx);
+
+    //  Create publisher caching the messages by the first byte.
+    void *pub = zmq_socket (ctx, ZMQ_PUB);
+    assert (pub);
+    int lvc = 1;
+    int rc = zmq_setsockopt (pub, ZMQ_LAST_VALUE_CACHE, &lvc, sizeof (lvc));
+    assert (rc == 0);
+    rc = zmq_bind (pub, "inproc://a");
+    assert (rc == 0);
+
+    //  Subscribers cannot cache the messages.
+    void *sub = zmq_socket (ctx, ZMQ_SUB);
+    assert (sub);
+    rc = zmq_setsockopt (sub, ZMQ_LAST_VALUE_CACHE, &lvc, sizeof (lvc));
+    assert (rc == -1 && errno == EINVAL);
+
+    //  Publish some messages while there's no subscriber.
+    rc = zmq_send (pub, "A1", 2, 0);
+    assert (rc == 2);
+    rc = zmq_send (pub, "B1", 2, 0);
+    assert (rc == 2);
+    rc = zmq_send (pub, "A2", 2, 0);
+    assert (rc == 2);
+    rc = zmq_send (pub, "C1", 2, ZMQ_SNDMORE);
+    assert (rc == 2);
+    rc = zmq_send (pub, "body", 4, 0);
+    assert (rc == 4);
+
+    //  Late subscriber gets the latest value for the topic straight away.
+    rc = zmq_setsockopt (sub, ZMQ_SUBSCRIBE, "A", 1);
+    assert (rc == 0);
+    rc = zmq_connect (sub, "inproc://a");
+    assert (rc == 0);
+    process_commands (pub);
+    expect (sub, "A2", false);
+
+    //  Same applies to the subsequent subscriptions, including multi-part
+    //  messages and subscriptions longer than the topic.
+    rc = zmq_setsockopt (sub, ZMQ_SUBSCRIBE, "C1", 2);
+    assert (rc == 0);
+    rc = zmq_setsockopt (sub, ZMQ_SUBSCRIBE, "B2", 2);
+    assert (rc == 0);
+    process_commands (pub);
+    expect (sub, "C1", true);
+    expect (sub, "body", false);
+
+    //  There's nothing more to receive.
+    char buf [32];
+    rc = zmq_recv (sub, buf, sizeof (buf), ZMQ_DONTWAIT);
+    assert (rc == -1 && errno == EAGAIN);
+
+    rc = zmq_close (sub);
+    assert (rc == 0);
+
+    rc = zmq_close (pub);
+    assert (rc == 0);
+
+    rc = zmq_term (ctx);
+    assert (rc == 0);
+
+    return 0;
+}
@@ -0,0 +1,151 @@
+/*
+    Copyright (c) 2010-2011 250bpm s.r.o.
+    Copyright (c) 2010-2011 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include "../include/zmq.h"
+
+const int key_count = 100;
+const int worker_count = 3;
+
+//  Sends one message for each key, the payload differing from round to
+//  round, and records which worker received which key.
+static void send_round (void *push, void **workers, int *owners, int round)
+{
+    for (int key = 0; key != key_count; key++) {
+        char buf [16];
+        sprintf (buf, "%02d:%d", key, round);
+        int rc = zmq_send (push, buf, strlen (buf), 0);
+        assert (rc == (int) strlen (buf));
+    }
+
+    int count = 0;
+    for (int i = 0; i != worker_count + 1; i++) {
+        while (true) {
+            char buf [16];
+            int rc = zmq_recv (workers [i], buf, sizeof (buf), ZMQ_DONTWAIT);
+            if (rc < 0) {
+                assert (errno == EAGAIN);
+                break;
+            }
+            owners [(buf [0] - '0') * 10 + buf [1] - '0'] = i;
+            count++;
+        }
+    }
+    assert (count == key_count);
+}
+
+int main (int argc, char *argv [])
+{
+    fprintf (stderr, "test_lb_key_hash running...\n");
+
+    void *ctx = zmq_init (1);
+    assert (ctx);
+
+    //  There's no key to hash in requests.
+    void *req = zmq_socket (ctx, ZMQ_REQ);
+    assert (req);
+    int strategy = ZMQ_LB_KEY_HASH;
+    int rc = zmq_setsockopt (req, ZMQ_LB_STRATEGY, &strategy,
+        sizeof (strategy));
+    assert (rc == -1 && errno == EINVAL);
+    rc = zmq_close (req);
+    assert (rc == 0);
+
+    //  Workers the messages are pushed to.
+    void *workers [worker_count + 1];
+    for (int i = 0; i != worker_count + 1; i++) {
+        workers [i] = zmq_socket (ctx, ZMQ_PULL);
+        assert (workers [i]);
+        char endpoint [32];
+        sprintf (endpoint, "inproc://w%d", i);
+        rc = zmq_bind (workers [i], endpoint);
+        assert (rc == 0);
+    }
+
+    //  Two pushers connected to the workers in the opposite order. Two
+    //  leading bytes of each message are the key.
+    void *pushers [2];
+    for (int i = 0; i != 2; i++) {
+        pushers [i] = zmq_socket (ctx, ZMQ_PUSH);
+        assert (pushers [i]);
+        rc = zmq_setsockopt (pushers [i], ZMQ_LB_STRATEGY, &strategy,
+            sizeof (strategy));
+        assert (rc == 0);
+        int key_size = 2;
+        rc = zmq_setsockopt (pushers [i], ZMQ_LB_KEY_SIZE, &key_size,
+            sizeof (key_size));
+        assert (rc == 0);
+        key_size = 0;
+        size_t key_size_size = sizeof (key_size);
+        rc = zmq_getsockopt (pushers [i], ZMQ_LB_KEY_SIZE, &key_size,
+            &key_size_size);
+        assert (rc == 0);
+        assert (key_size == 2);
+        for (int j = 0; j != worker_count; j++) {
+            char endpoint [32];
+            sprintf (endpoint, "inproc://w%d", i ? worker_count - 1 - j : j);
+            rc = zmq_connect (pushers [i], endpoint);
+            assert (rc == 0);
+        }
+    }
+
+    //  The keys are spread among all the workers.
+    int owners [key_count];
+    send_round (pushers [0], workers, owners, 0);
+    int counts [worker_count] = {0};
+    for (int key = 0; key != key_count; key++)
+        counts [owners [key]]++;
+    for (int i = 0; i != worker_count; i++)
+        assert (counts [i] > 0);
+
+    //  The same keys go to the same workers.
+    int again [key_count];
+    send_round (pushers [0], workers, again, 1);
+    for (int key = 0; key != key_count; key++)
+        assert (again [key] == owners [key]);
+
+    //  The order the workers were connected in doesn't matter.
+    send_round (pushers [1], workers, again, 2);
+    for (int key = 0; key != key_count; key++)
+        assert (again [key] == owners [key]);
+
+    //  When a worker joins, only the keys it takes over are remapped.
+    rc = zmq_connect (pushers [0], "inproc://w3");
+    assert (rc == 0);
+    send_round (pushers [0], workers, again, 3);
+    for (int key = 0; key != key_count; key++)
+        assert (again [key] == owners [key] || again [key] == worker_count);
+
+    for (int i = 0; i != 2; i++) {
+        rc = zmq_close (pushers [i]);
+        assert (rc == 0);
+    }
+    for (int i = 0; i != worker_count + 1; i++) {
+        rc = zmq_close (workers [i]);
+        assert (rc == 0);
+    }
+
+    rc = zmq_term (ctx);
+    assert (rc == 0);
+
+    return 0 ;
+}
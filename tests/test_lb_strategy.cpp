@@ -0,0 +1,131 @@
+/*
+    Copyright (c) 2010-2011 250bpm s.r.o.
+    Copyright (c) 2010-2011 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <assert.h>
+#include <stdio.h>
+
+#include "testutil.hpp"
+
+//  Sends 100 messages to two peers, one of which reads the messages
+//  immediately while the other one doesn't read at all. Returns the number
+//  of messages that were sent to the idle peer.
+static int run (void *ctx, int strategy, const char *addr)
+{
+    void *push = zmq_socket (ctx, ZMQ_PUSH);
+    assert (push);
+    int hwm = 10;
+    int rc = zmq_setsockopt (push, ZMQ_SNDHWM, &hwm, sizeof (hwm));
+    assert (rc == 0);
+    rc = zmq_setsockopt (push, ZMQ_LB_STRATEGY, &strategy, sizeof (strategy));
+    assert (rc == 0);
+    rc = zmq_bind (push, addr);
+    assert (rc == 0);
+
+    void *busy = zmq_socket (ctx, ZMQ_PULL);
+    assert (busy);
+    rc = zmq_setsockopt (busy, ZMQ_RCVHWM, &hwm, sizeof (hwm));
+    assert (rc == 0);
+    rc = zmq_connect (busy, addr);
+    assert (rc == 0);
+
+    void *idle = zmq_socket (ctx, ZMQ_PULL);
+    assert (idle);
+    rc = zmq_setsockopt (idle, ZMQ_RCVHWM, &hwm, sizeof (hwm));
+    assert (rc == 0);
+    rc = zmq_connect (idle, addr);
+    assert (rc == 0);
+
+    int busy_count = 0;
+    for (int i = 0; i != 100; i++) {
+        rc = zmq_send (push, NULL, 0, 0);
+        assert (rc == 0);
+        while (zmq_recv (busy, NULL, 0, ZMQ_DONTWAIT) == 0)
+            busy_count++;
+
+        //  Make the sender process the read confirmations.
+        int events;
+        size_t events_size = sizeof (events);
+        rc = zmq_getsockopt (push, ZMQ_EVENTS, &events, &events_size);
+        assert (rc == 0);
+    }
+
+    int idle_count = 0;
+    while (zmq_recv (idle, NULL, 0, ZMQ_DONTWAIT) == 0)
+        idle_count++;
+    assert (busy_count + idle_count == 100);
+
+    rc = zmq_close (idle);
+    assert (rc == 0);
+    rc = zmq_close (busy);
+    assert (rc == 0);
+    rc = zmq_close (push);
+    assert (rc == 0);
+
+    return idle_count;
+}
+
+int main (int argc, char *argv [])
+{
+    fprintf (stderr, "test_lb_strategy running...\n");
+
+    void *ctx = zmq_init (1);
+    assert (ctx);
+
+    //  The option is valid for load-balancing sockets only.
+    void *pub = zmq_socket (ctx, ZMQ_PUB);
+    assert (pub);
+    int strategy = ZMQ_LB_LEAST_OUTSTANDING;
+    int rc = zmq_setsockopt (pub, ZMQ_LB_STRATEGY, &strategy,
+        sizeof (strategy));
+    assert (rc == -1 && errno == EINVAL);
+    rc = zmq_close (pub);
+    assert (rc == 0);
+
+    void *dealer = zmq_socket (ctx, ZMQ_DEALER);
+    assert (dealer);
+    rc = zmq_setsockopt (dealer, ZMQ_LB_STRATEGY, &strategy,
+        sizeof (strategy));
+    assert (rc == 0);
+    strategy = -1;
+    size_t strategy_size = sizeof (strategy);
+    rc = zmq_getsockopt (dealer, ZMQ_LB_STRATEGY, &strategy, &strategy_size);
+    assert (rc == 0);
+    assert (strategy == ZMQ_LB_LEAST_OUTSTANDING);
+    strategy = 3;
+    rc = zmq_setsockopt (dealer, ZMQ_LB_STRATEGY, &strategy,
+        sizeof (strategy));
+    assert (rc == -1 && errno == EINVAL);
+    rc = zmq_close (dealer);
+    assert (rc == 0);
+
+    //  Round-robin fills the idle peer's queue up to the high watermark,
+    //  while least-outstanding strategy sends it at most as many messages
+    //  as the busy peer reads before confirming them.
+    int round_robin = run (ctx, ZMQ_LB_ROUND_ROBIN, "inproc://a");
+    int least_outstanding = run (ctx, ZMQ_LB_LEAST_OUTSTANDING,
+        "inproc://b");
+    assert (least_outstanding <= 10);
+    assert (round_robin > least_outstanding);
+
+    rc = zmq_term (ctx);
+    assert (rc == 0);
+
+    return 0 ;
+}
@@ -0,0 +1,119 @@
+/*
+    Copyright (c) 2010-2011 250bpm s.r.o.
+    Copyright (c) 2010-2011 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "testutil.hpp"
+#include "../src/stdint.hpp"
+
+static int64_t memory_used (void *ctx)
+{
+    int64_t used;
+    size_t used_size = sizeof (used);
+    int rc = zmq_ctx_get (ctx, ZMQ_CTX_MEMORY_USED, &used, &used_size);
+    assert (rc == 0);
+    return used;
+}
+
+int main (int argc, char *argv [])
+{
+    fprintf (stderr, "test_memory_budget running...\n");
+
+    void *ctx = zmq_init (1);
+    assert (ctx);
+
+    int64_t limit = -1;
+    int rc = zmq_ctx_set (ctx, ZMQ_CTX_MEMORY_LIMIT, &limit, sizeof (limit));
+    assert (rc == -1 && errno == EINVAL);
+    limit = 64000;
+    rc = zmq_ctx_set (ctx, ZMQ_CTX_MEMORY_LIMIT, &limit, sizeof (limit));
+    assert (rc == 0);
+    limit = 0;
+    size_t limit_size = sizeof (limit);
+    rc = zmq_ctx_get (ctx, ZMQ_CTX_MEMORY_LIMIT, &limit, &limit_size);
+    assert (rc == 0);
+    assert (limit == 64000);
+
+    //  Two independent connections with no per-pipe limits.
+    void *sockets [4];
+    for (int i = 0; i != 4; i++) {
+        sockets [i] = zmq_socket (ctx, i % 2 ? ZMQ_PULL : ZMQ_PUSH);
+        assert (sockets [i]);
+        int hwm = 0;
+        rc = zmq_setsockopt (sockets [i], i % 2 ? ZMQ_RCVHWM : ZMQ_SNDHWM,
+            &hwm, sizeof (hwm));
+        assert (rc == 0);
+    }
+    rc = zmq_bind (sockets [1], "inproc://a");
+    assert (rc == 0);
+    rc = zmq_connect (sockets [0], "inproc://a");
+    assert (rc == 0);
+    rc = zmq_bind (sockets [3], "inproc://b");
+    assert (rc == 0);
+    rc = zmq_connect (sockets [2], "inproc://b");
+    assert (rc == 0);
+
+    //  Fill in the budget using the first connection.
+    char buf [1000];
+    memset (buf, 0, sizeof (buf));
+    int count = 0;
+    while (zmq_send (sockets [0], buf, sizeof (buf), ZMQ_DONTWAIT) ==
+          sizeof (buf))
+        count++;
+    assert (errno == EAGAIN);
+    assert (count > 50 && count < 70);
+    assert (memory_used (ctx) >= 64000);
+
+    //  The budget is shared by the whole context. Still, a connection that
+    //  has no messages in flight is allowed to pass a single message.
+    rc = zmq_send (sockets [2], buf, sizeof (buf), ZMQ_DONTWAIT);
+    assert (rc == sizeof (buf));
+    rc = zmq_send (sockets [2], buf, sizeof (buf), ZMQ_DONTWAIT);
+    assert (rc == -1 && errno == EAGAIN);
+
+    //  Reading the messages releases the memory.
+    for (int i = 0; i != count; i++) {
+        rc = zmq_recv (sockets [1], buf, sizeof (buf), 0);
+        assert (rc == sizeof (buf));
+    }
+    rc = zmq_recv (sockets [3], buf, sizeof (buf), 0);
+    assert (rc == sizeof (buf));
+    assert (memory_used (ctx) == 0);
+
+    //  Once the reader drains the pipe, the writer can go on.
+    rc = zmq_recv (sockets [1], buf, sizeof (buf), ZMQ_DONTWAIT);
+    assert (rc == -1 && errno == EAGAIN);
+    rc = zmq_send (sockets [0], buf, sizeof (buf), 0);
+    assert (rc == sizeof (buf));
+    rc = zmq_send (sockets [0], buf, sizeof (buf), 0);
+    assert (rc == sizeof (buf));
+
+    for (int i = 0; i != 4; i++) {
+        rc = zmq_close (sockets [i]);
+        assert (rc == 0);
+    }
+
+    rc = zmq_term (ctx);
+    assert (rc == 0);
+
+    return 0 ;
+}
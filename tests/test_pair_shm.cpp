@@ -0,0 +1,158 @@
+/*
+    Copyright (c) 2009-2011 250bpm s.r.o.
+    Copyright (c) 2007-2011 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include "testutil.hpp"
+#include "../src/platform.hpp"
+
+#if defined ZMQ_HAVE_LINUX
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include "../src/shm_ring.hpp"
+#endif
+
+int main (int argc, char *argv [])
+{
+    fprintf (stderr, "test_pair_shm running...\n");
+
+    void *ctx = zmq_init (1);
+    assert (ctx);
+
+    void *sb = zmq_socket (ctx, ZMQ_PAIR);
+    assert (sb);
+    int rc = zmq_bind (sb, "shm:///tmp/tester-shm");
+
+#if !defined ZMQ_HAVE_LINUX
+    //  Shared memory transport is not available on this platform.
+    assert (rc == -1 && errno == EPROTONOSUPPORT);
+#else
+    assert (rc == 0);
+
+    char endpoint [256];
+    size_t endpoint_size = sizeof (endpoint);
+    rc = zmq_getsockopt (sb, ZMQ_LAST_ENDPOINT, endpoint, &endpoint_size);
+    assert (rc == 0);
+    assert (strcmp (endpoint, "shm:///tmp/tester-shm") == 0);
+
+    void *sc = zmq_socket (ctx, ZMQ_PAIR);
+    assert (sc);
+    rc = zmq_connect (sc, "shm:///tmp/tester-shm");
+    assert (rc == 0);
+
+    bounce (sb, sc);
+
+    //  Pass more data than the rings can hold at once, in both small
+    //  messages and a message larger than the ring.
+    static char buf [1024 * 1024];
+    for (int round = 0; round != 10; round++) {
+        for (int i = 0; i != 1000; i++) {
+            memset (buf, i & 0xff, 1000);
+            rc = zmq_send (sc, buf, 1000, 0);
+            assert (rc == 1000);
+        }
+        for (int i = 0; i != 1000; i++) {
+            rc = zmq_recv (sb, buf, 1000, 0);
+            assert (rc == 1000);
+            assert (buf [0] == (char) (i & 0xff) && buf [999] == buf [0]);
+        }
+    }
+    memset (buf, 'x', sizeof (buf));
+    rc = zmq_send (sc, buf, sizeof (buf), 0);
+    assert (rc == (int) sizeof (buf));
+    memset (buf, 0, sizeof (buf));
+    rc = zmq_recv (sb, buf, sizeof (buf), 0);
+    assert (rc == (int) sizeof (buf));
+    assert (buf [0] == 'x' && buf [sizeof (buf) - 1] == 'x');
+
+    bounce (sc, sb);
+
+    rc = zmq_close (sc);
+    assert (rc == 0);
+
+#if defined SYS_memfd_create
+    //  Memory which the peer could shrink is not accepted. The connection
+    //  is closed instead.
+    void *pull = zmq_socket (ctx, ZMQ_PULL);
+    assert (pull);
+    rc = zmq_bind (pull, "shm:///tmp/tester-shm-seal");
+    assert (rc == 0);
+    int fd = socket (AF_UNIX, SOCK_STREAM, 0);
+    assert (fd != -1);
+    struct sockaddr_un addr;
+    memset (&addr, 0, sizeof (addr));
+    addr.sun_family = AF_UNIX;
+    strcpy (addr.sun_path, "/tmp/tester-shm-seal");
+    rc = connect (fd, (struct sockaddr*) &addr, sizeof (addr));
+    assert (rc == 0);
+    struct timeval tv = {5, 0};
+    rc = setsockopt (fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof (tv));
+    assert (rc == 0);
+
+    int memfd = syscall (SYS_memfd_create, "tester-shm", 0);
+    assert (memfd != -1);
+    rc = ftruncate (memfd,
+        2 * zmq::shm_ring_t::footprint (zmq::shm_ring_size));
+    assert (rc == 0);
+
+    unsigned char byte = 0;
+    struct iovec iov = {&byte, 1};
+    union {
+        struct cmsghdr align;
+        unsigned char buf [CMSG_SPACE (sizeof (int))];
+    } control;
+    struct msghdr msg;
+    memset (&msg, 0, sizeof (msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof (control.buf);
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR (&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN (sizeof (int));
+    memcpy (CMSG_DATA (cmsg), &memfd, sizeof (int));
+    ssize_t nbytes = sendmsg (fd, &msg, 0);
+    assert (nbytes == 1);
+
+    nbytes = recv (fd, &byte, 1, 0);
+    assert (nbytes == 0);
+
+    rc = close (memfd);
+    assert (rc == 0);
+    rc = close (fd);
+    assert (rc == 0);
+    rc = zmq_close (pull);
+    assert (rc == 0);
+#endif
+#endif
+
+    rc = zmq_close (sb);
+    assert (rc == 0);
+
+    rc = zmq_term (ctx);
+    assert (rc == 0);
+
+    return 0 ;
+}
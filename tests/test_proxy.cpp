@@ -0,0 +1,168 @@
+/*
+    Copyright (c) 2010-2011 250bpm s.r.o.
+    Copyright (c) 2010-2011 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "../include/zmq.h"
+#include "../src/stdint.hpp"
+
+int main (int argc, char *argv [])
+{
+    fprintf (stderr, "test_proxy running...\n");
+
+    void *ctx = zmq_init (1);
+    assert (ctx);
+
+    //  Create a req/rep device running in the I/O thread.
+    void *xreq = zmq_socket (ctx, ZMQ_XREQ);
+    assert (xreq);
+    int rc = zmq_bind (xreq, "tcp://127.0.0.1:5570");
+    assert (rc == 0);
+    void *xrep = zmq_socket (ctx, ZMQ_XREP);
+    assert (xrep);
+    rc = zmq_bind (xrep, "tcp://127.0.0.1:5571");
+    assert (rc == 0);
+
+    //  Capture socket gets copies of all the messages passing the proxy.
+    void *capture = zmq_socket (ctx, ZMQ_PUB);
+    assert (capture);
+    rc = zmq_bind (capture, "inproc://capture");
+    assert (rc == 0);
+    void *monitor = zmq_socket (ctx, ZMQ_SUB);
+    assert (monitor);
+    rc = zmq_setsockopt (monitor, ZMQ_SUBSCRIBE, "", 0);
+    assert (rc == 0);
+    rc = zmq_connect (monitor, "inproc://capture");
+    assert (rc == 0);
+
+    void *proxy = zmq_proxy_start (xrep, xreq, capture);
+    assert (proxy);
+
+    //  Create a worker.
+    void *rep = zmq_socket (ctx, ZMQ_REP);
+    assert (rep);
+    rc = zmq_connect (rep, "tcp://127.0.0.1:5570");
+    assert (rc == 0);
+
+    //  Create a client.
+    void *req = zmq_socket (ctx, ZMQ_REQ);
+    assert (req);
+    rc = zmq_connect (req, "tcp://127.0.0.1:5571");
+    assert (rc == 0);
+
+    //  Send a request.
+    rc = zmq_send (req, "ABC", 3, ZMQ_SNDMORE);
+    assert (rc == 3);
+    rc = zmq_send (req, "DEF", 3, 0);
+    assert (rc == 3);
+
+    //  Pass the request through the worker.
+    char buff [3];
+    int rcvmore;
+    size_t sz = sizeof (rcvmore);
+    rc = zmq_recv (rep, buff, 3, 0);
+    assert (rc == 3);
+    assert (memcmp (buff, "ABC", 3) == 0);
+    rc = zmq_getsockopt (rep, ZMQ_RCVMORE, &rcvmore, &sz);
+    assert (rc == 0);
+    assert (rcvmore);
+    rc = zmq_recv (rep, buff, 3, 0);
+    assert (rc == 3);
+    assert (memcmp (buff, "DEF", 3) == 0);
+    rc = zmq_getsockopt (rep, ZMQ_RCVMORE, &rcvmore, &sz);
+    assert (rc == 0);
+    assert (!rcvmore);
+    rc = zmq_send (rep, "GHI", 3, 0);
+    assert (rc == 3);
+
+    //  Receive the reply.
+    rc = zmq_recv (req, buff, 3, 0);
+    assert (rc == 3);
+    assert (memcmp (buff, "GHI", 3) == 0);
+    rc = zmq_getsockopt (req, ZMQ_RCVMORE, &rcvmore, &sz);
+    assert (rc == 0);
+    assert (!rcvmore);
+
+    //  Request consists of identity, delimiter and two body parts, reply
+    //  of identity, delimiter and a single body part.
+    uint64_t value;
+    size_t valuelen = sizeof (value);
+    rc = zmq_proxy_getstat (proxy, ZMQ_PROXY_FRONTEND_MSGS, &value, &valuelen);
+    assert (rc == 0);
+    assert (value == 4);
+    rc = zmq_proxy_getstat (proxy, ZMQ_PROXY_FRONTEND_BYTES, &value,
+        &valuelen);
+    assert (rc == 0);
+    assert (value == 5 + 3 + 3);
+    rc = zmq_proxy_getstat (proxy, ZMQ_PROXY_BACKEND_MSGS, &value, &valuelen);
+    assert (rc == 0);
+    assert (value == 3);
+    rc = zmq_proxy_getstat (proxy, ZMQ_PROXY_BACKEND_BYTES, &value, &valuelen);
+    assert (rc == 0);
+    assert (value == 5 + 3);
+
+    //  Capture socket got both the request and the reply.
+    char capbuf [16];
+    int parts = 0;
+    while (parts != 7) {
+        rc = zmq_recv (monitor, capbuf, sizeof (capbuf), 0);
+        assert (rc >= 0);
+        parts++;
+    }
+    assert (rc == 3);
+    assert (memcmp (capbuf, "GHI", 3) == 0);
+
+    //  Stopping the proxy closes the proxied sockets.
+    rc = zmq_proxy_stop (proxy);
+    assert (rc == 0);
+
+    rc = zmq_close (req);
+    assert (rc == 0);
+    rc = zmq_close (rep);
+    assert (rc == 0);
+    rc = zmq_close (monitor);
+    assert (rc == 0);
+
+    rc = zmq_term (ctx);
+    assert (rc == 0);
+
+    //  Proxy is shut down when the context is terminated.
+    ctx = zmq_init (1);
+    assert (ctx);
+    void *pull = zmq_socket (ctx, ZMQ_PULL);
+    assert (pull);
+    rc = zmq_bind (pull, "inproc://front");
+    assert (rc == 0);
+    void *push = zmq_socket (ctx, ZMQ_PUSH);
+    assert (push);
+    rc = zmq_bind (push, "inproc://back");
+    assert (rc == 0);
+    proxy = zmq_proxy_start (pull, push, NULL);
+    assert (proxy);
+
+    rc = zmq_term (ctx);
+    assert (rc == 0);
+    rc = zmq_proxy_stop (proxy);
+    assert (rc == 0);
+
+    return 0 ;
+}
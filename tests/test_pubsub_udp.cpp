@@ -0,0 +1,133 @@
+/*
+    Copyright (c) 2009-2011 250bpm s.r.o.
+    Copyright (c) 2007-2011 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "../include/zmq.h"
+#include "../src/platform.hpp"
+
+int main (int argc, char *argv [])
+{
+    fprintf (stderr, "test_pubsub_udp running...\n");
+
+    void *ctx = zmq_init (1);
+    assert (ctx);
+
+    void *sub = zmq_socket (ctx, ZMQ_SUB);
+    assert (sub);
+    int rc = zmq_bind (sub, "udp://127.0.0.1:5595");
+
+#if !defined ZMQ_HAVE_LINUX
+    //  UDP transport is not available on this platform.
+    assert (rc == -1 && errno == EPROTONOSUPPORT);
+#else
+    assert (rc == 0);
+    rc = zmq_setsockopt (sub, ZMQ_SUBSCRIBE, "A", 1);
+    assert (rc == 0);
+
+    //  UDP is available for PUB/SUB only.
+    void *req = zmq_socket (ctx, ZMQ_REQ);
+    assert (req);
+    rc = zmq_connect (req, "udp://127.0.0.1:5595");
+    assert (rc == -1 && errno == ENOCOMPATPROTO);
+    rc = zmq_close (req);
+    assert (rc == 0);
+
+    //  Datagrams can't be sent to an unspecified port.
+    void *pub = zmq_socket (ctx, ZMQ_PUB);
+    assert (pub);
+    rc = zmq_connect (pub, "udp://127.0.0.1:*");
+    assert (rc == -1 && errno == EINVAL);
+    rc = zmq_connect (pub, "udp://127.0.0.1:5595");
+    assert (rc == 0);
+
+    //  There's no handshake. Send the messages till the first one gets
+    //  through, then drop the duplicates.
+    char buf [80000];
+    int timeout = 100;
+    rc = zmq_setsockopt (sub, ZMQ_RCVTIMEO, &timeout, sizeof (timeout));
+    assert (rc == 0);
+    int attempts;
+    for (attempts = 0; attempts != 50; attempts++) {
+        rc = zmq_send (pub, "A", 1, 0);
+        assert (rc == 1);
+        rc = zmq_recv (sub, buf, sizeof (buf), 0);
+        if (rc == 1)
+            break;
+        assert (rc == -1 && errno == EAGAIN);
+    }
+    assert (attempts != 50);
+    while (zmq_recv (sub, buf, sizeof (buf), 0) == 1)
+        ;
+
+    //  Multiple messages, including multi-part ones, get into a single
+    //  datagram. The subscription is applied by the subscriber.
+    for (int i = 0; i != 100; i++) {
+        rc = zmq_send (pub, "B", 1, 0);
+        assert (rc == 1);
+        rc = zmq_send (pub, "A", 1, ZMQ_SNDMORE);
+        assert (rc == 1);
+        rc = zmq_send (pub, &i, sizeof (i), 0);
+        assert (rc == sizeof (i));
+    }
+
+    //  Message larger than the size of the datagrams the messages are
+    //  packed into is sent in a datagram of its own. Message larger than
+    //  any datagram is dropped.
+    memset (buf, 'A', sizeof (buf));
+    rc = zmq_send (pub, buf, 10000, 0);
+    assert (rc == 10000);
+    rc = zmq_send (pub, buf, 70000, 0);
+    assert (rc == 70000);
+    rc = zmq_send (pub, "A-last", 6, 0);
+    assert (rc == 6);
+
+    int more;
+    size_t more_size = sizeof (more);
+    for (int i = 0; i != 100; i++) {
+        rc = zmq_recv (sub, buf, sizeof (buf), 0);
+        assert (rc == 1 && buf [0] == 'A');
+        rc = zmq_getsockopt (sub, ZMQ_RCVMORE, &more, &more_size);
+        assert (rc == 0 && more);
+        int seq;
+        rc = zmq_recv (sub, &seq, sizeof (seq), 0);
+        assert (rc == sizeof (seq) && seq == i);
+        rc = zmq_getsockopt (sub, ZMQ_RCVMORE, &more, &more_size);
+        assert (rc == 0 && !more);
+    }
+    rc = zmq_recv (sub, buf, sizeof (buf), 0);
+    assert (rc == 10000 && buf [9999] == 'A');
+    rc = zmq_recv (sub, buf, sizeof (buf), 0);
+    assert (rc == 6 && memcmp (buf, "A-last", 6) == 0);
+
+    rc = zmq_close (pub);
+    assert (rc == 0);
+#endif
+
+    rc = zmq_close (sub);
+    assert (rc == 0);
+
+    rc = zmq_term (ctx);
+    assert (rc == 0);
+
+    return 0 ;
+}
@@ -0,0 +1,183 @@
+/*
+    Copyright (c) 2010-2011 250bpm s.r.o.
+    Copyright (c) 2010-2011 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "testutil.hpp"
+
+//  Appends (un)subscription to the batch. Returns new size of the batch.
+static size_t add (unsigned char *batch, size_t size, unsigned char cmd,
+    const char *topic)
+{
+    size_t len = strlen (topic);
+    batch [size] = cmd;
+    batch [size + 1] = 0;
+    batch [size + 2] = 0;
+    batch [size + 3] = 0;
+    batch [size + 4] = (unsigned char) len;
+    memcpy (batch + size + 5, topic, len);
+    return size + 5 + len;
+}
+
+int main (int argc, char *argv [])
+{
+    fprintf (stderr, "test_sub_batch running...\n");
+
+    void *ctx = zmq_init (1);
+    assert (ctx);
+
+    void *xpub = zmq_socket (ctx, ZMQ_XPUB);
+    assert (xpub);
+    int rc = zmq_bind (xpub, "inproc://a");
+    assert (rc == 0);
+
+    //  Batching is available to subscribers only.
+    int batching = 1;
+    rc = zmq_setsockopt (xpub, ZMQ_SUBSCRIPTION_BATCH, &batching,
+        sizeof (batching));
+    assert (rc == -1 && errno == EINVAL);
+
+    //  Subscribe for lots of topics before connecting.
+    void *sub = zmq_socket (ctx, ZMQ_SUB);
+    assert (sub);
+    batching = 0;
+    size_t batching_size = sizeof (batching);
+    rc = zmq_getsockopt (sub, ZMQ_SUBSCRIPTION_BATCH, &batching,
+        &batching_size);
+    assert (rc == 0 && batching == 0);
+    batching = 1;
+    rc = zmq_setsockopt (sub, ZMQ_SUBSCRIPTION_BATCH, &batching,
+        sizeof (batching));
+    assert (rc == 0);
+    char topic [16];
+    for (int i = 0; i != 1000; i++) {
+        sprintf (topic, "topic%04d", i);
+        rc = zmq_setsockopt (sub, ZMQ_SUBSCRIBE, topic, strlen (topic));
+        assert (rc == 0);
+    }
+    rc = zmq_connect (sub, "inproc://a");
+    assert (rc == 0);
+
+    //  The subscriptions should arrive in a few large batches.
+    static unsigned char buf [65536];
+    int messages = 0;
+    int subscriptions = 0;
+    while (subscriptions < 1000) {
+        rc = zmq_recv (xpub, buf, sizeof (buf), 0);
+        assert (rc > 0 && rc < (int) sizeof (buf));
+        assert (buf [0] == 2);
+        messages++;
+        for (int pos = 1; pos != rc; pos += 5 + buf [pos + 4]) {
+            assert (buf [pos] == 1);
+            subscriptions++;
+        }
+    }
+    assert (subscriptions == 1000);
+    assert (messages < 10);
+
+    //  Messages are delivered as usual.
+    rc = zmq_send (xpub, "topic0500", 9, 0);
+    assert (rc == 9);
+    rc = zmq_recv (sub, buf, sizeof (buf), 0);
+    assert (rc == 9);
+    assert (memcmp (buf, "topic0500", 9) == 0);
+
+    //  Batch sent by the user is applied by XSUB and only the changes
+    //  are forwarded upstream.
+    void *xsub = zmq_socket (ctx, ZMQ_XSUB);
+    assert (xsub);
+    rc = zmq_setsockopt (xsub, ZMQ_SUBSCRIPTION_BATCH, &batching,
+        sizeof (batching));
+    assert (rc == 0);
+    rc = zmq_connect (xsub, "inproc://a");
+    assert (rc == 0);
+
+    unsigned char batch [64];
+    size_t size = 1;
+    batch [0] = 2;
+    size = add (batch, size, 1, "a");
+    size = add (batch, size, 1, "b");
+    rc = zmq_send (xsub, batch, size, 0);
+    assert (rc == (int) size);
+    rc = zmq_recv (xpub, buf, sizeof (buf), 0);
+    assert (rc == (int) size);
+    assert (memcmp (buf, batch, size) == 0);
+
+    size = 1;
+    size = add (batch, size, 1, "a");
+    size = add (batch, size, 0, "b");
+    size = add (batch, size, 1, "c");
+    rc = zmq_send (xsub, batch, size, 0);
+    assert (rc == (int) size);
+
+    unsigned char expected [64];
+    size_t expected_size = 1;
+    expected [0] = 2;
+    expected_size = add (expected, expected_size, 0, "b");
+    expected_size = add (expected, expected_size, 1, "c");
+    rc = zmq_recv (xpub, buf, sizeof (buf), 0);
+    assert (rc == (int) expected_size);
+    assert (memcmp (buf, expected, expected_size) == 0);
+
+    //  Malformed batch is rejected.
+    batch [4] = 100;
+    rc = zmq_send (xsub, batch, size, 0);
+    assert (rc == -1 && errno == EINVAL);
+
+    //  By default, the subscriptions are sent upstream one by one, even
+    //  those supplied in a batch by the user.
+    void *plain = zmq_socket (ctx, ZMQ_XSUB);
+    assert (plain);
+    rc = zmq_send (plain, "\1x", 2, 0);
+    assert (rc == 2);
+    rc = zmq_connect (plain, "inproc://a");
+    assert (rc == 0);
+    rc = zmq_recv (xpub, buf, sizeof (buf), 0);
+    assert (rc == 2 && memcmp (buf, "\1x", 2) == 0);
+
+    size = 1;
+    size = add (batch, size, 1, "y");
+    size = add (batch, size, 1, "z");
+    rc = zmq_send (plain, batch, size, 0);
+    assert (rc == (int) size);
+    rc = zmq_recv (xpub, buf, sizeof (buf), 0);
+    assert (rc == 2 && memcmp (buf, "\1y", 2) == 0);
+    rc = zmq_recv (xpub, buf, sizeof (buf), 0);
+    assert (rc == 2 && memcmp (buf, "\1z", 2) == 0);
+
+    rc = zmq_close (plain);
+    assert (rc == 0);
+
+    rc = zmq_close (xsub);
+    assert (rc == 0);
+
+    rc = zmq_close (sub);
+    assert (rc == 0);
+
+    rc = zmq_close (xpub);
+    assert (rc == 0);
+
+    rc = zmq_term (ctx);
+    assert (rc == 0);
+
+    return 0;
+}
@@ -0,0 +1,178 @@
+/*
+    Copyright (c) 2009-2011 250bpm s.r.o.
+    Copyright (c) 2007-2011 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "testutil.hpp"
+#include "../include/zmq_utils.h"
+#include "../src/stdint.hpp"
+
+int main (int argc, char *argv [])
+{
+    fprintf (stderr, "test_swap running...\n");
+
+    void *ctx = zmq_init (1);
+    assert (ctx);
+
+    //  Create pair of sockets with the total buffer space of 10 messages.
+    //  The messages beyond that are spooled to disk, up to 1000 bytes.
+    void *sb = zmq_socket (ctx, ZMQ_PULL);
+    assert (sb);
+    int hwm = 5;
+    int rc = zmq_setsockopt (sb, ZMQ_RCVHWM, &hwm, sizeof (hwm));
+    assert (rc == 0);
+    rc = zmq_bind (sb, "inproc://a");
+    assert (rc == 0);
+
+    void *sc = zmq_socket (ctx, ZMQ_PUSH);
+    assert (sc);
+    rc = zmq_setsockopt (sc, ZMQ_SNDHWM, &hwm, sizeof (hwm));
+    assert (rc == 0);
+    int64_t swap = -1;
+    rc = zmq_setsockopt (sc, ZMQ_SWAP, &swap, sizeof (swap));
+    assert (rc == -1 && errno == EINVAL);
+    swap = 1000;
+    rc = zmq_setsockopt (sc, ZMQ_SWAP, &swap, sizeof (swap));
+    assert (rc == 0);
+    swap = 0;
+    size_t swap_size = sizeof (swap);
+    rc = zmq_getsockopt (sc, ZMQ_SWAP, &swap, &swap_size);
+    assert (rc == 0);
+    assert (swap == 1000);
+    rc = zmq_connect (sc, "inproc://a");
+    assert (rc == 0);
+
+    //  Each 10-byte message takes 19 bytes in the spool. Thus 10 messages
+    //  fit into the pipe and 53 more into the spool.
+    char buf [10];
+    memset (buf, 0, sizeof (buf));
+    int sent = 0;
+    while (true) {
+        memcpy (buf, &sent, sizeof (sent));
+        rc = zmq_send (sc, buf, sizeof (buf), ZMQ_DONTWAIT);
+        if (rc < 0) {
+            assert (errno == EAGAIN);
+            break;
+        }
+        assert (rc == sizeof (buf));
+        sent++;
+    }
+    assert (sent == 63);
+
+    //  Messages are received in the order they were sent.
+    for (int i = 0; i != sent; i++) {
+        rc = zmq_recv (sb, buf, sizeof (buf), ZMQ_DONTWAIT);
+        assert (rc == sizeof (buf));
+        int seq;
+        memcpy (&seq, buf, sizeof (seq));
+        assert (seq == i);
+    }
+
+    //  Fill in the pipe again and spool a multi-part message.
+    for (int i = 0; i != 10; i++) {
+        rc = zmq_send (sc, "A", 1, 0);
+        assert (rc == 1);
+    }
+    rc = zmq_send (sc, "B", 1, ZMQ_DONTWAIT | ZMQ_SNDMORE);
+    assert (rc == 1);
+    rc = zmq_send (sc, "CD", 2, ZMQ_DONTWAIT);
+    assert (rc == 2);
+
+    for (int i = 0; i != 10; i++) {
+        rc = zmq_recv (sb, buf, sizeof (buf), ZMQ_DONTWAIT);
+        assert (rc == 1 && buf [0] == 'A');
+    }
+    rc = zmq_recv (sb, buf, sizeof (buf), ZMQ_DONTWAIT);
+    assert (rc == 1 && buf [0] == 'B');
+    int more;
+    size_t more_size = sizeof (more);
+    rc = zmq_getsockopt (sb, ZMQ_RCVMORE, &more, &more_size);
+    assert (rc == 0 && more);
+    rc = zmq_recv (sb, buf, sizeof (buf), ZMQ_DONTWAIT);
+    assert (rc == 2 && memcmp (buf, "CD", 2) == 0);
+    rc = zmq_getsockopt (sb, ZMQ_RCVMORE, &more, &more_size);
+    assert (rc == 0 && !more);
+
+    rc = zmq_close (sc);
+    assert (rc == 0);
+
+    rc = zmq_close (sb);
+    assert (rc == 0);
+
+    //  Sender that goes idle once the messages are spooled.
+    sb = zmq_socket (ctx, ZMQ_PULL);
+    assert (sb);
+    rc = zmq_setsockopt (sb, ZMQ_RCVHWM, &hwm, sizeof (hwm));
+    assert (rc == 0);
+    int timeout = 1000;
+    rc = zmq_setsockopt (sb, ZMQ_RCVTIMEO, &timeout, sizeof (timeout));
+    assert (rc == 0);
+    rc = zmq_bind (sb, "tcp://127.0.0.1:5584");
+    assert (rc == 0);
+
+    sc = zmq_socket (ctx, ZMQ_PUSH);
+    assert (sc);
+    rc = zmq_setsockopt (sc, ZMQ_SNDHWM, &hwm, sizeof (hwm));
+    assert (rc == 0);
+    swap = 100000;
+    rc = zmq_setsockopt (sc, ZMQ_SWAP, &swap, sizeof (swap));
+    assert (rc == 0);
+    rc = zmq_connect (sc, "tcp://127.0.0.1:5584");
+    assert (rc == 0);
+    zmq_sleep (1);
+
+    for (int i = 0; i != 1000; i++) {
+        rc = zmq_send (sc, &i, sizeof (i), ZMQ_DONTWAIT);
+        assert (rc == sizeof (i));
+    }
+
+    //  All the messages arrive without the sender being used again.
+    for (int i = 0; i != 1000; i++) {
+        int seq;
+        rc = zmq_recv (sb, &seq, sizeof (seq), 0);
+        assert (rc == sizeof (seq));
+        assert (seq == i);
+    }
+
+    //  Spooled messages are delivered after the sender is closed.
+    for (int i = 0; i != 1000; i++) {
+        rc = zmq_send (sc, &i, sizeof (i), ZMQ_DONTWAIT);
+        assert (rc == sizeof (i));
+    }
+    rc = zmq_close (sc);
+    assert (rc == 0);
+
+    for (int i = 0; i != 1000; i++) {
+        int seq;
+        rc = zmq_recv (sb, &seq, sizeof (seq), 0);
+        assert (rc == sizeof (seq));
+        assert (seq == i);
+    }
+
+    rc = zmq_close (sb);
+    assert (rc == 0);
+
+    rc = zmq_term (ctx);
+    assert (rc == 0);
+
+    return 0;
+}
@@ -0,0 +1,117 @@
+/*
+    Copyright (c) 2009-2011 250bpm s.r.o.
+    Copyright (c) 2007-2011 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "testutil.hpp"
+#include "../include/zmq_utils.h"
+#include "../src/stdint.hpp"
+
+//  Sends messages "1" to "5", waits till they expire and sends "6". Only
+//  the last message should be received.
+static void send_and_expire (void *sender_, void *receiver_, void *counter_)
+{
+    char buf [2];
+    for (int i = 1; i != 6; i++) {
+        buf [0] = '0' + i;
+        int rc = zmq_send (sender_, buf, 1, 0);
+        assert (rc == 1);
+    }
+    zmq_sleep (1);
+    int rc = zmq_send (sender_, "6", 1, 0);
+    assert (rc == 1);
+
+    rc = zmq_recv (receiver_, buf, sizeof (buf), 0);
+    assert (rc == 1);
+    assert (buf [0] == '6');
+
+    uint64_t expired = 0;
+    size_t expired_size = sizeof (expired);
+    rc = zmq_getsockopt (counter_, ZMQ_EXPIRED, &expired, &expired_size);
+    assert (rc == 0);
+    assert (expired == 5);
+}
+
+int main (int argc, char *argv [])
+{
+    fprintf (stderr, "test_ttl running...\n");
+
+    void *ctx = zmq_init (1);
+    assert (ctx);
+
+    //  Messages sent over inproc are stamped with the TTL of the sender
+    //  and accounted to it when they expire.
+    void *sb = zmq_socket (ctx, ZMQ_PULL);
+    assert (sb);
+    int rc = zmq_bind (sb, "inproc://a");
+    assert (rc == 0);
+
+    void *sc = zmq_socket (ctx, ZMQ_PUSH);
+    assert (sc);
+    int ttl = -1;
+    rc = zmq_setsockopt (sc, ZMQ_TTL, &ttl, sizeof (ttl));
+    assert (rc == -1 && errno == EINVAL);
+    ttl = 100;
+    rc = zmq_setsockopt (sc, ZMQ_TTL, &ttl, sizeof (ttl));
+    assert (rc == 0);
+    ttl = 0;
+    size_t ttl_size = sizeof (ttl);
+    rc = zmq_getsockopt (sc, ZMQ_TTL, &ttl, &ttl_size);
+    assert (rc == 0);
+    assert (ttl == 100);
+    rc = zmq_connect (sc, "inproc://a");
+    assert (rc == 0);
+
+    send_and_expire (sc, sb, sc);
+
+    rc = zmq_close (sc);
+    assert (rc == 0);
+    rc = zmq_close (sb);
+    assert (rc == 0);
+
+    //  Inbound messages received over TCP are stamped with the TTL of
+    //  the receiving socket.
+    sb = zmq_socket (ctx, ZMQ_PULL);
+    assert (sb);
+    ttl = 100;
+    rc = zmq_setsockopt (sb, ZMQ_TTL, &ttl, sizeof (ttl));
+    assert (rc == 0);
+    rc = zmq_bind (sb, "tcp://127.0.0.1:5580");
+    assert (rc == 0);
+
+    sc = zmq_socket (ctx, ZMQ_PUSH);
+    assert (sc);
+    rc = zmq_connect (sc, "tcp://127.0.0.1:5580");
+    assert (rc == 0);
+
+    send_and_expire (sc, sb, sb);
+
+    rc = zmq_close (sc);
+    assert (rc == 0);
+    rc = zmq_close (sb);
+    assert (rc == 0);
+
+    rc = zmq_term (ctx);
+    assert (rc == 0);
+
+    return 0;
+}
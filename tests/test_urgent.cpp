@@ -0,0 +1,183 @@
+/*
+    Copyright (c) 2009-2011 250bpm s.r.o.
+    Copyright (c) 2007-2011 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+#include "testutil.hpp"
+
+int main (int argc, char *argv [])
+{
+    fprintf (stderr, "test_urgent running...\n");
+
+    void *ctx = zmq_init (1);
+    assert (ctx);
+
+    void *sb = zmq_socket (ctx, ZMQ_PULL);
+    assert (sb);
+    int rc = zmq_bind (sb, "inproc://a");
+    assert (rc == 0);
+
+    void *sc = zmq_socket (ctx, ZMQ_PUSH);
+    assert (sc);
+    rc = zmq_connect (sc, "inproc://a");
+    assert (rc == 0);
+
+    //  Queue some bulk messages, then an urgent message and an urgent
+    //  multi-part message. The urgency is taken from the first part.
+    for (int i = 0; i != 10; i++) {
+        rc = zmq_send (sc, "B", 1, 0);
+        assert (rc == 1);
+    }
+    rc = zmq_send (sc, "U", 1, ZMQ_URGENT);
+    assert (rc == 1);
+    rc = zmq_send (sc, "V", 1, ZMQ_URGENT | ZMQ_SNDMORE);
+    assert (rc == 1);
+    rc = zmq_send (sc, "W", 1, 0);
+    assert (rc == 1);
+
+    //  Make the receiver process the commands so that it learns about the
+    //  lane for urgent messages.
+    int events;
+    size_t events_size = sizeof (events);
+    rc = zmq_getsockopt (sb, ZMQ_EVENTS, &events, &events_size);
+    assert (rc == 0);
+    assert (events & ZMQ_POLLIN);
+
+    //  Urgent messages overtake the bulk ones.
+    char buf [1];
+    int more;
+    size_t more_size = sizeof (more);
+    rc = zmq_recv (sb, buf, sizeof (buf), 0);
+    assert (rc == 1 && buf [0] == 'U');
+    rc = zmq_recv (sb, buf, sizeof (buf), 0);
+    assert (rc == 1 && buf [0] == 'V');
+    rc = zmq_getsockopt (sb, ZMQ_RCVMORE, &more, &more_size);
+    assert (rc == 0 && more);
+    rc = zmq_recv (sb, buf, sizeof (buf), 0);
+    assert (rc == 1 && buf [0] == 'W');
+    rc = zmq_getsockopt (sb, ZMQ_RCVMORE, &more, &more_size);
+    assert (rc == 0 && !more);
+
+    //  Once a bulk message is started, it is received as a whole even if
+    //  an urgent message arrives in the meantime.
+    rc = zmq_send (sc, "C", 1, ZMQ_SNDMORE);
+    assert (rc == 1);
+    rc = zmq_send (sc, "D", 1, 0);
+    assert (rc == 1);
+    for (int i = 0; i != 10; i++) {
+        rc = zmq_recv (sb, buf, sizeof (buf), 0);
+        assert (rc == 1 && buf [0] == 'B');
+    }
+    rc = zmq_recv (sb, buf, sizeof (buf), 0);
+    assert (rc == 1 && buf [0] == 'C');
+    rc = zmq_send (sc, "U", 1, ZMQ_URGENT);
+    assert (rc == 1);
+    rc = zmq_getsockopt (sb, ZMQ_EVENTS, &events, &events_size);
+    assert (rc == 0);
+    rc = zmq_recv (sb, buf, sizeof (buf), 0);
+    assert (rc == 1 && buf [0] == 'D');
+    rc = zmq_recv (sb, buf, sizeof (buf), 0);
+    assert (rc == 1 && buf [0] == 'U');
+
+    rc = zmq_close (sc);
+    assert (rc == 0);
+
+    rc = zmq_close (sb);
+    assert (rc == 0);
+
+    //  Urgent messages have an allowance of their own, so they get through
+    //  even if the queues are full of bulk messages. Keep the network
+    //  buffers small so that they fill in quickly.
+    void *pull = zmq_socket (ctx, ZMQ_PULL);
+    assert (pull);
+    int hwm = 10;
+    rc = zmq_setsockopt (pull, ZMQ_RCVHWM, &hwm, sizeof (hwm));
+    assert (rc == 0);
+    int bufsize = 65536;
+    rc = zmq_setsockopt (pull, ZMQ_RCVBUF, &bufsize, sizeof (bufsize));
+    assert (rc == 0);
+    rc = zmq_bind (pull, "tcp://127.0.0.1:5585");
+    assert (rc == 0);
+
+    void *push = zmq_socket (ctx, ZMQ_PUSH);
+    assert (push);
+    rc = zmq_setsockopt (push, ZMQ_SNDHWM, &hwm, sizeof (hwm));
+    assert (rc == 0);
+    rc = zmq_setsockopt (push, ZMQ_SNDBUF, &bufsize, sizeof (bufsize));
+    assert (rc == 0);
+    rc = zmq_connect (push, "tcp://127.0.0.1:5585");
+    assert (rc == 0);
+
+    //  Send bulk messages till the connection is saturated, i.e. till
+    //  the socket doesn't become writable for a while.
+    static char bulk [65536];
+    memset (bulk, 'B', sizeof (bulk));
+    int sent = 0;
+    while (true) {
+        rc = zmq_send (push, bulk, sizeof (bulk), ZMQ_DONTWAIT);
+        if (rc == (int) sizeof (bulk)) {
+            sent++;
+            continue;
+        }
+        assert (rc == -1 && errno == EAGAIN);
+        zmq_pollitem_t item = {push, 0, ZMQ_POLLOUT, 0};
+        rc = zmq_poll (&item, 1, 500);
+        assert (rc >= 0);
+        if (rc == 0)
+            break;
+    }
+
+    //  The bulk lane is full, yet the urgent message is accepted.
+    rc = zmq_send (push, bulk, sizeof (bulk), ZMQ_DONTWAIT);
+    assert (rc == -1 && errno == EAGAIN);
+    rc = zmq_send (push, "U", 1, ZMQ_URGENT | ZMQ_DONTWAIT);
+    assert (rc == 1);
+
+    //  The urgent message overtakes the bulk messages that have not made
+    //  it to the network yet.
+    int after = -1;
+    for (int i = 0; i != sent + 1; i++) {
+        rc = zmq_recv (pull, bulk, sizeof (bulk), 0);
+        if (rc == 1) {
+            assert (after == -1 && bulk [0] == 'U');
+            after = 0;
+        }
+        else {
+            assert (rc == (int) sizeof (bulk));
+            if (after != -1)
+                after++;
+        }
+    }
+    assert (after > 0);
+
+    rc = zmq_close (push);
+    assert (rc == 0);
+
+    rc = zmq_close (pull);
+    assert (rc == 0);
+
+    rc = zmq_term (ctx);
+    assert (rc == 0);
+
+    return 0;
+}